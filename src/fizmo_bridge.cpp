@@ -1,17 +1,23 @@
 /*
  * fizmo_bridge.cpp
  *
- * Desktop implementation of fizmo bridge using std::thread.
+ * Desktop implementation of fizmo bridge on a pthread with an explicit stack size.
  */
 
 #include "fizmo_bridge.h"
+#include "fizmo_output_ring.h"
+#include "upper_window.h"
+#include "DisplayConfig.h"
 
 #include <thread>
+#include <pthread.h>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
 
 // libfizmo headers
 extern "C" {
@@ -19,6 +25,9 @@ extern "C" {
 #include "tools/filesys.h"
 #include "tools/filesys_c.h"
 #include "tools/types.h"
+#include "interpreter/wordwrap.h"
+#include "interpreter/routine.h"
+#include "interpreter/zpu.h"
 #include "filesys_interface/filesys_interface.h"
 }
 
@@ -26,11 +35,19 @@ extern "C" {
 static const size_t OUTPUT_BUFFER_SIZE = 8192;
 static const size_t INPUT_BUFFER_SIZE = 256;
 
-// Output ring buffer
+// Screen size reported to the interpreter: the game text area of the
+// display profile, so libfizmo wraps once at the width the UI shows
+static const uint16_t SCREEN_WIDTH = DISPLAY_TEXT_COLUMNS;
+static const uint16_t SCREEN_HEIGHT = DISPLAY_TEXT_ROWS;
+
+// Output ring buffer (lock-free, fizmo thread writes, Qt thread reads)
 static uint32_t s_outputBuffer[OUTPUT_BUFFER_SIZE];
-static std::atomic<size_t> s_outputHead{0};  // Write position
-static std::atomic<size_t> s_outputTail{0};  // Read position
-static std::mutex s_outputMutex;
+static fizmo_output_ring_t s_outputRing;
+
+static_assert((OUTPUT_BUFFER_SIZE & (OUTPUT_BUFFER_SIZE - 1)) == 0,
+              "OUTPUT_BUFFER_SIZE must be a power of two");
+static_assert(sizeof(z_ucs) == sizeof(uint32_t),
+              "z_ucs strings are copied into the output ring as-is");
 
 // Input state
 static char s_inputBuffer[INPUT_BUFFER_SIZE];
@@ -41,22 +58,67 @@ static std::atomic<uint32_t> s_inputChar{0};
 static std::mutex s_inputMutex;
 static std::condition_variable s_inputCv;
 
+// Input submitted after a timed interrupt routine had already ended the
+// read: the next read returns it instead of waiting (guarded by s_inputMutex)
+static bool s_linePending = false;
+static bool s_charPending = false;
+
+// Line being typed, mirrored by fizmo_edit_*() (guarded by s_inputMutex)
+static char s_editBuffer[INPUT_BUFFER_SIZE];
+static size_t s_editLength = 0;
+static uint32_t s_editSerial = 0;   // Bumped when read_line preloads it
+
 // Status line
 static char s_statusRoom[64] = "";
 static char s_statusScore[32] = "";
 static std::mutex s_statusMutex;
 
+// Text style (interpreter thread only): set_text_style bits, the
+// fixed-pitch font bit, and the style last sent to the ring as a marker
+static uint32_t s_textStyle = 0;
+static uint32_t s_fontStyle = 0;
+static uint32_t s_streamStyle = 0;
+
+// Upper window grid (V4+ split screen) and the selected window
+static upper_window_t s_upperWindow;
+static std::mutex s_upperMutex;
+static int16_t s_currentWindow = 0;
+
+// Line wrapping at SCREEN_WIDTH (libfizmo wordwrap, interpreter thread only)
+static WORDWRAP *s_wrapper = nullptr;
+static bool s_bufferMode = true;
+
 // Interpreter state
 static std::atomic<bool> s_gameExited{false};
 static std::atomic<bool> s_running{false};
-static std::thread s_fizmoThread;
+static pthread_t s_fizmoThread;
+static bool s_threadStarted = false;
 static char s_storyPath[512] = "";
 static z_file *s_storyFile = nullptr;
 
+// Story list: the path passed to fizmo_bridge_init() may name several
+// story files separated by ';' (not ':', which MinGW's C:/... paths
+// contain); with more than one the thread waits for fizmo_select_story()
+// before opening any (guarded by s_inputMutex).
+static const size_t MAX_STORIES = 8;
+static char s_storyPaths[MAX_STORIES][512];
+static size_t s_storyCount = 0;
+static std::atomic<bool> s_waitingForStory{false};
+static int s_selectedStory = -1;
+
+// Scripted walkthrough (ZORK_WALKTHROUGH=<file>): feeds commands to read_line
+// without waiting for the UI and reports per-command response times.
+static FILE *s_walkthrough = nullptr;
+static unsigned s_walkthroughCommands = 0;
+static std::chrono::steady_clock::time_point s_walkthroughStart;
+static std::chrono::steady_clock::time_point s_commandStart;
+
 // Forward declarations
 static void fizmo_thread_func();
 static void push_output(const uint32_t *chars, size_t count);
 static void push_output_char(uint32_t ch);
+static void flush_output();
+static void stack_sample();
 
 /*
  * Screen interface implementation
@@ -73,22 +135,22 @@ static bool screen_is_status_line_available() {
     fflush(stderr);
     return true;
 }
-static bool screen_is_split_screen_available() { return false; }
+static bool screen_is_split_screen_available() { return true; }
 static bool screen_is_variable_pitch_font_default() { return false; }
 static bool screen_is_colour_available() { return false; }
 static bool screen_is_picture_displaying_available() { return false; }
-static bool screen_is_bold_face_available() { return false; }
-static bool screen_is_italic_available() { return false; }
+static bool screen_is_bold_face_available() { return true; }
+static bool screen_is_italic_available() { return true; }
 static bool screen_is_fixed_space_font_available() { return true; }
-static bool screen_is_timed_keyboard_input_available() { return false; }
-static bool screen_is_preloaded_input_available() { return false; }
+static bool screen_is_timed_keyboard_input_available() { return true; }
+static bool screen_is_preloaded_input_available() { return true; }
 static bool screen_is_character_graphics_font_availiable() { return false; }
 static bool screen_is_picture_font_availiable() { return false; }
 
-static uint16_t screen_get_screen_height_in_lines() { return 24; }
-static uint16_t screen_get_screen_width_in_characters() { return 80; }
-static uint16_t screen_get_screen_width_in_units() { return 80; }
-static uint16_t screen_get_screen_height_in_units() { return 24; }
+static uint16_t screen_get_screen_height_in_lines() { return SCREEN_HEIGHT; }
+static uint16_t screen_get_screen_width_in_characters() { return SCREEN_WIDTH; }
+static uint16_t screen_get_screen_width_in_units() { return SCREEN_WIDTH; }
+static uint16_t screen_get_screen_height_in_units() { return SCREEN_HEIGHT; }
 static uint8_t screen_get_font_width_in_units() { return 1; }
 static uint8_t screen_get_font_height_in_units() { return 1; }
 
@@ -121,9 +183,26 @@ static char** screen_get_config_option_names() {
     return nullptr;
 }
 
+// wordwrap output target: whole lines, or the pending partial line on flush
+static void wrapped_output(z_ucs *output, void *parameter) {
+    (void)parameter;
+    size_t len = 0;
+    while (output[len] != 0) {
+        len++;
+    }
+    push_output(reinterpret_cast<const uint32_t *>(output), len);
+}
+
 static void screen_link_interface_to_story(struct z_story *story) {
     (void)story;
 
+    // Wrap once here at the display width; the UI does not re-wrap
+    if (s_wrapper == nullptr) {
+        s_wrapper = wordwrap_new_wrapper(SCREEN_WIDTH, wrapped_output, nullptr,
+                                         true, 0, true, false);
+    }
+    s_bufferMode = true;
+
     // Set default savegame filename to "zork1.sav"
     // This is used as the pre-filled default when user types SAVE/RESTORE
     extern z_ucs last_savegame_filename[];
@@ -135,12 +214,30 @@ static void screen_link_interface_to_story(struct z_story *story) {
 }
 
 static void screen_reset_interface() {
-    // Clear output buffer
-    s_outputHead.store(0);
-    s_outputTail.store(0);
+    // Drop pending output; the Qt thread skips it on its next read. The
+    // wrapper's partial line goes into the ring first, so it is dropped with
+    // the rest instead of opening the new game's first line.
+    flush_output();
+    fizmo_output_ring_discard(&s_outputRing);
+
+    // The Qt thread still holds the old game's last style: reset it too
+    s_textStyle = 0;
+    s_fontStyle = 0;
+    s_streamStyle = 0;
+    push_output_char(FIZMO_OUTPUT_STYLE_MARKER);
+
+    std::lock_guard<std::mutex> lock(s_upperMutex);
+    upper_window_split(&s_upperWindow, 0);
+    upper_window_erase(&s_upperWindow);
+    s_currentWindow = 0;
 }
 
 static int screen_close_interface(z_ucs *error_message) {
+    if (s_wrapper != nullptr) {
+        wordwrap_flush_output(s_wrapper);
+        wordwrap_destroy_wrapper(s_wrapper);
+        s_wrapper = nullptr;
+    }
     if (error_message != nullptr) {
         // Push error message to output
         while (*error_message != 0) {
@@ -154,15 +251,141 @@ static int screen_close_interface(z_ucs *error_message) {
 }
 
 static void screen_set_buffer_mode(uint8_t new_buffer_mode) {
-    (void)new_buffer_mode;
+    // Unbuffered output (buffer mode 0) bypasses the wrapper
+    flush_output();
+    s_bufferMode = (new_buffer_mode != 0);
+}
+
+// Style marker into the output ring (also the wordwrap metadata callback,
+// so markers stay in place among wrapped lines)
+static void output_style_marker(void *ptr_parameter, uint32_t style) {
+    (void)ptr_parameter;
+    push_output_char(FIZMO_OUTPUT_STYLE_MARKER | style);
+}
+
+// Before lower window text, send the current style if it differs from the
+// last one sent; changes with no text between them, or made while drawing
+// the upper window, never reach the ring
+static void sync_output_style() {
+    uint32_t style = s_textStyle | s_fontStyle;
+    if (style == s_streamStyle) {
+        return;
+    }
+    s_streamStyle = style;
+    if (s_wrapper != nullptr && s_bufferMode) {
+        wordwrap_insert_metadata(s_wrapper, output_style_marker, nullptr, style);
+    } else {
+        output_style_marker(nullptr, style);
+    }
 }
 
 static void screen_z_ucs_output(z_ucs *output) {
-    // Push output to ring buffer
-    while (*output != 0) {
-        push_output_char(*output);
-        output++;
+    size_t len = 0;
+    while (output[len] != 0) {
+        len++;
+    }
+
+    if (s_currentWindow == 1) {
+        std::lock_guard<std::mutex> lock(s_upperMutex);
+        upper_window_write(&s_upperWindow, reinterpret_cast<const uint32_t *>(output), len);
+        return;
+    }
+
+    sync_output_style();
+
+    if (s_wrapper != nullptr && s_bufferMode) {
+        wordwrap_wrap_z_ucs(s_wrapper, output);
+        return;
+    }
+
+    // Push the whole string to the ring buffer in one pass
+    push_output(reinterpret_cast<const uint32_t *>(output), len);
+}
+
+/*
+ * Walkthrough helpers
+ */
+
+// Report how long the interpreter took to answer the previous command.
+static void walkthrough_mark_response() {
+    if (s_walkthroughCommands == 0) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+        now - s_commandStart).count();
+    fprintf(stderr, "[walkthrough] #%u response %lld us\n", s_walkthroughCommands, us);
+    fflush(stderr);
+}
+
+// Fetch the next scripted command. Returns false once the script is exhausted,
+// after printing the summary and falling back to interactive input.
+static bool walkthrough_next_line(char *line, size_t size) {
+    while (fgets(line, static_cast<int>(size), s_walkthrough) != nullptr) {
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if (line[0] == '#') {
+            continue;  // Comment line in the script
+        }
+        s_walkthroughCommands++;
+        s_commandStart = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    auto total = std::chrono::steady_clock::now() - s_walkthroughStart;
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(total).count();
+    fprintf(stderr, "[walkthrough] %u commands in %lld ms (%.2f ms/command)\n",
+            s_walkthroughCommands, ms,
+            s_walkthroughCommands ? static_cast<double>(ms) / s_walkthroughCommands : 0.0);
+    fizmo_log_heap_snapshot();
+    fizmo_log_stack_usage();
+    fflush(stderr);
+
+    fclose(s_walkthrough);
+    s_walkthrough = nullptr;
+    return false;
+}
+
+// Wait for input from the Qt thread (or shutdown). With a timeout the
+// thread sleeps on s_inputCv for tenth_seconds, runs the story's interrupt
+// routine and waits again; its output is flushed so it shows right away.
+// Returns false when the routine returned true (or quit) and the read ends.
+static bool wait_for_input(uint16_t tenth_seconds, uint32_t verification_routine,
+                           int *tenth_seconds_elapsed)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto ready = [] { return s_inputReady.load() || !s_running.load(); };
+    bool timed = tenth_seconds > 0 && verification_routine != 0;
+    bool received = true;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(s_inputMutex);
+            if (!timed) {
+                s_inputCv.wait(lock, ready);
+                break;
+            }
+            if (s_inputCv.wait_for(lock, std::chrono::milliseconds(tenth_seconds * 100), ready)) {
+                break;
+            }
+        }
+
+        uint16_t result = interpret_from_call(verification_routine);
+        flush_output();
+        if (result != 0 || terminate_interpreter != INTERPRETER_QUIT_NONE) {
+            received = false;
+            break;
+        }
     }
+
+    if (tenth_seconds_elapsed != nullptr) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        *tenth_seconds_elapsed = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / 100);
+    }
+    return received;
 }
 
 static int16_t screen_read_line(zscii *dest, uint16_t maximum_length,
@@ -170,33 +393,90 @@ static int16_t screen_read_line(zscii *dest, uint16_t maximum_length,
     uint8_t preloaded_input, int *tenth_seconds_elapsed,
     bool disable_command_history, bool return_on_escape)
 {
-    (void)tenth_seconds;
-    (void)verification_routine;
-    (void)preloaded_input;
-    (void)tenth_seconds_elapsed;
     (void)disable_command_history;
     (void)return_on_escape;
 
+    if (tenth_seconds_elapsed != nullptr) {
+        *tenth_seconds_elapsed = 0;
+    }
+
     fprintf(stderr, "[fizmo_bridge] read_line called, max_length=%d\n", maximum_length);
     fflush(stderr);
 
-    // Signal that we're waiting for input
-    s_waitingForInput.store(true);
-    s_inputReady.store(false);
+    stack_sample();
+    flush_output();
+
+    // Scripted walkthrough: answer from the script, echo like the UI would
+    if (s_walkthrough != nullptr) {
+        walkthrough_mark_response();
+
+        char line[INPUT_BUFFER_SIZE];
+        if (walkthrough_next_line(line, sizeof(line))) {
+            size_t len = strlen(line);
+            if (len > maximum_length) {
+                len = maximum_length;
+            }
+            push_output_char(' ');
+            for (size_t i = 0; i < len; i++) {
+                push_output_char(static_cast<uint8_t>(line[i]));
+                dest[i] = static_cast<zscii>(line[i]);
+            }
+            push_output_char('\n');
+            return static_cast<int16_t>(len);
+        }
+    }
+
+    // Preloaded characters replace the held line; without them the line
+    // the player was typing when a timed interrupt ended the last read stays
+    if (preloaded_input > 0) {
+        std::lock_guard<std::mutex> lock(s_inputMutex);
+        size_t len = preloaded_input;
+        if (len > maximum_length) {
+            len = maximum_length;
+        }
+        if (len > INPUT_BUFFER_SIZE - 1) {
+            len = INPUT_BUFFER_SIZE - 1;
+        }
+        for (size_t i = 0; i < len; i++) {
+            s_editBuffer[i] = (dest[i] < 0x80) ? static_cast<char>(dest[i]) : '?';
+        }
+        s_editLength = len;
+        s_editSerial++;
+    }
+
+    // Signal that we're waiting for input; a pending line stays ready
+    {
+        std::lock_guard<std::mutex> lock(s_inputMutex);
+        s_waitingForInput.store(true);
+        if (!s_linePending) {
+            s_inputReady.store(false);
+        }
+        s_linePending = false;
+    }
 
     fprintf(stderr, "[fizmo_bridge] read_line waiting for input...\n");
     fflush(stderr);
 
     // Wait for input
-    {
-        std::unique_lock<std::mutex> lock(s_inputMutex);
-        s_inputCv.wait(lock, []{ return s_inputReady.load() || !s_running.load(); });
-    }
+    bool received = wait_for_input(tenth_seconds, verification_routine, tenth_seconds_elapsed);
 
     fprintf(stderr, "[fizmo_bridge] read_line got input or shutdown\n");
     fflush(stderr);
 
-    s_waitingForInput.store(false);
+    // A line submitted while the interrupt routine was ending the read is
+    // kept for the next read rather than dropped
+    {
+        std::lock_guard<std::mutex> lock(s_inputMutex);
+        s_waitingForInput.store(false);
+        if (!received && s_inputReady.load()) {
+            s_linePending = true;
+        }
+    }
+
+    if (!received) {
+        // libfizmo reads -1 as "terminated by the interrupt routine"
+        return -1;
+    }
 
     if (!s_running.load()) {
         fprintf(stderr, "[fizmo_bridge] read_line: not running, returning 0\n");
@@ -222,23 +502,32 @@ static int16_t screen_read_line(zscii *dest, uint16_t maximum_length,
 static int screen_read_char(uint16_t tenth_seconds, uint32_t verification_routine,
     int *tenth_seconds_elapsed)
 {
-    (void)tenth_seconds;
-    (void)verification_routine;
-    (void)tenth_seconds_elapsed;
+    flush_output();
 
-    // Signal that we're waiting for a character
-    s_waitingForChar.store(true);
-    s_inputReady.store(false);
+    // Signal that we're waiting for a character; a pending one stays ready
+    {
+        std::lock_guard<std::mutex> lock(s_inputMutex);
+        s_waitingForChar.store(true);
+        if (!s_charPending) {
+            s_inputReady.store(false);
+        }
+        s_charPending = false;
+    }
 
     // Wait for character input
+    bool received = wait_for_input(tenth_seconds, verification_routine, tenth_seconds_elapsed);
+
+    // Keep a character that raced the interrupt routine (see read_line)
     {
-        std::unique_lock<std::mutex> lock(s_inputMutex);
-        s_inputCv.wait(lock, []{ return s_inputReady.load() || !s_running.load(); });
+        std::lock_guard<std::mutex> lock(s_inputMutex);
+        s_waitingForChar.store(false);
+        if (!received && s_inputReady.load()) {
+            s_charPending = true;
+        }
     }
 
-    s_waitingForChar.store(false);
-
-    if (!s_running.load()) {
+    // read_char stores 0 when the interrupt routine terminates it
+    if (!received || !s_running.load()) {
         return 0;
     }
 
@@ -274,20 +563,78 @@ static void screen_show_status(z_ucs *room_description, int status_line_mode,
     }
 }
 
-static void screen_set_text_style(z_style text_style) { (void)text_style; }
+static void screen_set_text_style(z_style text_style) {
+    // Roman clears; other styles combine (Z-machine 1.1, 8.7.1.1)
+    if (text_style == Z_STYLE_ROMAN) {
+        s_textStyle = 0;
+    } else {
+        s_textStyle |= static_cast<uint32_t>(text_style) &
+            (FIZMO_STYLE_REVERSE | FIZMO_STYLE_BOLD | FIZMO_STYLE_ITALIC | FIZMO_STYLE_FIXED);
+    }
+}
 static void screen_set_colour(z_colour foreground, z_colour background, int16_t window) {
     (void)foreground; (void)background; (void)window;
 }
-static void screen_set_font(z_font font_type) { (void)font_type; }
-static void screen_split_window(int16_t nof_lines) { (void)nof_lines; }
-static void screen_set_window(int16_t window_number) { (void)window_number; }
-static void screen_erase_window(int16_t window_number) { (void)window_number; }
+static void screen_set_font(z_font font_type) {
+    // The game font is fixed-pitch already; the bit only tags the text
+    if (font_type == Z_FONT_COURIER_FIXED_PITCH) {
+        s_fontStyle = FIZMO_STYLE_FIXED;
+    } else if (font_type == Z_FONT_NORMAL) {
+        s_fontStyle = 0;
+    }
+}
+static void screen_split_window(int16_t nof_lines) {
+    flush_output();
+    std::lock_guard<std::mutex> lock(s_upperMutex);
+    upper_window_split(&s_upperWindow, nof_lines > 0 ? static_cast<uint16_t>(nof_lines) : 0);
+}
+
+static void screen_set_window(int16_t window_number) {
+    // Lower window text written so far goes out before the switch
+    flush_output();
+    s_currentWindow = window_number;
+    if (window_number == 1) {
+        // Selecting the upper window homes its cursor (spec 8.7.2)
+        std::lock_guard<std::mutex> lock(s_upperMutex);
+        upper_window_set_cursor(&s_upperWindow, 1, 1);
+    }
+}
+
+static void screen_erase_window(int16_t window_number) {
+    // The lower window keeps its scrollback; only the grid is erased
+    if (window_number == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(s_upperMutex);
+    if (window_number == -1) {
+        upper_window_split(&s_upperWindow, 0);
+        s_currentWindow = 0;
+    }
+    upper_window_erase(&s_upperWindow);
+}
+
 static void screen_set_cursor(int16_t line, int16_t column, int16_t window) {
-    (void)line; (void)column; (void)window;
+    if (window == 1) {
+        std::lock_guard<std::mutex> lock(s_upperMutex);
+        upper_window_set_cursor(&s_upperWindow, line, column);
+    }
+}
+
+static uint16_t screen_get_cursor_row() {
+    return s_currentWindow == 1 ? upper_window_cursor_line(&s_upperWindow) : 1;
+}
+
+static uint16_t screen_get_cursor_column() {
+    return s_currentWindow == 1 ? upper_window_cursor_column(&s_upperWindow) : 1;
+}
+
+static void screen_erase_line_value(uint16_t start_position) {
+    (void)start_position;  // Always from the cursor (start_position 1)
+    if (s_currentWindow == 1) {
+        std::lock_guard<std::mutex> lock(s_upperMutex);
+        upper_window_erase_line(&s_upperWindow);
+    }
 }
-static uint16_t screen_get_cursor_row() { return 1; }
-static uint16_t screen_get_cursor_column() { return 1; }
-static void screen_erase_line_value(uint16_t start_position) { (void)start_position; }
 static void screen_erase_line_pixels(uint16_t start_position) { (void)start_position; }
 static void screen_output_interface_info() {}
 static bool screen_input_must_be_repeated_by_story() { return false; }  // We echo in FizmoBackend::submitCommand()
@@ -341,6 +688,7 @@ static int screen_prompt_for_filename(char *filename_suggestion, z_file **result
     }
     prompt_ucs[strlen(prompt)] = 0;
     screen_z_ucs_output(prompt_ucs);
+    flush_output();
 
     // Wait for user input (reuse the line input mechanism)
     s_waitingForInput.store(true);
@@ -458,24 +806,76 @@ static struct z_screen_interface s_screenInterface = {
  * Helper functions
  */
 
-static void push_output_char(uint32_t ch) {
-    std::lock_guard<std::mutex> lock(s_outputMutex);
+static void push_output(const uint32_t *chars, size_t count) {
+    // If the buffer is full, wait for the Qt thread to drain it rather
+    // than dropping text (give up only when shutting down)
+    while (count > 0) {
+        size_t written = fizmo_output_ring_write(&s_outputRing, chars, count);
+        chars += written;
+        count -= written;
+        if (count > 0) {
+            if (!s_running.load()) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
 
-    size_t head = s_outputHead.load();
-    size_t next_head = (head + 1) % OUTPUT_BUFFER_SIZE;
+static void push_output_char(uint32_t ch) {
+    push_output(&ch, 1);
+}
 
-    // If buffer is full, drop oldest character
-    if (next_head == s_outputTail.load()) {
-        s_outputTail.store((s_outputTail.load() + 1) % OUTPUT_BUFFER_SIZE);
+// Push the partial line held by the wrapper, so prompts show before the
+// interpreter thread blocks for input
+static void flush_output() {
+    if (s_wrapper != nullptr) {
+        wordwrap_flush_output(s_wrapper);
     }
+}
+
+/*
+ * Stack depth measurement - desktop stand-in for uxTaskGetStackHighWaterMark.
+ * The interpreter thread paints a window below its entry frame; the lowest
+ * byte that no longer holds the pattern marks the deepest use so far.
+ * Host frames are 64-bit, so the figure is an upper bound for the ARM build.
+ * Opt-in (ZORK_STACK_MONITOR=1, or any ZORK_WALKTHROUGH run), as painting
+ * costs time at every start.
+ */
 
-    s_outputBuffer[head] = ch;
-    s_outputHead.store(next_head);
+// Interpreter thread stack, set explicitly: platform defaults differ
+// (512 KB for secondary threads on macOS) and the window must fit below it
+static const size_t THREAD_STACK_BYTES = 8 * 1024 * 1024;
+static const size_t STACK_PAINT_BYTES = 512 * 1024;
+static_assert(STACK_PAINT_BYTES + 64 * 1024 < THREAD_STACK_BYTES,
+              "painted window must leave room for the thread's own frames");
+static const uint8_t STACK_PAINT_PATTERN = 0xA5;
+static uintptr_t s_stackTop = 0;        // Entry frame of the interpreter thread
+static uintptr_t s_stackPaintLow = 0;   // Lowest painted address
+static std::atomic<size_t> s_stackPeak{0};
+static bool s_stackMonitor = false;     // Set before the thread starts
+
+__attribute__((noinline)) static void stack_paint() {
+    volatile uint8_t window[STACK_PAINT_BYTES];
+    for (size_t i = 0; i < STACK_PAINT_BYTES; i++) {
+        window[i] = STACK_PAINT_PATTERN;
+    }
+    s_stackPaintLow = reinterpret_cast<uintptr_t>(&window[0]);
 }
 
-static void push_output(const uint32_t *chars, size_t count) {
-    for (size_t i = 0; i < count; i++) {
-        push_output_char(chars[i]);
+// Called on the interpreter thread only (the window is below its own SP)
+static void stack_sample() {
+    if (s_stackPaintLow == 0) {
+        return;
+    }
+    const volatile uint8_t *p = reinterpret_cast<const volatile uint8_t *>(s_stackPaintLow);
+    const volatile uint8_t *end = reinterpret_cast<const volatile uint8_t *>(s_stackTop);
+    while (p < end && *p == STACK_PAINT_PATTERN) {
+        p++;
+    }
+    size_t depth = s_stackTop - reinterpret_cast<uintptr_t>(p);
+    if (depth > s_stackPeak.load()) {
+        s_stackPeak.store(depth);
     }
 }
 
@@ -483,10 +883,20 @@ static void push_output(const uint32_t *chars, size_t count) {
  * Fizmo thread function
  */
 
+static void* fizmo_thread_entry(void *) {
+    fizmo_thread_func();
+    return nullptr;
+}
+
 static void fizmo_thread_func() {
     fprintf(stderr, "[fizmo_bridge] Thread started\n");
     fflush(stderr);
 
+    if (s_stackMonitor) {
+        s_stackTop = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+        stack_paint();
+    }
+
     // Register file system interface (standard C I/O)
     fprintf(stderr, "[fizmo_bridge] Registering filesystem interface\n");
     fflush(stderr);
@@ -502,6 +912,19 @@ static void fizmo_thread_func() {
         return;
     }
 
+    // Story picker: wait for the UI to choose (or for shutdown)
+    if (s_storyCount > 1) {
+        std::unique_lock<std::mutex> lock(s_inputMutex);
+        s_waitingForStory.store(true);
+        s_inputCv.wait(lock, [] { return s_selectedStory >= 0 || !s_running.load(); });
+        s_waitingForStory.store(false);
+        if (s_selectedStory < 0) {
+            s_gameExited.store(true);
+            return;
+        }
+        strcpy(s_storyPath, s_storyPaths[s_selectedStory]);
+    }
+
     // Open the story file
     fprintf(stderr, "[fizmo_bridge] Opening story file: %s\n", s_storyPath);
     fflush(stderr);
@@ -544,21 +967,58 @@ int fizmo_bridge_init(const char *story_path) {
         return -1;
     }
 
-    strncpy(s_storyPath, story_path, sizeof(s_storyPath) - 1);
-    s_storyPath[sizeof(s_storyPath) - 1] = '\0';
+    // Split the ';'-separated story list; the first entry is the default
+    s_storyCount = 0;
+    const char *start = story_path;
+    while (s_storyCount < MAX_STORIES) {
+        const char *end = strchr(start, ';');
+        size_t len = end != nullptr ? (size_t)(end - start) : strlen(start);
+        if (len > 0 && len < sizeof(s_storyPaths[0])) {
+            memcpy(s_storyPaths[s_storyCount], start, len);
+            s_storyPaths[s_storyCount][len] = '\0';
+            s_storyCount++;
+        }
+        if (end == nullptr) {
+            break;
+        }
+        start = end + 1;
+    }
+    if (s_storyCount == 0) {
+        return -1;
+    }
+    strcpy(s_storyPath, s_storyPaths[0]);
+    s_selectedStory = -1;
+    s_waitingForStory.store(false);
 
     // Reset state
-    s_outputHead.store(0);
-    s_outputTail.store(0);
+    fizmo_output_ring_init(&s_outputRing, s_outputBuffer, OUTPUT_BUFFER_SIZE);
+    upper_window_init(&s_upperWindow, SCREEN_WIDTH);
+    s_currentWindow = 0;
     s_inputReady.store(false);
     s_waitingForInput.store(false);
     s_waitingForChar.store(false);
+    s_linePending = false;
+    s_charPending = false;
     s_gameExited.store(false);
     s_running.store(false);
 
     // Load last used save filename from config
     load_last_filename();
 
+    // Optional scripted walkthrough for benchmarking
+    const char *walkthroughPath = getenv("ZORK_WALKTHROUGH");
+    if (walkthroughPath != nullptr && walkthroughPath[0] != '\0') {
+        s_walkthrough = fopen(walkthroughPath, "r");
+        if (s_walkthrough != nullptr) {
+            s_walkthroughCommands = 0;
+            s_walkthroughStart = std::chrono::steady_clock::now();
+            fprintf(stderr, "[fizmo_bridge] Running walkthrough: %s\n", walkthroughPath);
+        } else {
+            fprintf(stderr, "[fizmo_bridge] Cannot open walkthrough: %s\n", walkthroughPath);
+        }
+        fflush(stderr);
+    }
+
     return 0;
 }
 
@@ -567,8 +1027,24 @@ int fizmo_start_interpreter(void) {
         return -1; // Already running
     }
 
+    const char *monitorEnv = getenv("ZORK_STACK_MONITOR");
+    const char *walkthroughEnv = getenv("ZORK_WALKTHROUGH");
+    s_stackMonitor = (monitorEnv != nullptr && monitorEnv[0] != '\0' && monitorEnv[0] != '0')
+                  || (walkthroughEnv != nullptr && walkthroughEnv[0] != '\0');
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK_BYTES);
+
     s_running.store(true);
-    s_fizmoThread = std::thread(fizmo_thread_func);
+    int result = pthread_create(&s_fizmoThread, &attr, fizmo_thread_entry, nullptr);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        fprintf(stderr, "[fizmo_bridge] Cannot start interpreter thread (%d)\n", result);
+        s_running.store(false);
+        return -1;
+    }
+    s_threadStarted = true;
 
     return 0;
 }
@@ -583,32 +1059,20 @@ void fizmo_bridge_shutdown(void) {
     }
     s_inputCv.notify_all();
 
-    if (s_fizmoThread.joinable()) {
-        s_fizmoThread.join();
+    if (s_threadStarted) {
+        pthread_join(s_fizmoThread, nullptr);
+        s_threadStarted = false;
     }
+
+    fizmo_log_heap_snapshot();
 }
 
 size_t fizmo_output_available(void) {
-    size_t head = s_outputHead.load();
-    size_t tail = s_outputTail.load();
-
-    if (head >= tail) {
-        return head - tail;
-    } else {
-        return OUTPUT_BUFFER_SIZE - tail + head;
-    }
+    return fizmo_output_ring_available(&s_outputRing);
 }
 
 size_t fizmo_output_read(uint32_t *buffer, size_t max_chars) {
-    std::lock_guard<std::mutex> lock(s_outputMutex);
-
-    size_t count = 0;
-    while (count < max_chars && s_outputTail.load() != s_outputHead.load()) {
-        buffer[count++] = s_outputBuffer[s_outputTail.load()];
-        s_outputTail.store((s_outputTail.load() + 1) % OUTPUT_BUFFER_SIZE);
-    }
-
-    return count;
+    return fizmo_output_ring_read(&s_outputRing, buffer, max_chars);
 }
 
 bool fizmo_waiting_for_input(void) {
@@ -623,6 +1087,60 @@ bool fizmo_has_exited(void) {
     return s_gameExited.load();
 }
 
+uint16_t fizmo_story_count(void) {
+    return static_cast<uint16_t>(s_storyCount);
+}
+
+bool fizmo_get_story_name(uint16_t index, char *name, size_t name_size) {
+    if (index >= s_storyCount || name == nullptr || name_size == 0) {
+        return false;
+    }
+
+    // Picker name: file name without directory or extension; MinGW paths
+    // may use either separator
+    const char *path = s_storyPaths[index];
+    const char *base = path;
+    for (const char *p = path; *p != '\0'; p++) {
+        if (*p == '/' || *p == '\\') {
+            base = p + 1;
+        }
+    }
+    const char *dot = strrchr(base, '.');
+    size_t len = dot != nullptr && dot != base ? (size_t)(dot - base) : strlen(base);
+    if (len > name_size - 1) {
+        len = name_size - 1;
+    }
+    memcpy(name, base, len);
+    name[len] = '\0';
+    return true;
+}
+
+bool fizmo_waiting_for_story(void) {
+    return s_waitingForStory.load();
+}
+
+int fizmo_select_story(uint16_t index) {
+    {
+        std::lock_guard<std::mutex> lock(s_inputMutex);
+        if (!s_waitingForStory.load() || index >= s_storyCount) {
+            return -1;
+        }
+        s_selectedStory = index;
+    }
+    s_inputCv.notify_all();
+    return 0;
+}
+
+uint16_t fizmo_get_upper_window_rows(void) {
+    std::lock_guard<std::mutex> lock(s_upperMutex);
+    return s_upperWindow.rows;
+}
+
+size_t fizmo_read_upper_window_changes(upper_window_cell_t *changes, size_t max_changes) {
+    std::lock_guard<std::mutex> lock(s_upperMutex);
+    return upper_window_read_changes(&s_upperWindow, changes, max_changes);
+}
+
 bool fizmo_get_status_line(char *room, size_t room_size,
                            char *score_or_time, size_t score_size)
 {
@@ -640,20 +1158,94 @@ bool fizmo_get_status_line(char *room, size_t room_size,
 void fizmo_submit_line(const char *line) {
     {
         std::lock_guard<std::mutex> lock(s_inputMutex);
+        if (!s_waitingForInput.load()) {
+            return;     // No read to receive it
+        }
         strncpy(s_inputBuffer, line, INPUT_BUFFER_SIZE - 1);
         s_inputBuffer[INPUT_BUFFER_SIZE - 1] = '\0';
+        s_editLength = 0;
         s_inputReady.store(true);
     }
     s_inputCv.notify_all();
 }
 
+void fizmo_edit_insert(const char *text, size_t length) {
+    std::lock_guard<std::mutex> lock(s_inputMutex);
+    if (length > INPUT_BUFFER_SIZE - 1 - s_editLength) {
+        length = INPUT_BUFFER_SIZE - 1 - s_editLength;
+    }
+    memcpy(s_editBuffer + s_editLength, text, length);
+    s_editLength += length;
+}
+
+void fizmo_edit_erase(size_t count) {
+    std::lock_guard<std::mutex> lock(s_inputMutex);
+    s_editLength = (count < s_editLength) ? s_editLength - count : 0;
+}
+
+bool fizmo_get_preloaded_line(uint32_t *serial, char *line, size_t size) {
+    if (size == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s_inputMutex);
+    if (*serial == s_editSerial) {
+        return false;
+    }
+    size_t len = (s_editLength < size - 1) ? s_editLength : size - 1;
+    memcpy(line, s_editBuffer, len);
+    line[len] = '\0';
+    *serial = s_editSerial;
+    return true;
+}
+
 void fizmo_submit_char(uint32_t ch) {
     {
         std::lock_guard<std::mutex> lock(s_inputMutex);
+        if (!s_waitingForChar.load()) {
+            return;
+        }
         s_inputChar.store(ch);
         s_inputReady.store(true);
     }
     s_inputCv.notify_all();
 }
 
+size_t fizmo_get_stack_usage(fizmo_stack_usage_t *usage, size_t max_entries) {
+    if (max_entries == 0 || !s_stackMonitor) {
+        return 0;
+    }
+    usage[0].name = "Fizmo_Thread";
+    usage[0].stack_bytes = STACK_PAINT_BYTES;
+    usage[0].peak_bytes = s_stackPeak.load();
+    return 1;
+}
+
+void fizmo_log_stack_usage(void) {
+    fizmo_stack_usage_t usage;
+    if (fizmo_get_stack_usage(&usage, 1) == 1) {
+        fprintf(stderr, "[fizmo_bridge] stack %s: peak %zu bytes (of %zu monitored)\n",
+                usage.name, usage.peak_bytes, usage.stack_bytes);
+    }
+}
+
+bool fizmo_get_heap_snapshot(heap_telemetry_snapshot_t *snapshot) {
+#ifdef FIZMO_HEAP_TELEMETRY
+    return heap_telemetry_capture(snapshot);
+#else
+    (void)snapshot;
+    return false;
+#endif
+}
+
+void fizmo_log_heap_snapshot(void) {
+#ifdef FIZMO_HEAP_TELEMETRY
+    heap_telemetry_snapshot_t snapshot;
+    if (heap_telemetry_capture(&snapshot)) {
+        heap_telemetry_log(&snapshot, [](const char *line) {
+            fprintf(stderr, "[fizmo_bridge] %s\n", line);
+        });
+    }
+#endif
+}
+
 } // extern "C"
@@ -4,7 +4,7 @@
  * Bridge layer between Qt for MCUs and the fizmo Z-machine interpreter.
  * Runs fizmo in a background thread, provides thread-safe communication.
  *
- * This is the desktop implementation using std::thread.
+ * This is the desktop implementation (POSIX threads).
  * For FreeRTOS, use fizmo_rtos_bridge.h instead.
  */
 
@@ -15,12 +15,17 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "heap_telemetry.h"
+#include "upper_window.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /*
  * Initialize the fizmo bridge with a story file path.
+ * Several stories may be given separated by ';'; the interpreter thread
+ * then waits for fizmo_select_story() before opening one.
  * Must be called before fizmo_start_interpreter().
  * Returns 0 on success, -1 on error.
  */
@@ -62,11 +67,32 @@ bool fizmo_waiting_for_char(void);
 /* Returns true if the game has exited */
 bool fizmo_has_exited(void);
 
+/* Number of stories given to fizmo_bridge_init() */
+uint16_t fizmo_story_count(void);
+
+/* Copy the picker name (file name without extension) of story index.
+ * Returns false if index is out of range. */
+bool fizmo_get_story_name(uint16_t index, char *name, size_t name_size);
+
+/* Returns true while the interpreter thread waits for a story choice */
+bool fizmo_waiting_for_story(void);
+
+/* Start story index. Returns 0 on success, -1 if not waiting or out of range. */
+int fizmo_select_story(uint16_t index);
+
 /* Get current status line. Returns true if status is available.
  * room and score_or_time are output buffers. */
 bool fizmo_get_status_line(char *room, size_t room_size,
                            char *score_or_time, size_t score_size);
 
+/* Upper window of V4+ stories (see upper_window.h): height in rows,
+ * 0 when the screen is not split */
+uint16_t fizmo_get_upper_window_rows(void);
+
+/* Copy up to max_changes cells written since the last call.
+ * Returns number of cells copied. */
+size_t fizmo_read_upper_window_changes(upper_window_cell_t *changes, size_t max_changes);
+
 /*
  * Input interface - called by Qt to submit user input
  */
@@ -77,6 +103,43 @@ void fizmo_submit_line(const char *line);
 /* Submit a single character. Wakes up fizmo if it was waiting. */
 void fizmo_submit_char(uint32_t ch);
 
+/* Mirror edits of the line being typed (bytes appended / removed from the
+ * end). The bridge holds the line across timed interrupts; submit clears it. */
+void fizmo_edit_insert(const char *text, size_t length);
+void fizmo_edit_erase(size_t count);
+
+/* Copy the line read_line preloaded if it changed since *serial.
+ * Returns true (and updates *serial) when line was copied. */
+bool fizmo_get_preloaded_line(uint32_t *serial, char *line, size_t size);
+
+/*
+ * Heap telemetry (FIZMO_HEAP_TELEMETRY builds): live/peak bytes, churn,
+ * request-size histogram and the heaviest malloc call sites.
+ */
+
+/* Copy the current snapshot. Returns false if telemetry is not compiled in. */
+bool fizmo_get_heap_snapshot(heap_telemetry_snapshot_t *snapshot);
+
+/* Print the snapshot (stderr) */
+void fizmo_log_heap_snapshot(void);
+
+/*
+ * Stack monitoring: deepest stack use observed per task, sampled at every
+ * read_line and on each query (desktop: stack painting of the interpreter thread,
+ * only with ZORK_STACK_MONITOR=1 or ZORK_WALKTHROUGH; returns 0 entries otherwise).
+ */
+typedef struct {
+    const char *name;
+    size_t stack_bytes;     /* Painted window that is monitored */
+    size_t peak_bytes;      /* Deepest use observed */
+} fizmo_stack_usage_t;
+
+/* Fill up to max_entries records. Returns: number of records */
+size_t fizmo_get_stack_usage(fizmo_stack_usage_t *usage, size_t max_entries);
+
+/* Print usage and a suggested size (peak + 25%) per task (stderr) */
+void fizmo_log_stack_usage(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,22 +15,80 @@
 /* FatFS includes - adjust path as needed for your SDK */
 #include "ff.h"
 
+/* Volume is mounted and owned by sd_init.c */
+#include "sd_init.h"
+
 /* libfizmo includes */
 #include "tools/filesys.h"
 #include "tools/types.h"
 #include "filesys_interface/filesys_interface.h"
 
-/* Embedded story data */
+#ifdef FIZMO_STORY_PACK
+#include "story_blocks.h"
+#include "story_page_cache.h"
+#endif
+
+/* Embedded story catalog (tools/story_catalog.py) or a single story */
+static story_catalog_t s_catalog;
+
+/* Selected story, served as "@embedded" */
 static const uint8_t *s_story_data = NULL;
 static size_t s_story_size = 0;
 
+#ifdef FIZMO_STORY_PACK
+/*
+ * Block-compressed story (tools/story_pack.py): reads are served from a
+ * small cache of decompressed blocks, so only the blocks being read are
+ * ever expanded in RAM.
+ */
+#ifndef FIZMO_STORY_CACHE_BLOCKS
+#define FIZMO_STORY_CACHE_BLOCKS    2
+#endif
+/* Block size the story was packed with (CMake FIZMO_STORY_BLOCK_SIZE) */
+#ifndef FIZMO_STORY_BLOCK_SIZE
+#define FIZMO_STORY_BLOCK_SIZE      STORY_BLOCKS_MAX_SIZE
+#endif
+#if FIZMO_STORY_BLOCK_SIZE > STORY_BLOCKS_MAX_SIZE
+#error "FIZMO_STORY_BLOCK_SIZE exceeds STORY_BLOCKS_MAX_SIZE"
+#endif
+#define STORY_MAX_PAGES             (512 * 1024 / 1024)   /* 512 KB story, 1 KB blocks */
+
+static int s_story_packed = 0;
+static story_blocks_t s_story_blocks;
+static story_page_cache_t s_story_cache;
+static uint8_t s_story_cache_pages[FIZMO_STORY_CACHE_BLOCKS * FIZMO_STORY_BLOCK_SIZE];
+static story_page_slot_t s_story_cache_slots[FIZMO_STORY_CACHE_BLOCKS];
+static uint16_t s_story_page_map[STORY_MAX_PAGES];
+
+static int open_packed_story(const uint8_t *image, size_t image_size)
+{
+    if (story_blocks_open(&s_story_blocks, image, image_size) != 0 ||
+        story_page_map_entries(s_story_blocks.story_size, s_story_blocks.block_size) > STORY_MAX_PAGES) {
+        printf("hybrid_fs: invalid packed story image\r\n");
+        return -1;
+    }
+    if (s_story_blocks.block_size > FIZMO_STORY_BLOCK_SIZE) {
+        printf("hybrid_fs: story packed with %u B blocks, build expects %u\r\n",
+               (unsigned)s_story_blocks.block_size, (unsigned)FIZMO_STORY_BLOCK_SIZE);
+        return -1;
+    }
+    if (story_page_cache_init(&s_story_cache, story_blocks_read_page, &s_story_blocks,
+                              s_story_blocks.story_size, s_story_blocks.block_size,
+                              s_story_cache_pages, s_story_cache_slots,
+                              FIZMO_STORY_CACHE_BLOCKS, s_story_page_map) != 0) {
+        return -1;
+    }
+    printf("hybrid_fs: packed story %u -> %u bytes, %u x %u B blocks\r\n",
+           (unsigned)s_story_blocks.story_size, (unsigned)image_size,
+           (unsigned)s_story_blocks.block_count, (unsigned)s_story_blocks.block_size);
+    s_story_packed = 1;
+    return 0;
+}
+#endif
+
 /* Save file path prefix */
 static char s_save_path[64] = "";
 
-/* FatFS filesystem object */
-static FATFS s_fatfs;
-static int s_sd_mounted = 0;
-
 /*
  * File handle structure for tracking open files.
  * For embedded story: uses memory pointer
@@ -76,6 +134,9 @@ static int hybrid_read_dir(struct z_dir_ent *dir_ent, z_dir *dirref);
 static int hybrid_make_dir(char *path);
 static bool hybrid_is_filename_directory(char *filename);
 
+/* Open-file slot pool (defined with the slot table below) */
+static void init_file_slots(void);
+
 /* Filesystem interface structure */
 static struct z_filesys_interface hybrid_filesys_interface = {
     .openfile = hybrid_openfile,
@@ -117,8 +178,19 @@ int fizmo_filesys_hybrid_init(const uint8_t *story_data, size_t story_size,
         return -1;
     }
 
-    s_story_data = story_data;
-    s_story_size = story_size;
+    if (story_catalog_open(&s_catalog, story_data, story_size) != 0) {
+        printf("hybrid_fs: invalid story catalog\r\n");
+        return -1;
+    }
+    if (story_catalog_count(&s_catalog) > 1) {
+        printf("hybrid_fs: %u stories in catalog\r\n",
+               (unsigned)story_catalog_count(&s_catalog));
+    }
+    if (fizmo_filesys_select_story(0) != 0) {
+        return -1;
+    }
+
+    init_file_slots();
 
     if (save_path != NULL) {
         strncpy(s_save_path, save_path, sizeof(s_save_path) - 1);
@@ -133,59 +205,120 @@ int fizmo_filesys_hybrid_init(const uint8_t *story_data, size_t story_size,
     return 0;
 }
 
-int fizmo_filesys_mount_sd(void)
+uint16_t fizmo_filesys_story_count(void)
 {
-    if (s_sd_mounted) {
-        return 0;  /* Already mounted */
-    }
+    return story_catalog_count(&s_catalog);
+}
 
-    FRESULT res = f_mount(&s_fatfs, "", 1);  /* Mount with immediate mount */
-    if (res != FR_OK) {
+int fizmo_filesys_story_info(uint16_t index, story_catalog_entry_t *entry)
+{
+    return story_catalog_get(&s_catalog, index, entry);
+}
+
+int fizmo_filesys_select_story(uint16_t index)
+{
+    story_catalog_entry_t entry;
+    if (story_catalog_get(&s_catalog, index, &entry) != 0) {
         return -1;
     }
 
-    /* Ensure saves directory exists (f_mkdir fails silently if it already exists) */
-    f_mkdir("/saves");
+#ifdef FIZMO_STORY_PACK
+    s_story_packed = 0;
+    if (entry.flags & STORY_CATALOG_FLAG_PACKED) {
+        if (open_packed_story(entry.data, entry.size) != 0) {
+            return -1;
+        }
+        s_story_data = entry.data;
+        s_story_size = s_story_blocks.story_size;
+        return 0;
+    }
+#else
+    if (entry.flags & STORY_CATALOG_FLAG_PACKED) {
+        printf("hybrid_fs: story %s is packed, build with FIZMO_STORY_PACK\r\n", entry.name);
+        return -1;
+    }
+#endif
 
-    s_sd_mounted = 1;
+    s_story_data = entry.data;
+    s_story_size = entry.size;
     return 0;
 }
 
-int fizmo_filesys_unmount_sd(void)
+int fizmo_filesys_mount_sd(void)
 {
-    if (!s_sd_mounted) {
-        return 0;
-    }
+    return sd_filesystem_init() == 0 ? 0 : -1;
+}
 
-    f_mount(NULL, "", 0);  /* Unmount */
-    s_sd_mounted = 0;
+int fizmo_filesys_unmount_sd(void)
+{
+    sd_filesystem_deinit();
     return 0;
 }
 
 int fizmo_filesys_sd_available(void)
 {
-    return s_sd_mounted;
+    return sd_filesystem_available();
 }
 
 /*
- * Helper: allocate and initialize a z_file structure
+ * File slot table: z_file, hybrid_file_t and the filename live together in
+ * one preallocated slot, so opening and closing a file never touches the
+ * heap. Free slots are kept on a singly linked list for O(1) open/close.
+ */
+#ifndef FIZMO_MAX_OPEN_FILES
+#define FIZMO_MAX_OPEN_FILES    4   /* Story + save/restore + lastfn + spare */
+#endif
+#define FIZMO_MAX_FILENAME      64
+
+typedef struct file_slot {
+    z_file zf;                  /* Must stay first: free_zfile() casts back */
+    hybrid_file_t hf;
+    char filename[FIZMO_MAX_FILENAME];
+    struct file_slot *next_free;
+} file_slot_t;
+
+static file_slot_t s_file_slots[FIZMO_MAX_OPEN_FILES];
+static file_slot_t *s_free_slots = NULL;
+
+static void init_file_slots(void)
+{
+    s_free_slots = NULL;
+    for (int i = FIZMO_MAX_OPEN_FILES - 1; i >= 0; i--) {
+        s_file_slots[i].next_free = s_free_slots;
+        s_free_slots = &s_file_slots[i];
+    }
+}
+
+/*
+ * Helper: take a file slot and initialize its z_file, with the slot's
+ * hybrid_file_t as zf->file_object
  */
 static z_file* alloc_zfile(const char *filename, int filetype, int fileaccess)
 {
-    z_file *zf = pvPortMalloc(sizeof(z_file));
-    if (zf == NULL) {
+    if (filename != NULL && strlen(filename) >= FIZMO_MAX_FILENAME) {
+        printf("hybrid_fs: filename too long (max %d): %s\r\n",
+               FIZMO_MAX_FILENAME - 1, filename);
         return NULL;
     }
 
+    file_slot_t *slot = s_free_slots;
+    if (slot == NULL) {
+        printf("hybrid_fs: all %d file slots in use, cannot open %s\r\n",
+               FIZMO_MAX_OPEN_FILES, filename != NULL ? filename : "(null)");
+        return NULL;
+    }
+    s_free_slots = slot->next_free;
+
+    z_file *zf = &slot->zf;
     memset(zf, 0, sizeof(z_file));
+    memset(&slot->hf, 0, sizeof(hybrid_file_t));
+    slot->next_free = NULL;
 
     if (filename != NULL) {
-        zf->filename = pvPortMalloc(strlen(filename) + 1);
-        if (zf->filename != NULL) {
-            strcpy(zf->filename, filename);
-        }
+        strcpy(slot->filename, filename);
+        zf->filename = slot->filename;
     }
-
+    zf->file_object = &slot->hf;
     zf->filetype = filetype;
     zf->fileaccess = fileaccess;
 
@@ -193,7 +326,7 @@ static z_file* alloc_zfile(const char *filename, int filetype, int fileaccess)
 }
 
 /*
- * Helper: free a z_file structure
+ * Helper: return a z_file's slot to the free list
  */
 static void free_zfile(z_file *zf)
 {
@@ -201,15 +334,12 @@ static void free_zfile(z_file *zf)
         return;
     }
 
-    if (zf->file_object != NULL) {
-        vPortFree(zf->file_object);
-    }
-
-    if (zf->filename != NULL) {
-        vPortFree(zf->filename);
-    }
+    /* Cleared so a second closefile on a stale handle is rejected */
+    zf->file_object = NULL;
 
-    vPortFree(zf);
+    file_slot_t *slot = (file_slot_t *)zf;
+    slot->next_free = s_free_slots;
+    s_free_slots = slot;
 }
 
 /*
@@ -246,23 +376,17 @@ static z_file* hybrid_openfile(char *filename, int filetype, int fileaccess)
             return NULL;
         }
 
-        hybrid_file_t *hf = pvPortMalloc(sizeof(hybrid_file_t));
-        if (hf == NULL) {
-            free_zfile(zf);
-            return NULL;
-        }
-
+        hybrid_file_t *hf = (hybrid_file_t *)zf->file_object;
         hf->is_embedded = 1;
         hf->u.mem.data = s_story_data;
         hf->u.mem.size = s_story_size;
         hf->u.mem.pos = 0;
 
-        zf->file_object = hf;
         return zf;
     }
 
     /* Regular file on SD card */
-    if (!s_sd_mounted) {
+    if (!sd_filesystem_available()) {
         return NULL;
     }
 
@@ -289,22 +413,15 @@ static z_file* hybrid_openfile(char *filename, int filetype, int fileaccess)
         return NULL;
     }
 
-    hybrid_file_t *hf = pvPortMalloc(sizeof(hybrid_file_t));
-    if (hf == NULL) {
-        free_zfile(zf);
-        return NULL;
-    }
-
+    hybrid_file_t *hf = (hybrid_file_t *)zf->file_object;
     hf->is_embedded = 0;
 
     FRESULT res = f_open(&hf->u.fil, full_path, mode);
     if (res != FR_OK) {
-        vPortFree(hf);
         free_zfile(zf);
         return NULL;
     }
 
-    zf->file_object = hf;
     return zf;
 }
 
@@ -324,6 +441,31 @@ static int hybrid_closefile(z_file *file_to_close)
     return 0;
 }
 
+/*
+ * Copy up to len bytes of the embedded story from the current position.
+ * Returns: bytes copied
+ */
+static size_t embedded_read(hybrid_file_t *hf, void *dest, size_t len)
+{
+    size_t available = hf->u.mem.size - hf->u.mem.pos;
+    size_t to_read = (len < available) ? len : available;
+
+#ifdef FIZMO_STORY_PACK
+    if (s_story_packed) {
+        if (story_page_cache_read(&s_story_cache, (uint32_t)hf->u.mem.pos, dest,
+                                  (uint32_t)to_read) != 0) {
+            return 0;
+        }
+        hf->u.mem.pos += to_read;
+        return to_read;
+    }
+#endif
+
+    memcpy(dest, hf->u.mem.data + hf->u.mem.pos, to_read);
+    hf->u.mem.pos += to_read;
+    return to_read;
+}
+
 static int hybrid_readchar(z_file *fileref)
 {
     if (fileref == NULL || fileref->file_object == NULL) {
@@ -333,10 +475,11 @@ static int hybrid_readchar(z_file *fileref)
     hybrid_file_t *hf = (hybrid_file_t *)fileref->file_object;
 
     if (hf->is_embedded) {
-        if (hf->u.mem.pos >= hf->u.mem.size) {
+        uint8_t ch;
+        if (embedded_read(hf, &ch, 1) != 1) {
             return -1;  /* EOF */
         }
-        return hf->u.mem.data[hf->u.mem.pos++];
+        return ch;
     } else {
         UINT br;
         uint8_t ch;
@@ -357,11 +500,7 @@ static size_t hybrid_readchars(void *ptr, size_t len, z_file *fileref)
     hybrid_file_t *hf = (hybrid_file_t *)fileref->file_object;
 
     if (hf->is_embedded) {
-        size_t available = hf->u.mem.size - hf->u.mem.pos;
-        size_t to_read = (len < available) ? len : available;
-        memcpy(ptr, hf->u.mem.data + hf->u.mem.pos, to_read);
-        hf->u.mem.pos += to_read;
-        return to_read;
+        return embedded_read(hf, ptr, len);
     } else {
         UINT br;
         FRESULT res = f_read(&hf->u.fil, ptr, len, &br);
@@ -665,7 +804,7 @@ static int hybrid_read_dir(struct z_dir_ent *dir_ent, z_dir *dirref)
 
 static int hybrid_make_dir(char *path)
 {
-    if (!s_sd_mounted || path == NULL) {
+    if (!sd_filesystem_available() || path == NULL) {
         return -1;
     }
 
@@ -677,7 +816,7 @@ static int hybrid_make_dir(char *path)
 
 static bool hybrid_is_filename_directory(char *filename)
 {
-    if (!s_sd_mounted || filename == NULL) {
+    if (!sd_filesystem_available() || filename == NULL) {
         return false;
     }
 
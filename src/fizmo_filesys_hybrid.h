@@ -9,6 +9,14 @@
  *   - No need to have story file on SD card
  *   - Save games persist across power cycles
  *   - Simpler than writing to flash while executing (XIP complications)
+ *
+ * The embedded image may be a story catalog (tools/story_catalog.py); the
+ * selected story is the one opened as "@embedded". A plain story file is a
+ * one-entry catalog.
+ *
+ * File handles come from a fixed table of FIZMO_MAX_OPEN_FILES slots
+ * (default 4) with inline filename storage; opening a file never allocates,
+ * and running out of slots fails the open with a UART message.
  */
 
 #ifndef FIZMO_FILESYS_HYBRID_H
@@ -17,6 +25,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "story_catalog.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -25,19 +35,35 @@ extern "C" {
  * Initialize the hybrid filesystem interface.
  * Must be called before fizmo_bridge_init() or fizmo_start().
  *
- * story_data: pointer to embedded story file in flash
- * story_size: size of story file in bytes
+ * story_data: pointer to embedded story file or catalog in flash
+ * story_size: size of the image in bytes
  * save_path:  path prefix for save files on SD card (e.g., "/saves/")
  *             If NULL, saves go to root directory.
  *
+ * Selects story 0 of a catalog.
+ *
  * Returns: 0 on success, -1 on failure
  */
 int fizmo_filesys_hybrid_init(const uint8_t *story_data, size_t story_size,
                                const char *save_path);
 
+/*
+ * Story catalog access. Lookups are O(1); selecting a story only repoints
+ * "@embedded", so it must not happen while the story file is open.
+ */
+uint16_t fizmo_filesys_story_count(void);
+
+/* Returns: 0 on success, -1 if index is out of range */
+int fizmo_filesys_story_info(uint16_t index, story_catalog_entry_t *entry);
+
+/* Returns: 0 on success, -1 if index is out of range or the story is unusable */
+int fizmo_filesys_select_story(uint16_t index);
+
 /*
  * Mount/unmount the SD card filesystem.
  * The filesystem must be mounted before any save/restore operations.
+ * Thin wrappers over sd_filesystem_init()/sd_filesystem_deinit(), which
+ * own the volume.
  */
 int fizmo_filesys_mount_sd(void);
 int fizmo_filesys_unmount_sd(void);
@@ -0,0 +1,96 @@
+/*
+ * fizmo_output_ring.c
+ *
+ * Lock-free SPSC ring buffer for interpreter output.
+ * See fizmo_output_ring.h for the threading contract.
+ */
+
+#include "fizmo_output_ring.h"
+
+#include <string.h>
+
+void fizmo_output_ring_init(fizmo_output_ring_t *ring, uint32_t *buffer, size_t capacity)
+{
+    ring->buffer = buffer;
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->discard = 0;
+}
+
+void fizmo_output_ring_discard(fizmo_output_ring_t *ring)
+{
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->discard, head, __ATOMIC_RELEASE);
+}
+
+/*
+ * Consumer: first index still to be read, past any discarded characters.
+ * The indices are free-running, so "discard is ahead" is a signed distance.
+ */
+static size_t read_start(const fizmo_output_ring_t *ring)
+{
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    size_t discard = __atomic_load_n(&ring->discard, __ATOMIC_ACQUIRE);
+    return ((ptrdiff_t)(discard - tail) > 0) ? discard : tail;
+}
+
+size_t fizmo_output_ring_write(fizmo_output_ring_t *ring, const uint32_t *chars, size_t count)
+{
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    size_t space = ring->capacity - (head - tail);
+    if (count > space) {
+        count = space;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    /* Copy in at most two spans (up to the end of storage, then from the start) */
+    size_t offset = head & (ring->capacity - 1);
+    size_t first = ring->capacity - offset;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(ring->buffer + offset, chars, first * sizeof(uint32_t));
+    memcpy(ring->buffer, chars + first, (count - first) * sizeof(uint32_t));
+
+    __atomic_store_n(&ring->head, head + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+size_t fizmo_output_ring_available(const fizmo_output_ring_t *ring)
+{
+    size_t tail = read_start(ring);
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    return head - tail;
+}
+
+size_t fizmo_output_ring_read(fizmo_output_ring_t *ring, uint32_t *dest, size_t max_chars)
+{
+    size_t tail = read_start(ring);
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    size_t count = head - tail;
+    if (count > max_chars) {
+        count = max_chars;
+    }
+    if (count == 0) {
+        /* Still release discarded space back to the producer */
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    size_t offset = tail & (ring->capacity - 1);
+    size_t first = ring->capacity - offset;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(dest, ring->buffer + offset, first * sizeof(uint32_t));
+    memcpy(dest + first, ring->buffer, (count - first) * sizeof(uint32_t));
+
+    __atomic_store_n(&ring->tail, tail + count, __ATOMIC_RELEASE);
+    return count;
+}
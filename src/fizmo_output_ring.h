@@ -0,0 +1,80 @@
+/*
+ * fizmo_output_ring.h
+ *
+ * Single-producer/single-consumer ring buffer for interpreter output.
+ *
+ * The fizmo task (producer) writes whole z_ucs strings in one call and the
+ * Qt task (consumer) drains them in blocks. No locks or RTOS objects are
+ * involved: head and discard are only written by the producer, tail only by
+ * the consumer, and all are published with acquire/release ordering so the
+ * same code is correct on the single-core Cortex-M7 and on multi-core
+ * desktop hosts.
+ */
+
+#ifndef FIZMO_OUTPUT_RING_H
+#define FIZMO_OUTPUT_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Style markers: an entry with FIZMO_OUTPUT_STYLE_MARKER set is not a
+ * character but a text style change taking effect at that point, with the
+ * new FIZMO_STYLE_* combination in the low bits (Z-machine set_text_style
+ * values, plus FIZMO_STYLE_FIXED for the fixed-pitch font). Code points
+ * never reach bit 31. Styled text costs one entry per change, not per
+ * character.
+ */
+#define FIZMO_OUTPUT_STYLE_MARKER   0x80000000u
+#define FIZMO_STYLE_REVERSE         0x01u
+#define FIZMO_STYLE_BOLD            0x02u
+#define FIZMO_STYLE_ITALIC          0x04u
+#define FIZMO_STYLE_FIXED           0x08u
+
+typedef struct {
+    uint32_t *buffer;
+    size_t capacity;        /* Power of two */
+    size_t head;            /* Free-running write index (producer) */
+    size_t tail;            /* Free-running read index (consumer) */
+    size_t discard;         /* Consumer skips to here (producer) */
+} fizmo_output_ring_t;
+
+/*
+ * Initialize a ring over caller-provided storage.
+ * capacity must be a power of two.
+ */
+void fizmo_output_ring_init(fizmo_output_ring_t *ring, uint32_t *buffer, size_t capacity);
+
+/*
+ * Producer: discard everything written so far (e.g. interpreter restart).
+ * Only a mark is published; the consumer skips the discarded characters
+ * on its next read, so tail keeps a single writer.
+ */
+void fizmo_output_ring_discard(fizmo_output_ring_t *ring);
+
+/*
+ * Producer: copy up to count characters into the ring.
+ * Returns: number of characters written (less than count when full)
+ */
+size_t fizmo_output_ring_write(fizmo_output_ring_t *ring, const uint32_t *chars, size_t count);
+
+/*
+ * Consumer: number of characters waiting to be read.
+ */
+size_t fizmo_output_ring_available(const fizmo_output_ring_t *ring);
+
+/*
+ * Consumer: copy up to max_chars characters out of the ring.
+ * Returns: number of characters read
+ */
+size_t fizmo_output_ring_read(fizmo_output_ring_t *ring, uint32_t *dest, size_t max_chars);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FIZMO_OUTPUT_RING_H */
@@ -0,0 +1,164 @@
+/*
+ * fizmo_pool_alloc.c
+ *
+ * Fixed-block size-class pools for libfizmo's small allocations.
+ * See fizmo_pool_alloc.h for the locking contract.
+ */
+
+#include "fizmo_pool_alloc.h"
+
+typedef struct pool_block {
+    struct pool_block *next;
+} pool_block_t;
+
+typedef struct {
+    uint8_t *start;
+    uint8_t *end;
+    pool_block_t *free_list;
+    fizmo_pool_class_stats_t stats;
+} pool_class_t;
+
+static const size_t s_class_sizes[FIZMO_POOL_CLASS_COUNT] = { 16, 32, 64, 128, 256 };
+
+/*
+ * Relative number of blocks per class. Equal byte slices would give the
+ * 256-byte class a sixteenth of the 16-byte one. The default is a starting
+ * point only, the live-block peaks of tools/pool_bench.c's synthetic mix
+ * (about 240/480/340/64/120); build with the weights tools/pool_weights.py
+ * derives from the device's "pool" and "heap:" log lines after a real
+ * walkthrough.
+ */
+#ifndef FIZMO_POOL_WEIGHTS
+#define FIZMO_POOL_WEIGHTS  4, 8, 6, 1, 2
+#endif
+
+static const uint32_t s_class_weights[FIZMO_POOL_CLASS_COUNT] = { FIZMO_POOL_WEIGHTS };
+
+/* Block alignment malloc() must guarantee (LDRD/VLDR on Cortex-M7) */
+#define POOL_ALIGN  8u
+
+static pool_class_t s_classes[FIZMO_POOL_CLASS_COUNT];
+static uint8_t *s_region_start = NULL;
+static uint8_t *s_region_end = NULL;
+
+void fizmo_pool_init(void *region, size_t size)
+{
+    uint8_t *cursor = (uint8_t *)region;
+    uintptr_t misalign = (uintptr_t)cursor & (POOL_ALIGN - 1);
+    if (misalign != 0) {
+        size_t skip = POOL_ALIGN - misalign;
+        cursor += skip;
+        size = (size > skip) ? size - skip : 0;
+    }
+
+    /* One "unit" buys weight blocks of every class */
+    size_t unit_bytes = 0;
+    for (int i = 0; i < FIZMO_POOL_CLASS_COUNT; i++) {
+        unit_bytes += s_class_weights[i] * s_class_sizes[i];
+    }
+    size_t units = size / unit_bytes;
+
+    s_region_start = cursor;
+
+    for (int i = 0; i < FIZMO_POOL_CLASS_COUNT; i++) {
+        pool_class_t *pool = &s_classes[i];
+        size_t block_size = s_class_sizes[i];
+        uint32_t count = (uint32_t)(units * s_class_weights[i]);
+
+        /* Block sizes are multiples of POOL_ALIGN, so every block stays aligned */
+        pool->start = cursor;
+        pool->end = cursor + (size_t)count * block_size;
+        pool->free_list = NULL;
+
+        /* Thread the free list in address order so early allocations are packed */
+        for (uint32_t n = count; n > 0; n--) {
+            pool_block_t *block = (pool_block_t *)(cursor + (size_t)(n - 1) * block_size);
+            block->next = pool->free_list;
+            pool->free_list = block;
+        }
+
+        pool->stats.block_size = block_size;
+        pool->stats.total_blocks = count;
+        pool->stats.in_use = 0;
+        pool->stats.peak_in_use = 0;
+        pool->stats.alloc_count = 0;
+        pool->stats.exhausted_count = 0;
+
+        cursor = pool->end;
+    }
+
+    s_region_end = cursor;
+}
+
+bool fizmo_pool_ready(void)
+{
+    return s_region_start != NULL;
+}
+
+void* fizmo_pool_alloc(size_t size)
+{
+    if (size > FIZMO_POOL_MAX_BLOCK) {
+        return NULL;
+    }
+
+    int index = 0;
+    while (s_class_sizes[index] < size) {
+        index++;
+    }
+
+    pool_class_t *pool = &s_classes[index];
+    pool_block_t *block = pool->free_list;
+    if (block == NULL) {
+        pool->stats.exhausted_count++;
+        return NULL;
+    }
+
+    pool->free_list = block->next;
+    pool->stats.alloc_count++;
+    pool->stats.in_use++;
+    if (pool->stats.in_use > pool->stats.peak_in_use) {
+        pool->stats.peak_in_use = pool->stats.in_use;
+    }
+    return block;
+}
+
+bool fizmo_pool_owns(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    return p >= s_region_start && p < s_region_end;
+}
+
+static pool_class_t* pool_class_of(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (int i = 0; i < FIZMO_POOL_CLASS_COUNT; i++) {
+        if (p >= s_classes[i].start && p < s_classes[i].end) {
+            return &s_classes[i];
+        }
+    }
+    return NULL;
+}
+
+void fizmo_pool_free(void *ptr)
+{
+    pool_class_t *pool = pool_class_of(ptr);
+    if (pool == NULL) {
+        return;  /* Not a pool block - never handed out */
+    }
+
+    pool_block_t *block = (pool_block_t *)ptr;
+    block->next = pool->free_list;
+    pool->free_list = block;
+    pool->stats.in_use--;
+}
+
+size_t fizmo_pool_block_size(const void *ptr)
+{
+    pool_class_t *pool = pool_class_of(ptr);
+    return pool ? pool->stats.block_size : 0;
+}
+
+void fizmo_pool_get_stats(int index, fizmo_pool_class_stats_t *stats)
+{
+    *stats = s_classes[index].stats;
+}
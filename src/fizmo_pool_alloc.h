@@ -0,0 +1,85 @@
+/*
+ * fizmo_pool_alloc.h
+ *
+ * Fixed-block size-class pools for libfizmo's small allocations.
+ *
+ * A caller-provided region is split into one slice per size class
+ * (16/32/64/128/256), sized by the expected number of live blocks of each
+ * class (FIZMO_POOL_WEIGHTS) rather than by equal bytes. Every block is
+ * 8-byte aligned. Each slice is a singly linked free list, so allocation
+ * and free are O(1) and small objects never fragment the main heap.
+ * Requests larger than the biggest class, or for a class that has run out
+ * of blocks, return NULL and the caller falls back to its general
+ * allocator.
+ *
+ * Not thread-safe: the caller serializes access (posix_stubs.c uses a
+ * FreeRTOS critical section). Portable C, so it also builds on the host
+ * (see tools/pool_bench.c).
+ */
+
+#ifndef FIZMO_POOL_ALLOC_H
+#define FIZMO_POOL_ALLOC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIZMO_POOL_CLASS_COUNT  5
+#define FIZMO_POOL_MAX_BLOCK    256
+
+typedef struct {
+    size_t block_size;
+    uint32_t total_blocks;
+    uint32_t in_use;
+    uint32_t peak_in_use;
+    uint32_t alloc_count;
+    uint32_t exhausted_count;   /* Requests that fell back because the class was empty */
+} fizmo_pool_class_stats_t;
+
+/*
+ * Carve region into the size-class pools.
+ * region must stay valid for the program lifetime; an unaligned start is
+ * rounded up to 8 bytes.
+ */
+void fizmo_pool_init(void *region, size_t size);
+
+/*
+ * Returns: true once fizmo_pool_init() has run
+ */
+bool fizmo_pool_ready(void);
+
+/*
+ * Allocate a block of at least size bytes.
+ * Returns: block pointer, or NULL if size is too large or the class is exhausted
+ */
+void* fizmo_pool_alloc(size_t size);
+
+/*
+ * Returns: true if ptr lies inside the pool region (safe without locking)
+ */
+bool fizmo_pool_owns(const void *ptr);
+
+/*
+ * Return a block to its class. ptr must satisfy fizmo_pool_owns().
+ */
+void fizmo_pool_free(void *ptr);
+
+/*
+ * Returns: usable size of a pool block (its class size)
+ */
+size_t fizmo_pool_block_size(const void *ptr);
+
+/*
+ * Copy out the statistics of one size class (index < FIZMO_POOL_CLASS_COUNT).
+ */
+void fizmo_pool_get_stats(int index, fizmo_pool_class_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FIZMO_POOL_ALLOC_H */
@@ -6,25 +6,41 @@
  */
 
 #include "fizmo_rtos_bridge.h"
+#include "fizmo_output_ring.h"
+#include "upper_window.h"
 
 #include <string.h>
 #include <stdio.h>
 
 /* FreeRTOS includes */
 #include "FreeRTOS.h"
+#include "task.h"
 #include "queue.h"
 #include "semphr.h"
 
+/* The kernel is built from the platform's FreeRTOSConfig.h; stack
+ * monitoring needs this API enabled there */
+#if INCLUDE_uxTaskGetStackHighWaterMark != 1
+#error "Stack monitoring requires INCLUDE_uxTaskGetStackHighWaterMark 1 in the platform's FreeRTOSConfig.h"
+#endif
+
 /* libfizmo includes */
 #include "interpreter/fizmo.h"
 #include "tools/filesys.h"
 #include "tools/types.h"
 #include "tools/z_ucs.h"
+#include "interpreter/wordwrap.h"
+#include "interpreter/routine.h"
+#include "interpreter/zpu.h"
 #include "screen_interface/screen_interface.h"
 #include "filesys_interface/filesys_interface.h"
 
+/* Story catalog ("@embedded" is whichever story is selected) */
+#include "fizmo_filesys_hybrid.h"
+
 /* SD card availability check and FatFS for filename persistence */
 #include "sd_init.h"
+#include "posix_stubs.h"
 #include "ff.h"
 
 /* Forward declarations for screen interface */
@@ -138,35 +154,96 @@ static struct z_screen_interface rtos_screen_interface = {
     .restore_autosave = NULL
 };
 
+/* Output ring (fizmo task writes, Qt task reads) */
+static uint32_t s_output_storage[FIZMO_OUTPUT_QUEUE_SIZE];
+static fizmo_output_ring_t s_output_ring;
+
+_Static_assert((FIZMO_OUTPUT_QUEUE_SIZE & (FIZMO_OUTPUT_QUEUE_SIZE - 1)) == 0,
+               "FIZMO_OUTPUT_QUEUE_SIZE must be a power of two");
+_Static_assert(sizeof(z_ucs) == sizeof(uint32_t),
+               "z_ucs strings are copied into the output ring as-is");
+
 /* RTOS synchronization primitives */
-static QueueHandle_t s_output_queue = NULL;
 static SemaphoreHandle_t s_input_ready_sem = NULL;
 static SemaphoreHandle_t s_state_mutex = NULL;
 
+#ifdef FIZMO_STATIC_ALLOCATION
+static StaticSemaphore_t s_input_ready_sem_buffer;
+static StaticSemaphore_t s_state_mutex_buffer;
+#endif
+
 /* State variables (protected by s_state_mutex) */
 static volatile bool s_waiting_for_line = false;
 static volatile bool s_waiting_for_char = false;
 static volatile bool s_fizmo_exited = false;
+static volatile bool s_waiting_for_story = false;
+static volatile uint16_t s_selected_story = 0;
+
+/*
+ * Input submitted after a timed interrupt routine had already ended the
+ * read: the next read returns it instead of waiting
+ */
+static bool s_line_pending = false;
+static bool s_char_pending = false;
 
 /* Input buffer */
 static char s_input_buffer[FIZMO_INPUT_BUFFER_SIZE];
 static volatile size_t s_input_length = 0;
 static volatile uint32_t s_input_char = 0;
 
+/* Line being typed, mirrored by fizmo_edit_*() (protected by s_state_mutex) */
+static char s_edit_buffer[FIZMO_INPUT_BUFFER_SIZE];
+static size_t s_edit_length = 0;
+static uint32_t s_edit_serial = 0;     /* Bumped when read_line preloads it */
+
 /* Status line (for V1-V3 games) */
 static char s_status_room[64];
 static char s_status_score[32];
 static volatile bool s_status_valid = false;
 
-/* Current cursor position */
+#ifdef FIZMO_BENCHMARK
+/* Per-command response timing (printed on UART at the next read_line) */
+static TickType_t s_command_start_tick = 0;
+static uint32_t s_command_count = 0;
+#endif
+
+/* Stack monitoring: the table is filled before the scheduler starts and
+ * fixed afterwards; peak_bytes is protected by s_state_mutex */
+#define FIZMO_STACK_MONITOR_MAX 4
+
+typedef struct {
+    TaskHandle_t task;
+    const char *name;
+    size_t stack_bytes;
+    size_t peak_bytes;
+} stack_monitor_t;
+
+static stack_monitor_t s_stack_monitors[FIZMO_STACK_MONITOR_MAX];
+static size_t s_stack_monitor_count = 0;
+
+/* Line wrapping at FIZMO_SCREEN_WIDTH (libfizmo wordwrap, fizmo task only) */
+static WORDWRAP *s_wrapper = NULL;
+static bool s_buffer_mode = true;
+
+/* Current cursor position (lower window) */
 static uint16_t s_cursor_row = 1;
 static uint16_t s_cursor_column = 1;
 
+/* Text style (fizmo task only): set_text_style bits, the fixed-pitch font
+ * bit, and the style last sent to the output ring as a marker */
+static uint32_t s_text_style = 0;
+static uint32_t s_font_style = 0;
+static uint32_t s_stream_style = 0;
+
+/* Upper window grid (protected by s_state_mutex) and selected window */
+static upper_window_t s_upper_window;
+static int16_t s_current_window = 0;
+
 /* Last used save filename (remembered across save/restore calls) */
 static char s_last_save_filename[64] = "zork1.sav";
 
 /* Path to the filename persistence file */
-#define LASTFN_PATH "/saves/lastfn.txt"
+#define LASTFN_PATH SD_SAVES_DIR "/lastfn.txt"
 
 /*
  * Load last used filename from SD card (call after SD mount)
@@ -211,13 +288,78 @@ static void save_last_filename(void)
 }
 
 /*
- * Helper: send a single z_ucs character to the output queue
+ * Helper: copy characters into the output ring.
+ * If the ring is full, yield so the Qt task can drain it instead of
+ * dropping text (the fizmo task runs at a higher priority).
+ */
+static void output_chars(const uint32_t *chars, size_t count)
+{
+    while (count > 0) {
+        size_t written = fizmo_output_ring_write(&s_output_ring, chars, count);
+        chars += written;
+        count -= written;
+        if (count > 0) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+/*
+ * Helper: wordwrap output target, called with whole lines (or the pending
+ * partial line on flush).
+ */
+static void wrapped_output(z_ucs *output, void *parameter)
+{
+    (void)parameter;
+
+    size_t len = 0;
+    while (output[len] != 0) {
+        len++;
+    }
+    output_chars((const uint32_t *)output, len);
+}
+
+/*
+ * Helper: put a style marker into the output ring (also the wordwrap
+ * metadata callback, so markers stay in place among wrapped lines).
  */
-static void output_char(z_ucs ch)
+static void output_style_marker(void *ptr_parameter, uint32_t style)
 {
-    uint32_t ch32 = (uint32_t)ch;
-    /* Non-blocking send; if queue is full, character is dropped */
-    xQueueSend(s_output_queue, &ch32, 0);
+    (void)ptr_parameter;
+
+    uint32_t marker = FIZMO_OUTPUT_STYLE_MARKER | style;
+    output_chars(&marker, 1);
+}
+
+/*
+ * Helper: before lower window text, send the current style if it differs
+ * from the last one sent. Style changes with no text between them, or made
+ * while drawing the upper window, never reach the ring.
+ */
+static void sync_output_style(void)
+{
+    uint32_t style = s_text_style | s_font_style;
+    if (style == s_stream_style) {
+        return;
+    }
+    s_stream_style = style;
+
+    if (s_wrapper != NULL && s_buffer_mode) {
+        wordwrap_insert_metadata(s_wrapper, output_style_marker, NULL, style);
+    } else {
+        output_style_marker(NULL, style);
+    }
+}
+
+/*
+ * Helper: push the partial line held by the wrapper, so prompts show
+ * before the fizmo task blocks for input.
+ */
+static void flush_output(void)
+{
+    if (s_wrapper != NULL) {
+        wordwrap_flush_output(s_wrapper);
+    }
 }
 
 /*
@@ -226,33 +368,39 @@ static void output_char(z_ucs ch)
 
 int fizmo_bridge_init(void)
 {
-    /* Create output queue */
-    s_output_queue = xQueueCreate(FIZMO_OUTPUT_QUEUE_SIZE, sizeof(uint32_t));
-    if (s_output_queue == NULL) {
-        return -1;
-    }
+    /* Set up output ring */
+    fizmo_output_ring_init(&s_output_ring, s_output_storage, FIZMO_OUTPUT_QUEUE_SIZE);
 
+#ifdef FIZMO_STATIC_ALLOCATION
+    /* Static control blocks - cannot fail */
+    s_input_ready_sem = xSemaphoreCreateBinaryStatic(&s_input_ready_sem_buffer);
+    s_state_mutex = xSemaphoreCreateMutexStatic(&s_state_mutex_buffer);
+#else
     /* Create input semaphore (binary) */
     s_input_ready_sem = xSemaphoreCreateBinary();
     if (s_input_ready_sem == NULL) {
-        vQueueDelete(s_output_queue);
         return -1;
     }
 
     /* Create state mutex */
     s_state_mutex = xSemaphoreCreateMutex();
     if (s_state_mutex == NULL) {
-        vQueueDelete(s_output_queue);
         vSemaphoreDelete(s_input_ready_sem);
         return -1;
     }
+#endif
 
     /* Initialize state */
     s_waiting_for_line = false;
     s_waiting_for_char = false;
     s_fizmo_exited = false;
+    s_waiting_for_story = false;
     s_input_length = 0;
+    s_line_pending = false;
+    s_char_pending = false;
     s_status_valid = false;
+    upper_window_init(&s_upper_window, FIZMO_SCREEN_WIDTH);
+    s_current_window = 0;
 
     /* Register screen interface with libfizmo */
     int result = fizmo_register_screen_interface(&rtos_screen_interface);
@@ -263,6 +411,36 @@ int fizmo_bridge_init(void)
     return 0;
 }
 
+int fizmo_bridge_choose_story(void)
+{
+    uint16_t index = 0;
+
+    if (fizmo_filesys_story_count() > 1) {
+        /* Picker: block until the Qt task calls fizmo_select_story() */
+        xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+        s_waiting_for_story = true;
+        xSemaphoreGive(s_state_mutex);
+
+        xSemaphoreTake(s_input_ready_sem, portMAX_DELAY);
+
+        xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+        s_waiting_for_story = false;
+        index = s_selected_story;
+        xSemaphoreGive(s_state_mutex);
+    }
+
+    if (fizmo_filesys_select_story(index) != 0) {
+        return -1;
+    }
+
+    story_catalog_entry_t entry;
+    if (fizmo_filesys_story_info(index, &entry) == 0) {
+        printf("fizmo: story %s, release %u serial %s checksum %04X\r\n",
+               entry.name, (unsigned)entry.release, entry.serial, (unsigned)entry.checksum);
+    }
+    return index;
+}
+
 int fizmo_bridge_run(const uint8_t *story_data, size_t story_size)
 {
     (void)story_data;
@@ -293,26 +471,15 @@ int fizmo_bridge_run(const uint8_t *story_data, size_t story_size)
 
 size_t fizmo_output_available(void)
 {
-    if (s_output_queue == NULL) {
-        return 0;
-    }
-    return (size_t)uxQueueMessagesWaiting(s_output_queue);
+    return fizmo_output_ring_available(&s_output_ring);
 }
 
 size_t fizmo_output_read(uint32_t *buffer, size_t max_chars)
 {
-    if (s_output_queue == NULL || buffer == NULL || max_chars == 0) {
+    if (buffer == NULL || max_chars == 0) {
         return 0;
     }
-
-    size_t count = 0;
-    uint32_t ch;
-
-    while (count < max_chars && xQueueReceive(s_output_queue, &ch, 0) == pdTRUE) {
-        buffer[count++] = ch;
-    }
-
-    return count;
+    return fizmo_output_ring_read(&s_output_ring, buffer, max_chars);
 }
 
 bool fizmo_waiting_for_input(void)
@@ -342,6 +509,11 @@ void fizmo_submit_line(const char *line)
     }
 
     xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    if (!s_waiting_for_line) {
+        /* No read to receive it; a give now would satisfy a later read */
+        xSemaphoreGive(s_state_mutex);
+        return;
+    }
 
     /* Copy input to buffer */
     size_t len = strlen(line);
@@ -351,21 +523,63 @@ void fizmo_submit_line(const char *line)
     memcpy(s_input_buffer, line, len);
     s_input_buffer[len] = '\0';
     s_input_length = len;
+    s_edit_length = 0;
 
-    xSemaphoreGive(s_state_mutex);
-
-    /* Signal the fizmo task that input is ready */
+    /*
+     * Signal the fizmo task while still holding the mutex: once a read has
+     * cleared s_waiting_for_line under it, no give can still be on its way
+     */
     xSemaphoreGive(s_input_ready_sem);
+    xSemaphoreGive(s_state_mutex);
 }
 
 void fizmo_submit_char(uint32_t ch)
 {
     xSemaphoreTake(s_state_mutex, portMAX_DELAY);
-    s_input_char = ch;
+    if (s_waiting_for_char) {
+        s_input_char = ch;
+        /* Signal the fizmo task (under the mutex, as in fizmo_submit_line) */
+        xSemaphoreGive(s_input_ready_sem);
+    }
     xSemaphoreGive(s_state_mutex);
+}
 
-    /* Signal the fizmo task that input is ready */
-    xSemaphoreGive(s_input_ready_sem);
+void fizmo_edit_insert(const char *text, size_t length)
+{
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    if (length > FIZMO_INPUT_BUFFER_SIZE - 1 - s_edit_length) {
+        length = FIZMO_INPUT_BUFFER_SIZE - 1 - s_edit_length;
+    }
+    memcpy(s_edit_buffer + s_edit_length, text, length);
+    s_edit_length += length;
+    xSemaphoreGive(s_state_mutex);
+}
+
+void fizmo_edit_erase(size_t count)
+{
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    s_edit_length = (count < s_edit_length) ? s_edit_length - count : 0;
+    xSemaphoreGive(s_state_mutex);
+}
+
+bool fizmo_get_preloaded_line(uint32_t *serial, char *line, size_t size)
+{
+    bool copied = false;
+
+    if (size == 0) {
+        return false;
+    }
+
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    if (*serial != s_edit_serial) {
+        size_t len = (s_edit_length < size - 1) ? s_edit_length : size - 1;
+        memcpy(line, s_edit_buffer, len);
+        line[len] = '\0';
+        *serial = s_edit_serial;
+        copied = true;
+    }
+    xSemaphoreGive(s_state_mutex);
+    return copied;
 }
 
 bool fizmo_get_status_line(char *room, size_t room_size,
@@ -392,6 +606,74 @@ bool fizmo_get_status_line(char *room, size_t room_size,
     return valid;
 }
 
+uint16_t fizmo_get_upper_window_rows(void)
+{
+    uint16_t rows = 0;
+    if (xSemaphoreTake(s_state_mutex, portMAX_DELAY) == pdTRUE) {
+        rows = s_upper_window.rows;
+        xSemaphoreGive(s_state_mutex);
+    }
+    return rows;
+}
+
+size_t fizmo_read_upper_window_changes(upper_window_cell_t *changes, size_t max_changes)
+{
+    size_t count = 0;
+    if (changes == NULL || max_changes == 0) {
+        return 0;
+    }
+    if (xSemaphoreTake(s_state_mutex, portMAX_DELAY) == pdTRUE) {
+        count = upper_window_read_changes(&s_upper_window, changes, max_changes);
+        xSemaphoreGive(s_state_mutex);
+    }
+    return count;
+}
+
+uint16_t fizmo_story_count(void)
+{
+    return fizmo_filesys_story_count();
+}
+
+bool fizmo_get_story_name(uint16_t index, char *name, size_t name_size)
+{
+    story_catalog_entry_t entry;
+    if (name == NULL || name_size == 0 || fizmo_filesys_story_info(index, &entry) != 0) {
+        return false;
+    }
+    strncpy(name, entry.name, name_size - 1);
+    name[name_size - 1] = '\0';
+    return true;
+}
+
+bool fizmo_waiting_for_story(void)
+{
+    bool waiting = false;
+    if (xSemaphoreTake(s_state_mutex, portMAX_DELAY) == pdTRUE) {
+        waiting = s_waiting_for_story;
+        xSemaphoreGive(s_state_mutex);
+    }
+    return waiting;
+}
+
+int fizmo_select_story(uint16_t index)
+{
+    if (index >= fizmo_filesys_story_count()) {
+        return -1;
+    }
+
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    if (!s_waiting_for_story) {
+        xSemaphoreGive(s_state_mutex);
+        return -1;
+    }
+    s_selected_story = index;
+    xSemaphoreGive(s_state_mutex);
+
+    /* Signal the fizmo task, which is blocked in fizmo_bridge_choose_story() */
+    xSemaphoreGive(s_input_ready_sem);
+    return 0;
+}
+
 bool fizmo_has_exited(void)
 {
     bool exited = false;
@@ -417,6 +699,100 @@ void fizmo_load_saved_filename(void)
     load_last_filename();
 }
 
+/*
+ * uxTaskGetStackHighWaterMark() scans the 0xA5 fill left below the deepest
+ * point a task ever reached, so sampling at any time yields the all-time
+ * peak: sampling on each query is enough, no periodic task is needed.
+ * Caller holds s_state_mutex.
+ */
+static void sample_stacks(void)
+{
+    for (size_t i = 0; i < s_stack_monitor_count; i++) {
+        stack_monitor_t *monitor = &s_stack_monitors[i];
+        size_t free_bytes = (size_t)uxTaskGetStackHighWaterMark(monitor->task) * sizeof(StackType_t);
+        size_t used = monitor->stack_bytes - free_bytes;
+        if (used > monitor->peak_bytes) {
+            monitor->peak_bytes = used;
+        }
+    }
+}
+
+void fizmo_stack_monitor_add(void *task, const char *name, size_t stack_bytes)
+{
+    /* Runs before vTaskStartScheduler(): no other task can see the table
+     * yet, and blocking on the mutex is not allowed */
+#if INCLUDE_xTaskGetSchedulerState == 1 || configUSE_TIMERS == 1
+    configASSERT(xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED);
+#endif
+    if (s_stack_monitor_count < FIZMO_STACK_MONITOR_MAX) {
+        stack_monitor_t *monitor = &s_stack_monitors[s_stack_monitor_count++];
+        monitor->task = (TaskHandle_t)task;
+        monitor->name = name;
+        monitor->stack_bytes = stack_bytes;
+        monitor->peak_bytes = 0;
+    }
+}
+
+size_t fizmo_get_stack_usage(fizmo_stack_usage_t *usage, size_t max_entries)
+{
+    size_t count = 0;
+
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    sample_stacks();
+    for (; count < s_stack_monitor_count && count < max_entries; count++) {
+        usage[count].name = s_stack_monitors[count].name;
+        usage[count].stack_bytes = s_stack_monitors[count].stack_bytes;
+        usage[count].peak_bytes = s_stack_monitors[count].peak_bytes;
+    }
+    xSemaphoreGive(s_state_mutex);
+
+    return count;
+}
+
+void fizmo_log_stack_usage(void)
+{
+    fizmo_stack_usage_t usage[FIZMO_STACK_MONITOR_MAX];
+    size_t count = fizmo_get_stack_usage(usage, FIZMO_STACK_MONITOR_MAX);
+
+    for (size_t i = 0; i < count; i++) {
+        /* Peak + 25%, rounded up to 256 words */
+        size_t suggested_words = ((usage[i].peak_bytes + usage[i].peak_bytes / 4)
+                                  / sizeof(StackType_t) + 255) & ~(size_t)255;
+        printf("[stack] %s: peak %lu of %lu bytes (suggest %lu words)\r\n",
+               usage[i].name,
+               (unsigned long)usage[i].peak_bytes,
+               (unsigned long)usage[i].stack_bytes,
+               (unsigned long)suggested_words);
+    }
+}
+
+bool fizmo_get_heap_snapshot(heap_telemetry_snapshot_t *snapshot)
+{
+#ifdef FIZMO_HEAP_TELEMETRY
+    return heap_telemetry_capture(snapshot);
+#else
+    (void)snapshot;
+    return false;
+#endif
+}
+
+#ifdef FIZMO_HEAP_TELEMETRY
+static void heap_log_line(const char *line)
+{
+    printf("%s\r\n", line);
+}
+#endif
+
+void fizmo_log_heap_snapshot(void)
+{
+#ifdef FIZMO_HEAP_TELEMETRY
+    heap_telemetry_snapshot_t snapshot;
+    if (heap_telemetry_capture(&snapshot)) {
+        heap_telemetry_log(&snapshot, heap_log_line);
+    }
+#endif
+}
+
 /*
  * Screen interface implementation
  */
@@ -433,7 +809,7 @@ static bool rtos_is_status_line_available(void)
 
 static bool rtos_is_split_screen_available(void)
 {
-    return false;  /* Not implementing split screen for simplicity */
+    return true;  /* Upper window is a character grid (upper_window.c) */
 }
 
 static bool rtos_is_variable_pitch_font_default(void)
@@ -453,12 +829,12 @@ static bool rtos_is_picture_displaying_available(void)
 
 static bool rtos_is_bold_face_available(void)
 {
-    return false;
+    return true;  /* Style markers in the output ring */
 }
 
 static bool rtos_is_italic_available(void)
 {
-    return false;
+    return true;
 }
 
 static bool rtos_is_fixed_space_font_available(void)
@@ -468,12 +844,12 @@ static bool rtos_is_fixed_space_font_available(void)
 
 static bool rtos_is_timed_keyboard_input_available(void)
 {
-    return false;  /* Not implementing timed input */
+    return true;
 }
 
 static bool rtos_is_preloaded_input_available(void)
 {
-    return false;
+    return true;
 }
 
 static bool rtos_is_character_graphics_font_availiable(void)
@@ -552,21 +928,37 @@ static char** rtos_get_config_option_names(void)
 static void rtos_link_interface_to_story(struct z_story *story)
 {
     (void)story;
-    /* Could inspect story->version here if needed */
+
+    /* Wrap once here at the display width; the UI does not re-wrap */
+    if (s_wrapper == NULL) {
+        s_wrapper = wordwrap_new_wrapper(FIZMO_SCREEN_WIDTH, wrapped_output, NULL,
+                                         true, 0, true, false);
+    }
+    s_buffer_mode = true;
 }
 
 static void rtos_reset_interface(void)
 {
-    /* Clear output queue on restart */
-    if (s_output_queue != NULL) {
-        xQueueReset(s_output_queue);
-    }
+    /* Drop pending output on restart; the Qt task skips it on its next read.
+     * The wrapper's partial line goes into the ring first, so it is dropped
+     * with the rest instead of opening the new game's first line. */
+    flush_output();
+    fizmo_output_ring_discard(&s_output_ring);
 
     xSemaphoreTake(s_state_mutex, portMAX_DELAY);
     s_status_valid = false;
     s_cursor_row = 1;
     s_cursor_column = 1;
+    upper_window_split(&s_upper_window, 0);
+    upper_window_erase(&s_upper_window);
+    s_current_window = 0;
     xSemaphoreGive(s_state_mutex);
+
+    /* The Qt task still holds the old game's last style: reset it too */
+    s_text_style = 0;
+    s_font_style = 0;
+    s_stream_style = 0;
+    output_style_marker(NULL, 0);
 }
 
 static int rtos_close_interface(z_ucs *error_message)
@@ -575,13 +967,19 @@ static int rtos_close_interface(z_ucs *error_message)
         /* Output error message before closing */
         rtos_z_ucs_output(error_message);
     }
+    if (s_wrapper != NULL) {
+        wordwrap_flush_output(s_wrapper);
+        wordwrap_destroy_wrapper(s_wrapper);
+        s_wrapper = NULL;
+    }
     return 0;
 }
 
 static void rtos_set_buffer_mode(uint8_t new_buffer_mode)
 {
-    (void)new_buffer_mode;
-    /* Buffering handled by output queue */
+    /* Unbuffered output (buffer mode 0) bypasses the wrapper */
+    flush_output();
+    s_buffer_mode = (new_buffer_mode != 0);
 }
 
 static void rtos_z_ucs_output(z_ucs *z_ucs_output)
@@ -590,11 +988,68 @@ static void rtos_z_ucs_output(z_ucs *z_ucs_output)
         return;
     }
 
-    /* Send each character to the output queue */
-    while (*z_ucs_output != 0) {
-        output_char(*z_ucs_output);
-        z_ucs_output++;
+    /* Count the string once for whichever path takes it */
+    size_t len = 0;
+    while (z_ucs_output[len] != 0) {
+        len++;
+    }
+
+    if (s_current_window == 1) {
+        xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+        upper_window_write(&s_upper_window, (const uint32_t *)z_ucs_output, len);
+        xSemaphoreGive(s_state_mutex);
+        return;
+    }
+
+    sync_output_style();
+
+    if (s_wrapper != NULL && s_buffer_mode) {
+        wordwrap_wrap_z_ucs(s_wrapper, z_ucs_output);
+        return;
+    }
+
+    /* Copy the whole string into the output ring in one pass */
+    output_chars((const uint32_t *)z_ucs_output, len);
+}
+
+/*
+ * Block until the Qt task submits input. With a timeout (tenth_seconds > 0)
+ * the task sleeps on the semaphore for that long, then runs the story's
+ * interrupt routine and waits again; nothing polls in between. Output the
+ * routine prints is flushed so it shows while the player is still typing.
+ * Called without s_state_mutex held, as the routine prints.
+ *
+ * Returns: true when input arrived, false when the routine returned true
+ *          (or quit the story) and the read must end without input
+ */
+static bool wait_for_input(uint16_t tenth_seconds, uint32_t verification_routine,
+                           int *tenth_seconds_elapsed)
+{
+    TickType_t timeout = portMAX_DELAY;
+    TickType_t start = xTaskGetTickCount();
+    bool received = true;
+
+    if (tenth_seconds > 0 && verification_routine != 0) {
+        timeout = pdMS_TO_TICKS((uint32_t)tenth_seconds * 100);
+        if (timeout == 0) {
+            timeout = 1;
+        }
+    }
+
+    while (xSemaphoreTake(s_input_ready_sem, timeout) != pdTRUE) {
+        uint16_t result = interpret_from_call(verification_routine);
+        flush_output();
+        if (result != 0 || terminate_interpreter != INTERPRETER_QUIT_NONE) {
+            received = false;
+            break;
+        }
+    }
+
+    if (tenth_seconds_elapsed != NULL) {
+        TickType_t ticks = xTaskGetTickCount() - start;
+        *tenth_seconds_elapsed = (int)(((uint64_t)ticks * 10) / configTICK_RATE_HZ);
     }
+    return received;
 }
 
 static int16_t rtos_read_line(zscii *dest, uint16_t maximum_length,
@@ -602,29 +1057,84 @@ static int16_t rtos_read_line(zscii *dest, uint16_t maximum_length,
     uint8_t preloaded_input, int *tenth_seconds_elapsed,
     bool disable_command_history, bool return_on_escape)
 {
-    (void)tenth_seconds;
-    (void)verification_routine;
-    (void)preloaded_input;
     (void)disable_command_history;
     (void)return_on_escape;
 
-    if (tenth_seconds_elapsed != NULL) {
-        *tenth_seconds_elapsed = 0;
+#ifdef FIZMO_BENCHMARK
+    if (s_command_count > 0) {
+        TickType_t elapsed = xTaskGetTickCount() - s_command_start_tick;
+        printf("[bench] command %lu: %lu ms\r\n", (unsigned long)s_command_count,
+               (unsigned long)(elapsed * portTICK_PERIOD_MS));
+        posix_heap_log_stats();
+        fizmo_log_stack_usage();
     }
+#endif
+
+    flush_output();
 
-    /* Signal that we're waiting for input */
+    /* Signal that we're waiting for input, unless a line is already pending */
     xSemaphoreTake(s_state_mutex, portMAX_DELAY);
-    s_waiting_for_line = true;
-    s_input_length = 0;
+    sample_stacks();
+    bool pending = s_line_pending;
+    s_line_pending = false;
+    if (!pending) {
+        s_waiting_for_line = true;
+        s_input_length = 0;
+    }
+
+    /*
+     * dest starts with preloaded_input characters the story wants treated
+     * as typed: they replace the held line. Otherwise the held line stays,
+     * so a command half-typed before a timed interrupt ended the last read
+     * is still there to finish.
+     */
+    if (preloaded_input > 0) {
+        size_t len = preloaded_input;
+        if (len > maximum_length) {
+            len = maximum_length;
+        }
+        if (len > FIZMO_INPUT_BUFFER_SIZE - 1) {
+            len = FIZMO_INPUT_BUFFER_SIZE - 1;
+        }
+        for (size_t i = 0; i < len; i++) {
+            s_edit_buffer[i] = (dest[i] < 0x80) ? (char)dest[i] : '?';
+        }
+        s_edit_length = len;
+        s_edit_serial++;
+    }
     xSemaphoreGive(s_state_mutex);
 
-    /* Block until input is submitted */
-    xSemaphoreTake(s_input_ready_sem, portMAX_DELAY);
+    /* Block until input is submitted or the interrupt routine ends the read */
+    bool received = true;
+    if (pending) {
+        if (tenth_seconds_elapsed != NULL) {
+            *tenth_seconds_elapsed = 0;
+        }
+    } else {
+        received = wait_for_input(tenth_seconds, verification_routine,
+                                  tenth_seconds_elapsed);
+    }
 
-    /* Copy input to destination */
     xSemaphoreTake(s_state_mutex, portMAX_DELAY);
     s_waiting_for_line = false;
 
+    /*
+     * A line submitted between the routine ending the read and this point
+     * left a give behind; take it now and keep the line for the next read,
+     * so the command is neither lost nor replayed as an empty line
+     */
+    if (!received && xSemaphoreTake(s_input_ready_sem, 0) == pdTRUE) {
+        s_line_pending = true;
+    }
+
+    if (!received) {
+        /* libfizmo reads -1 as "terminated by the interrupt routine" */
+        xSemaphoreGive(s_state_mutex);
+        return -1;
+    }
+
+    /* Copy input to destination */
+
     size_t len = s_input_length;
     if (len > maximum_length) {
         len = maximum_length;
@@ -637,34 +1147,53 @@ static int16_t rtos_read_line(zscii *dest, uint16_t maximum_length,
 
     xSemaphoreGive(s_state_mutex);
 
+#ifdef FIZMO_BENCHMARK
+    s_command_start_tick = xTaskGetTickCount();
+    s_command_count++;
+#endif
+
     return (int16_t)len;
 }
 
 static int rtos_read_char(uint16_t tenth_seconds, uint32_t verification_routine,
     int *tenth_seconds_elapsed)
 {
-    (void)tenth_seconds;
-    (void)verification_routine;
-
-    if (tenth_seconds_elapsed != NULL) {
-        *tenth_seconds_elapsed = 0;
-    }
+    flush_output();
 
-    /* Signal that we're waiting for a character */
+    /* Signal that we're waiting for a character, unless one is already pending */
     xSemaphoreTake(s_state_mutex, portMAX_DELAY);
-    s_waiting_for_char = true;
-    s_input_char = 0;
+    bool pending = s_char_pending;
+    s_char_pending = false;
+    if (!pending) {
+        s_waiting_for_char = true;
+        s_input_char = 0;
+    }
     xSemaphoreGive(s_state_mutex);
 
-    /* Block until input is submitted */
-    xSemaphoreTake(s_input_ready_sem, portMAX_DELAY);
+    /* Block until input is submitted or the interrupt routine ends the read */
+    bool received = true;
+    if (pending) {
+        if (tenth_seconds_elapsed != NULL) {
+            *tenth_seconds_elapsed = 0;
+        }
+    } else {
+        received = wait_for_input(tenth_seconds, verification_routine,
+                                  tenth_seconds_elapsed);
+    }
 
-    /* Get the input character */
+    /* Get the input character; one that raced the routine is kept (see read_line) */
     xSemaphoreTake(s_state_mutex, portMAX_DELAY);
     s_waiting_for_char = false;
+    if (!received && xSemaphoreTake(s_input_ready_sem, 0) == pdTRUE) {
+        s_char_pending = true;
+    }
     uint32_t ch = s_input_char;
     xSemaphoreGive(s_state_mutex);
 
+    if (!received) {
+        return 0;  /* read_char stores 0 when the routine terminates it */
+    }
+
     /* Convert to ZSCII (simplified) */
     if (ch > 255) {
         ch = '?';  /* Replace unsupported characters */
@@ -707,8 +1236,13 @@ static void rtos_show_status(z_ucs *room_description, int status_line_mode,
 
 static void rtos_set_text_style(z_style text_style)
 {
-    (void)text_style;
-    /* Text styling not implemented */
+    /* Roman clears; other styles combine (Z-machine 1.1, 8.7.1.1) */
+    if (text_style == Z_STYLE_ROMAN) {
+        s_text_style = 0;
+    } else {
+        s_text_style |= (uint32_t)text_style &
+            (FIZMO_STYLE_REVERSE | FIZMO_STYLE_BOLD | FIZMO_STYLE_ITALIC | FIZMO_STYLE_FIXED);
+    }
 }
 
 static void rtos_set_colour(z_colour foreground, z_colour background, int16_t window)
@@ -721,49 +1255,90 @@ static void rtos_set_colour(z_colour foreground, z_colour background, int16_t wi
 
 static void rtos_set_font(z_font font_type)
 {
-    (void)font_type;
-    /* Font changes not implemented */
+    /* The game font is fixed-pitch already; the bit only tags the text */
+    if (font_type == Z_FONT_COURIER_FIXED_PITCH) {
+        s_font_style = FIZMO_STYLE_FIXED;
+    } else if (font_type == Z_FONT_NORMAL) {
+        s_font_style = 0;
+    }
 }
 
 static void rtos_split_window(int16_t nof_lines)
 {
-    (void)nof_lines;
-    /* Split window not implemented */
+    flush_output();
+
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    upper_window_split(&s_upper_window, nof_lines > 0 ? (uint16_t)nof_lines : 0);
+    xSemaphoreGive(s_state_mutex);
 }
 
 static void rtos_set_window(int16_t window_number)
 {
-    (void)window_number;
-    /* Window switching not implemented */
+    /* Lower window text written so far goes out before the switch */
+    flush_output();
+    s_current_window = window_number;
+
+    if (window_number == 1) {
+        /* Selecting the upper window homes its cursor (spec 8.7.2) */
+        xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+        upper_window_set_cursor(&s_upper_window, 1, 1);
+        xSemaphoreGive(s_state_mutex);
+    }
 }
 
 static void rtos_erase_window(int16_t window_number)
 {
-    (void)window_number;
-    /* Window erasing not implemented */
+    /* The lower window keeps its scrollback; only the grid is erased */
+    if (window_number == 0) {
+        return;
+    }
+
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    if (window_number == -1) {
+        upper_window_split(&s_upper_window, 0);
+        s_current_window = 0;
+    }
+    upper_window_erase(&s_upper_window);
+    xSemaphoreGive(s_state_mutex);
 }
 
 static void rtos_set_cursor(int16_t line, int16_t column, int16_t window)
 {
-    (void)window;
+    if (window == 1) {
+        xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+        upper_window_set_cursor(&s_upper_window, line, column);
+        xSemaphoreGive(s_state_mutex);
+        return;
+    }
     s_cursor_row = (uint16_t)line;
     s_cursor_column = (uint16_t)column;
 }
 
 static uint16_t rtos_get_cursor_row(void)
 {
+    if (s_current_window == 1) {
+        return upper_window_cursor_line(&s_upper_window);
+    }
     return s_cursor_row;
 }
 
 static uint16_t rtos_get_cursor_column(void)
 {
+    if (s_current_window == 1) {
+        return upper_window_cursor_column(&s_upper_window);
+    }
     return s_cursor_column;
 }
 
 static void rtos_erase_line_value(uint16_t start_position)
 {
-    (void)start_position;
-    /* Line erasing not implemented */
+    (void)start_position;  /* Always from the cursor (start_position 1) */
+
+    if (s_current_window == 1) {
+        xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+        upper_window_erase_line(&s_upper_window);
+        xSemaphoreGive(s_state_mutex);
+    }
 }
 
 static void rtos_erase_line_pixels(uint16_t start_position)
@@ -824,6 +1399,7 @@ static int rtos_prompt_for_filename(char *filename_suggestion, z_file **result_f
     }
     prompt_ucs[strlen(prompt)] = 0;
     rtos_z_ucs_output(prompt_ucs);
+    flush_output();
 
     /* Wait for user input */
     xSemaphoreTake(s_state_mutex, portMAX_DELAY);
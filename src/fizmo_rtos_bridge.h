@@ -7,8 +7,10 @@
  *
  * Architecture:
  *   - Fizmo task: runs fizmo_start(), blocks on read_line/read_char
+ *     (timed reads wake on the semaphore timeout to run the interrupt routine)
  *   - Qt task: runs event loop, polls for output, submits input
- *   - Communication: FreeRTOS queue (output), semaphores (input sync)
+ *   - Communication: lock-free output ring (fizmo_output_ring.h),
+ *     semaphores (input sync)
  */
 
 #ifndef FIZMO_RTOS_BRIDGE_H
@@ -18,11 +20,15 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "heap_telemetry.h"
+#include "upper_window.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /* Configuration */
+/* Output ring size in characters (must be a power of two) */
 #ifndef FIZMO_OUTPUT_QUEUE_SIZE
 #define FIZMO_OUTPUT_QUEUE_SIZE     2048
 #endif
@@ -31,23 +37,37 @@ extern "C" {
 #define FIZMO_INPUT_BUFFER_SIZE     256
 #endif
 
+/* Screen size in characters: the game text area of the display profile,
+ * so libfizmo wraps output once at the width the UI shows */
+#include "DisplayConfig.h"
+
 #ifndef FIZMO_SCREEN_WIDTH
-#define FIZMO_SCREEN_WIDTH          80
+#define FIZMO_SCREEN_WIDTH          DISPLAY_TEXT_COLUMNS
 #endif
 
 #ifndef FIZMO_SCREEN_HEIGHT
-#define FIZMO_SCREEN_HEIGHT         24
+#define FIZMO_SCREEN_HEIGHT         DISPLAY_TEXT_ROWS
 #endif
 
 /*
  * Initialize the RTOS bridge.
  * Must be called before starting the fizmo task.
- * Creates queues, semaphores, and registers interfaces with libfizmo.
+ * Sets up the output ring, semaphores, and registers interfaces with libfizmo.
  *
  * Returns: 0 on success, -1 on failure
  */
 int fizmo_bridge_init(void);
 
+/*
+ * Select the story to run from the embedded catalog.
+ * Call from the fizmo task before fizmo_bridge_run(). With more than one
+ * story this blocks until the Qt task calls fizmo_select_story(); with a
+ * single story it returns immediately.
+ *
+ * Returns: selected story index, or -1 if the story cannot be used
+ */
+int fizmo_bridge_choose_story(void);
+
 /*
  * Start the fizmo interpreter with embedded story.
  * This function blocks and should be called from the fizmo FreeRTOS task.
@@ -64,7 +84,7 @@ int fizmo_bridge_run(const uint8_t *story_data, size_t story_size);
  * Check if output is available from fizmo.
  * Non-blocking, safe to call from Qt task.
  *
- * Returns: number of characters available in output queue
+ * Returns: number of characters available in output ring
  */
 size_t fizmo_output_available(void);
 
@@ -111,6 +131,30 @@ void fizmo_submit_line(const char *line);
  */
 void fizmo_submit_char(uint32_t ch);
 
+/*
+ * Mirror an edit of the command being typed into the bridge's copy of the
+ * line, so it survives reads the story's timer interrupts and can be
+ * preloaded. Only the change is sent: bytes appended, or bytes removed
+ * from the end. fizmo_submit_line() clears the copy.
+ * Safe to call from Qt task.
+ *
+ * text: UTF-8 bytes appended (length bytes, no terminator needed)
+ */
+void fizmo_edit_insert(const char *text, size_t length);
+void fizmo_edit_erase(size_t count);
+
+/*
+ * Fetch the line read_line preloaded (the story's preloaded_input), which
+ * replaces whatever the player had typed.
+ * Safe to call from Qt task; copies only when the line was replaced.
+ *
+ * serial: caller's last seen serial, updated when a new line is copied
+ * line: buffer for the null-terminated line
+ *
+ * Returns: true if the line was replaced since *serial and was copied
+ */
+bool fizmo_get_preloaded_line(uint32_t *serial, char *line, size_t size);
+
 /*
  * Get the current status line text (for V1-V3 games).
  * Safe to call from Qt task.
@@ -123,6 +167,33 @@ void fizmo_submit_char(uint32_t ch);
 bool fizmo_get_status_line(char *room, size_t room_size,
                            char *score_or_time, size_t score_size);
 
+/*
+ * Upper window of V4+ stories (see upper_window.h). Safe to call from Qt task.
+ */
+
+/* Returns: upper window height in rows (0 when the screen is not split) */
+uint16_t fizmo_get_upper_window_rows(void);
+
+/* Copy up to max_changes cells written since the last call.
+ * Returns: number of cells copied */
+size_t fizmo_read_upper_window_changes(upper_window_cell_t *changes, size_t max_changes);
+
+/*
+ * Story catalog (see fizmo_filesys_hybrid.h). Safe to call from Qt task.
+ */
+
+/* Returns: number of embedded stories (1 without a catalog) */
+uint16_t fizmo_story_count(void);
+
+/* Copy the picker name of story index. Returns: false if index is out of range */
+bool fizmo_get_story_name(uint16_t index, char *name, size_t name_size);
+
+/* Returns: true while the fizmo task waits in fizmo_bridge_choose_story() */
+bool fizmo_waiting_for_story(void);
+
+/* Start story index. Returns: 0 on success, -1 if not waiting or out of range */
+int fizmo_select_story(uint16_t index);
+
 /*
  * Check if the interpreter has finished (game quit or error).
  *
@@ -142,6 +213,38 @@ uint16_t fizmo_get_screen_height(void);
  */
 void fizmo_load_saved_filename(void);
 
+/*
+ * Heap telemetry (FIZMO_HEAP_TELEMETRY builds): live/peak bytes, churn,
+ * request-size histogram and the heaviest malloc call sites.
+ */
+
+/* Copy the current snapshot. Returns false if telemetry is not compiled in. */
+bool fizmo_get_heap_snapshot(heap_telemetry_snapshot_t *snapshot);
+
+/* Print the snapshot (UART) */
+void fizmo_log_heap_snapshot(void);
+
+/*
+ * Stack monitoring: deepest stack use per task, read from the kernel's
+ * high-water mark on each query. The mark never goes back up, so no
+ * periodic sampling is needed to catch the peak.
+ */
+typedef struct {
+    const char *name;
+    size_t stack_bytes;     /* Configured stack size */
+    size_t peak_bytes;      /* Deepest use observed */
+} fizmo_stack_usage_t;
+
+/* Register a task (TaskHandle_t) for monitoring; call after fizmo_bridge_init()
+ * and before vTaskStartScheduler() */
+void fizmo_stack_monitor_add(void *task, const char *name, size_t stack_bytes);
+
+/* Fill up to max_entries records. Returns: number of records */
+size_t fizmo_get_stack_usage(fizmo_stack_usage_t *usage, size_t max_entries);
+
+/* Print usage and a suggested size (peak + 25%) per task (UART) */
+void fizmo_log_stack_usage(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,175 @@
+/*
+ * heap_telemetry.c
+ *
+ * Allocation telemetry recorded by the malloc wrappers.
+ * See heap_telemetry.h for the locking contract.
+ */
+
+#include "heap_telemetry.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static heap_telemetry_snapshot_t s_stats;
+static heap_telemetry_site_t s_sites[HEAP_TELEMETRY_SITES];
+
+static int size_class(size_t size)
+{
+    int index = 0;
+    size_t limit = 16;
+    while (size > limit && index < HEAP_TELEMETRY_SIZE_CLASSES - 1) {
+        limit <<= 1;
+        index++;
+    }
+    return index;
+}
+
+static heap_telemetry_site_t* find_site(uintptr_t caller)
+{
+    /* Open addressing on the (word-aligned) return address */
+    uint32_t slot = (uint32_t)((caller >> 1) * 2654435761u) % HEAP_TELEMETRY_SITES;
+
+    for (int probe = 0; probe < HEAP_TELEMETRY_SITES; probe++) {
+        heap_telemetry_site_t *site = &s_sites[slot];
+        if (site->caller == caller) {
+            return site;
+        }
+        if (site->caller == 0) {
+            site->caller = caller;
+            return site;
+        }
+        slot = (slot + 1) % HEAP_TELEMETRY_SITES;
+    }
+    return NULL;
+}
+
+void heap_telemetry_record_request(uintptr_t caller, size_t requested)
+{
+    s_stats.pending_size = requested;
+    s_stats.pending_caller = caller;
+}
+
+void heap_telemetry_record_alloc(uintptr_t caller, size_t requested, size_t usable)
+{
+    s_stats.pending_size = 0;
+    s_stats.pending_caller = 0;
+
+    if (usable == 0) {
+        s_stats.failed_count++;
+        s_stats.last_failed_size = requested;
+        s_stats.last_failed_caller = caller;
+        return;
+    }
+
+    s_stats.alloc_count++;
+    s_stats.churn_bytes += usable;
+    s_stats.live_bytes += usable;
+    s_stats.live_blocks++;
+    if (s_stats.live_bytes > s_stats.peak_bytes) {
+        s_stats.peak_bytes = s_stats.live_bytes;
+    }
+    if (s_stats.live_blocks > s_stats.peak_blocks) {
+        s_stats.peak_blocks = s_stats.live_blocks;
+    }
+    s_stats.size_histogram[size_class(requested)]++;
+
+    heap_telemetry_site_t *site = find_site(caller);
+    if (site != NULL) {
+        site->alloc_count++;
+        site->bytes_requested += (uint32_t)requested;
+    } else {
+        s_stats.untracked_sites++;
+    }
+}
+
+void heap_telemetry_record_free(size_t usable)
+{
+    s_stats.free_count++;
+    s_stats.live_bytes -= usable;
+    s_stats.live_blocks--;
+}
+
+void heap_telemetry_snapshot(heap_telemetry_snapshot_t *snapshot)
+{
+    *snapshot = s_stats;
+    memset(snapshot->top_sites, 0, sizeof(snapshot->top_sites));
+
+    /* Insertion into a short sorted list - the site table is small */
+    for (int i = 0; i < HEAP_TELEMETRY_SITES; i++) {
+        const heap_telemetry_site_t *site = &s_sites[i];
+        if (site->caller == 0) {
+            continue;
+        }
+        int pos = HEAP_TELEMETRY_TOP_SITES;
+        while (pos > 0 && snapshot->top_sites[pos - 1].bytes_requested < site->bytes_requested) {
+            pos--;
+        }
+        if (pos >= HEAP_TELEMETRY_TOP_SITES) {
+            continue;
+        }
+        memmove(&snapshot->top_sites[pos + 1], &snapshot->top_sites[pos],
+                (HEAP_TELEMETRY_TOP_SITES - pos - 1) * sizeof(heap_telemetry_site_t));
+        snapshot->top_sites[pos] = *site;
+    }
+}
+
+void heap_telemetry_log(const heap_telemetry_snapshot_t *snapshot,
+                        void (*emit)(const char *line))
+{
+    char line[96];
+
+    snprintf(line, sizeof(line), "heap: live %lu bytes in %lu blocks, peak %lu bytes / %lu blocks",
+             (unsigned long)snapshot->live_bytes, (unsigned long)snapshot->live_blocks,
+             (unsigned long)snapshot->peak_bytes, (unsigned long)snapshot->peak_blocks);
+    emit(line);
+
+    snprintf(line, sizeof(line), "heap: %lu allocs, %lu frees, %lu failed, churn %lu KB",
+             (unsigned long)snapshot->alloc_count, (unsigned long)snapshot->free_count,
+             (unsigned long)snapshot->failed_count,
+             (unsigned long)(snapshot->churn_bytes / 1024));
+    emit(line);
+
+    /* Inside the malloc-failed hook the pending request is the failing one */
+    if (snapshot->pending_size > 0) {
+        snprintf(line, sizeof(line), "heap: pending request %lu bytes from 0x%08lx",
+                 (unsigned long)snapshot->pending_size, (unsigned long)snapshot->pending_caller);
+        emit(line);
+    }
+    if (snapshot->last_failed_size > 0) {
+        snprintf(line, sizeof(line), "heap: last failed request %lu bytes from 0x%08lx",
+                 (unsigned long)snapshot->last_failed_size,
+                 (unsigned long)snapshot->last_failed_caller);
+        emit(line);
+    }
+
+    size_t limit = 16;
+    for (int i = 0; i < HEAP_TELEMETRY_SIZE_CLASSES; i++, limit <<= 1) {
+        if (snapshot->size_histogram[i] == 0) {
+            continue;
+        }
+        if (i == HEAP_TELEMETRY_SIZE_CLASSES - 1) {
+            snprintf(line, sizeof(line), "heap:   >%5lu: %lu",
+                     (unsigned long)(limit >> 1), (unsigned long)snapshot->size_histogram[i]);
+        } else {
+            snprintf(line, sizeof(line), "heap:  <=%5lu: %lu",
+                     (unsigned long)limit, (unsigned long)snapshot->size_histogram[i]);
+        }
+        emit(line);
+    }
+
+    for (int i = 0; i < HEAP_TELEMETRY_TOP_SITES; i++) {
+        const heap_telemetry_site_t *site = &snapshot->top_sites[i];
+        if (site->caller == 0) {
+            break;
+        }
+        snprintf(line, sizeof(line), "heap: site 0x%08lx: %lu allocs, %lu bytes",
+                 (unsigned long)site->caller, (unsigned long)site->alloc_count,
+                 (unsigned long)site->bytes_requested);
+        emit(line);
+    }
+    if (snapshot->untracked_sites > 0) {
+        snprintf(line, sizeof(line), "heap: %lu allocs from untracked sites",
+                 (unsigned long)snapshot->untracked_sites);
+        emit(line);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * heap_telemetry.h
+ *
+ * Allocation telemetry recorded by the malloc wrappers: live/peak bytes,
+ * churn, a request-size histogram and a per-call-site table keyed by the
+ * caller's return address (resolve with addr2line against the ELF).
+ *
+ * Not thread-safe: the wrappers serialize calls (interrupt mask on
+ * FreeRTOS, a mutex on desktop).
+ */
+
+#ifndef HEAP_TELEMETRY_H
+#define HEAP_TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEAP_TELEMETRY_SIZE_CLASSES  10     /* <=16, <=32, ... <=4096, larger */
+#define HEAP_TELEMETRY_SITES         64     /* Distinct call sites tracked */
+#define HEAP_TELEMETRY_TOP_SITES     8      /* Sites included in a snapshot */
+
+typedef struct {
+    uintptr_t caller;           /* Return address of the malloc call */
+    uint32_t alloc_count;
+    uint32_t bytes_requested;   /* Cumulative */
+} heap_telemetry_site_t;
+
+typedef struct {
+    size_t live_bytes;          /* Usable bytes of blocks not yet freed */
+    size_t peak_bytes;          /* High-water mark of live_bytes */
+    uint32_t live_blocks;
+    uint32_t peak_blocks;
+    uint32_t alloc_count;
+    uint32_t free_count;
+    uint32_t failed_count;      /* Allocations that returned NULL */
+    size_t pending_size;        /* Request handed to the allocator, not yet recorded */
+    uintptr_t pending_caller;
+    size_t last_failed_size;    /* Most recent allocation that returned NULL */
+    uintptr_t last_failed_caller;
+    uint64_t churn_bytes;       /* Cumulative bytes allocated */
+    uint32_t size_histogram[HEAP_TELEMETRY_SIZE_CLASSES];
+    uint32_t untracked_sites;   /* Allocations from sites beyond the table */
+    heap_telemetry_site_t top_sites[HEAP_TELEMETRY_TOP_SITES];  /* By bytes requested */
+} heap_telemetry_snapshot_t;
+
+/*
+ * Note a request before it reaches the allocator. heap_4 calls the
+ * malloc-failed hook from inside pvPortMalloc, before the wrapper gets to
+ * record the result, so this is how the hook learns the failing size and
+ * caller. Cleared by the matching heap_telemetry_record_alloc().
+ */
+void heap_telemetry_record_request(uintptr_t caller, size_t requested);
+
+/*
+ * Record a successful (usable > 0) or failed (usable == 0) allocation.
+ * requested is the size passed to malloc, usable the block's real size.
+ */
+void heap_telemetry_record_alloc(uintptr_t caller, size_t requested, size_t usable);
+
+/*
+ * Record a free of a block with the given usable size.
+ */
+void heap_telemetry_record_free(size_t usable);
+
+/*
+ * Copy the current counters, with the heaviest call sites first.
+ */
+void heap_telemetry_snapshot(heap_telemetry_snapshot_t *snapshot);
+
+/*
+ * Locked snapshot, provided by the malloc wrapper layer (posix_stubs.c on
+ * FreeRTOS, heap_telemetry_desktop.c on desktop).
+ * Returns: true on success
+ */
+bool heap_telemetry_capture(heap_telemetry_snapshot_t *snapshot);
+
+/*
+ * Format a snapshot as text, one line per emit() call (without newline).
+ * Uses only a stack buffer, so it is safe from the malloc-failed hook.
+ */
+void heap_telemetry_log(const heap_telemetry_snapshot_t *snapshot,
+                        void (*emit)(const char *line));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEAP_TELEMETRY_H */
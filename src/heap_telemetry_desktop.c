@@ -0,0 +1,118 @@
+/*
+ * heap_telemetry_desktop.c
+ *
+ * Desktop (Linux/glibc) counterpart of the FreeRTOS malloc wrappers:
+ * interposes malloc & co. with -Wl,--wrap and feeds heap_telemetry, so the
+ * same snapshot is available when running the real interpreter on a PC.
+ * Block sizes come from malloc_usable_size().
+ */
+
+#include "heap_telemetry.h"
+
+#include <malloc.h>
+#include <pthread.h>
+#include <string.h>
+
+void* __real_malloc(size_t size);
+void __real_free(void *ptr);
+void* __real_calloc(size_t num, size_t size);
+void* __real_realloc(void *ptr, size_t size);
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define HEAP_CALLER()  ((uintptr_t)__builtin_return_address(0))
+
+static void record_alloc(uintptr_t caller, size_t requested, void *ptr)
+{
+    size_t usable = ptr ? malloc_usable_size(ptr) : 0;
+
+    pthread_mutex_lock(&s_lock);
+    heap_telemetry_record_alloc(caller, requested, usable);
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void record_free(void *ptr)
+{
+    size_t usable = malloc_usable_size(ptr);
+
+    pthread_mutex_lock(&s_lock);
+    heap_telemetry_record_free(usable);
+    pthread_mutex_unlock(&s_lock);
+}
+
+bool heap_telemetry_capture(heap_telemetry_snapshot_t *snapshot)
+{
+    pthread_mutex_lock(&s_lock);
+    heap_telemetry_snapshot(snapshot);
+    pthread_mutex_unlock(&s_lock);
+    return true;
+}
+
+void* __wrap_malloc(size_t size)
+{
+    void *ptr = __real_malloc(size);
+    record_alloc(HEAP_CALLER(), size, ptr);
+    return ptr;
+}
+
+void __wrap_free(void *ptr)
+{
+    if (ptr) {
+        record_free(ptr);
+    }
+    __real_free(ptr);
+}
+
+void* __wrap_calloc(size_t num, size_t size)
+{
+    void *ptr = __real_calloc(num, size);
+    record_alloc(HEAP_CALLER(), num * size, ptr);
+    return ptr;
+}
+
+void* __wrap_realloc(void *ptr, size_t size)
+{
+    size_t old_usable = ptr ? malloc_usable_size(ptr) : 0;
+    void *new_ptr = __real_realloc(ptr, size);
+
+    if (size == 0 && ptr != NULL) {
+        pthread_mutex_lock(&s_lock);
+        heap_telemetry_record_free(old_usable);
+        pthread_mutex_unlock(&s_lock);
+        return new_ptr;
+    }
+
+    size_t usable = new_ptr ? malloc_usable_size(new_ptr) : 0;
+    pthread_mutex_lock(&s_lock);
+    if (ptr != NULL && new_ptr != NULL) {
+        heap_telemetry_record_free(old_usable);
+    }
+    heap_telemetry_record_alloc(HEAP_CALLER(), size, usable);
+    pthread_mutex_unlock(&s_lock);
+    return new_ptr;
+}
+
+/* glibc's strdup/strndup allocate internally, bypassing --wrap=malloc */
+
+char* __wrap_strdup(const char *s)
+{
+    size_t len = strlen(s) + 1;
+    char *dup = __real_malloc(len);
+    record_alloc(HEAP_CALLER(), len, dup);
+    if (dup) {
+        memcpy(dup, s, len);
+    }
+    return dup;
+}
+
+char* __wrap_strndup(const char *s, size_t n)
+{
+    size_t len = strnlen(s, n);
+    char *dup = __real_malloc(len + 1);
+    record_alloc(HEAP_CALLER(), len + 1, dup);
+    if (dup) {
+        memcpy(dup, s, len);
+        dup[len] = '\0';
+    }
+    return dup;
+}
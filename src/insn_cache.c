@@ -0,0 +1,216 @@
+/*
+ * insn_cache.c
+ *
+ * Decoded-instruction cache for the Z-machine interpreter loop.
+ */
+
+#include "insn_cache.h"
+
+#include <string.h>
+
+typedef struct {
+    const uint8_t *mem;
+    uint32_t size;
+    uint32_t pc;
+    int overrun;
+} decoder_t;
+
+static uint8_t next_byte(decoder_t *d)
+{
+    if (d->pc >= d->size) {
+        d->overrun = 1;
+        return 0;
+    }
+    return d->mem[d->pc++];
+}
+
+static uint16_t next_word(decoder_t *d)
+{
+    uint16_t high = next_byte(d);
+    return (uint16_t)((high << 8) | next_byte(d));
+}
+
+static int has_store(int version, int kind, int op)
+{
+    switch (kind) {
+    case INSN_2OP:
+        return (op >= 8 && op <= 9) || (op >= 15 && op <= 25);
+    case INSN_1OP:
+        return (op >= 1 && op <= 4) || op == 8 || op == 14 || (op == 15 && version <= 4);
+    case INSN_0OP:
+        return (op == 5 || op == 6) ? version == 4 : (op == 9 && version >= 5);
+    case INSN_VAR:
+        return op == 0 || op == 7 || op == 12 || op == 22 || op == 23 ||
+               (op == 4 && version >= 5) || (op == 24 && version >= 5);
+    default:
+        return op <= 4 || op == 9 || op == 10 || op == 12;
+    }
+}
+
+static int has_branch(int version, int kind, int op)
+{
+    switch (kind) {
+    case INSN_2OP:
+        return (op >= 1 && op <= 7) || op == 10;
+    case INSN_1OP:
+        return op <= 2;
+    case INSN_0OP:
+        return ((op == 5 || op == 6) && version <= 3) || op == 13 || op == 15;
+    case INSN_VAR:
+        return op == 23 || op == 31;
+    default:
+        return 0;
+    }
+}
+
+/* Append the operands described by one type byte */
+static void read_operands(decoder_t *d, uint8_t types, insn_record_t *record)
+{
+    for (int shift = 6; shift >= 0; shift -= 2) {
+        int type = (types >> shift) & 3;
+        if (type == 3 || record->operand_count == INSN_MAX_OPERANDS) {
+            break;
+        }
+        uint16_t value = type == INSN_TYPE_LARGE ? next_word(d) : next_byte(d);
+        record->operands[record->operand_count] = value;
+        record->operand_types |= (uint16_t)(type << (14 - 2 * record->operand_count));
+        record->operand_count++;
+    }
+}
+
+/* Skip an inline Z-string. Returns: address after its last word */
+static uint32_t skip_string(decoder_t *d)
+{
+    while (!d->overrun && !(next_word(d) & 0x8000)) {
+    }
+    return d->pc;
+}
+
+int insn_decode(const uint8_t *mem, uint32_t mem_size, int version, uint32_t pc,
+                insn_record_t *record)
+{
+    decoder_t d = { mem, mem_size, pc, 0 };
+    uint8_t opcode = next_byte(&d);
+    int kind, op;
+
+    memset(record, 0, sizeof(*record));
+    record->pc = pc;
+
+    if (opcode == 0xBE && version >= 5) {
+        kind = INSN_EXT;
+        op = next_byte(&d);
+        read_operands(&d, next_byte(&d), record);
+    } else if (opcode < 0x80) {
+        /* Long form: two operands, small constant or variable */
+        kind = INSN_2OP;
+        op = opcode & 0x1F;
+        uint8_t types = (uint8_t)(((opcode & 0x40) ? 0x80 : 0x40) |
+                                  ((opcode & 0x20) ? 0x20 : 0x10) | 0x0F);
+        read_operands(&d, types, record);
+    } else if (opcode < 0xC0) {
+        int type = (opcode >> 4) & 3;
+        op = opcode & 0x0F;
+        if (type == 3) {
+            kind = INSN_0OP;
+        } else {
+            kind = INSN_1OP;
+            read_operands(&d, (uint8_t)((type << 6) | 0x3F), record);
+        }
+    } else {
+        kind = (opcode & 0x20) ? INSN_VAR : INSN_2OP;
+        op = opcode & 0x1F;
+        if (kind == INSN_VAR && (op == 12 || op == 26)) {
+            /* call_vs2 / call_vn2: two type bytes, up to eight operands */
+            uint8_t types1 = next_byte(&d);
+            uint8_t types2 = next_byte(&d);
+            read_operands(&d, types1, record);
+            if (record->operand_count == 4) {
+                read_operands(&d, types2, record);
+            }
+        } else {
+            read_operands(&d, next_byte(&d), record);
+        }
+    }
+
+    record->kind = (uint8_t)kind;
+    record->number = (uint8_t)op;
+
+    if (has_store(version, kind, op)) {
+        record->store = next_byte(&d);
+        record->flags |= INSN_HAS_STORE;
+    }
+
+    if (has_branch(version, kind, op)) {
+        uint8_t b = next_byte(&d);
+        int32_t offset = b & 0x3F;
+        if (!(b & 0x40)) {
+            offset = (offset << 8) | next_byte(&d);
+            if (offset & 0x2000) {
+                offset -= 0x4000;
+            }
+        }
+        record->branch_offset = (int16_t)offset;
+        record->flags |= INSN_HAS_BRANCH | ((b & 0x80) ? INSN_BRANCH_ON_TRUE : 0);
+    }
+
+    /* print / print_ret carry their text inline */
+    if (kind == INSN_0OP && (op == 2 || op == 3)) {
+        record->text_addr = d.pc;
+        skip_string(&d);
+    }
+
+    record->next_pc = d.pc;
+    return d.overrun ? -1 : 0;
+}
+
+uint32_t insn_cache_slots_for_budget(size_t budget_bytes)
+{
+    return (uint32_t)(budget_bytes / sizeof(insn_record_t));
+}
+
+void insn_cache_init(insn_cache_t *cache, insn_record_t *slots, uint32_t slot_count,
+                     const uint8_t *mem, uint32_t mem_size, int version)
+{
+    cache->slots = slots;
+    cache->slot_count = slot_count;
+    cache->mem = mem;
+    cache->mem_size = mem_size;
+    cache->version = version;
+    cache->high_base = mem_size >= 6 ? (uint32_t)((mem[0x04] << 8) | mem[0x05]) : mem_size;
+    insn_cache_clear(cache);
+}
+
+void insn_cache_clear(insn_cache_t *cache)
+{
+    for (uint32_t i = 0; i < cache->slot_count; i++) {
+        cache->slots[i].pc = INSN_PC_NONE;
+    }
+    memset(&cache->stats, 0, sizeof(cache->stats));
+}
+
+const insn_record_t* insn_cache_fetch(insn_cache_t *cache, uint32_t pc)
+{
+    if (pc < cache->high_base || cache->slot_count == 0) {
+        cache->stats.uncached++;
+        if (insn_decode(cache->mem, cache->mem_size, cache->version, pc, &cache->scratch) != 0) {
+            return NULL;
+        }
+        return &cache->scratch;
+    }
+
+    insn_record_t *slot = &cache->slots[pc % cache->slot_count];
+    if (slot->pc == pc) {
+        cache->stats.hits++;
+        return slot;
+    }
+
+    if (slot->pc != INSN_PC_NONE) {
+        cache->stats.evictions++;
+    }
+    cache->stats.misses++;
+    if (insn_decode(cache->mem, cache->mem_size, cache->version, pc, slot) != 0) {
+        slot->pc = INSN_PC_NONE;
+        return NULL;
+    }
+    return slot;
+}
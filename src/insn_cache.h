@@ -0,0 +1,115 @@
+/*
+ * insn_cache.h
+ *
+ * Decoded-instruction cache for the Z-machine interpreter loop.
+ *
+ * High memory is immutable, so an instruction decodes the same way every
+ * time its PC comes round. insn_decode() turns the bytes at a PC into a
+ * record (form, opcode number, operand types and raw values, store
+ * variable, branch sense and offset, inline text span, next PC), and the
+ * cache keeps records in a direct-mapped table keyed by PC: filled on
+ * first execution, bounded by a caller-provided byte budget. Operands are
+ * kept raw, so variable operands are still read when the record executes.
+ * PCs below the high memory base are decoded every time, never cached.
+ *
+ * Not thread-safe: only the interpreter task runs code. Portable C, no
+ * allocation; tools/insn_cache_sim.c measures it on the host.
+ */
+
+#ifndef INSN_CACHE_H
+#define INSN_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INSN_MAX_OPERANDS   8
+#define INSN_PC_NONE        0xFFFFFFFFu
+
+/* Instruction kinds (operand count classes of the Z-machine spec) */
+#define INSN_0OP            0
+#define INSN_1OP            1
+#define INSN_2OP            2
+#define INSN_VAR            3
+#define INSN_EXT            4
+
+/* Operand types, two bits each in operand_types (first operand on top) */
+#define INSN_TYPE_LARGE     0
+#define INSN_TYPE_SMALL     1
+#define INSN_TYPE_VARIABLE  2
+
+/* Record flags */
+#define INSN_HAS_STORE      0x01u
+#define INSN_HAS_BRANCH     0x02u
+#define INSN_BRANCH_ON_TRUE 0x04u
+
+typedef struct {
+    uint32_t pc;                /* Key, INSN_PC_NONE for an empty slot */
+    uint32_t next_pc;           /* Address after the instruction (and its text) */
+    uint32_t text_addr;         /* Inline Z-string of print/print_ret, else 0 */
+    uint16_t operands[INSN_MAX_OPERANDS];   /* Constants, or variable numbers */
+    uint16_t operand_types;
+    int16_t branch_offset;      /* 0/1 return false/true, else next_pc + offset - 2 */
+    uint8_t kind;               /* INSN_0OP ... INSN_EXT */
+    uint8_t number;             /* Opcode number within its kind */
+    uint8_t operand_count;
+    uint8_t store;              /* Store variable (INSN_HAS_STORE) */
+    uint8_t flags;
+} insn_record_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;            /* Decoded and stored */
+    uint32_t uncached;          /* Below high memory: decoded, not stored */
+    uint32_t evictions;         /* Misses that replaced another PC */
+} insn_cache_stats_t;
+
+typedef struct {
+    insn_record_t *slots;
+    uint32_t slot_count;
+    const uint8_t *mem;
+    uint32_t mem_size;
+    uint32_t high_base;         /* Lowest cacheable PC */
+    int version;
+    insn_record_t scratch;      /* Result for uncached PCs */
+    insn_cache_stats_t stats;
+} insn_cache_t;
+
+/*
+ * Decode the instruction at pc from story memory mem (mem_size bytes).
+ * Returns: 0 on success, -1 if the instruction runs past the end of memory
+ */
+int insn_decode(const uint8_t *mem, uint32_t mem_size, int version, uint32_t pc,
+                insn_record_t *record);
+
+/*
+ * Returns: number of records that fit in budget_bytes
+ */
+uint32_t insn_cache_slots_for_budget(size_t budget_bytes);
+
+/*
+ * Set up an empty cache over caller-provided slots for the story in mem.
+ * The high memory base is read from the story header.
+ */
+void insn_cache_init(insn_cache_t *cache, insn_record_t *slots, uint32_t slot_count,
+                     const uint8_t *mem, uint32_t mem_size, int version);
+
+/*
+ * Forget all records (after loading a different story into mem).
+ */
+void insn_cache_clear(insn_cache_t *cache);
+
+/*
+ * Record for the instruction at pc, decoding it on a miss.
+ * Returns: record (valid until the next fetch), or NULL if it cannot be decoded
+ */
+const insn_record_t* insn_cache_fetch(insn_cache_t *cache, uint32_t pc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INSN_CACHE_H */
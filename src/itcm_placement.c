@@ -0,0 +1,30 @@
+/*
+ * itcm_placement.c
+ * Startup copy of profile-selected interpreter functions into ITCM
+ *
+ * The section and its symbols come from the linker fragment generated by
+ * tools/tcm_placement.py; this file is only built with FIZMO_TCM_PROFILE.
+ */
+
+#include "itcm_placement.h"
+
+#include <stdint.h>
+#include <string.h>
+
+extern uint32_t __zork_itcm_start[];
+extern uint32_t __zork_itcm_end[];
+extern const uint32_t __zork_itcm_load[];
+
+size_t zork_itcm_init(void)
+{
+    size_t size = (size_t)((uintptr_t)__zork_itcm_end - (uintptr_t)__zork_itcm_start);
+
+    if (size > 0) {
+        memcpy(__zork_itcm_start, __zork_itcm_load, size);
+        /* ITCM is not cached; just make sure the copy completes before
+         * the first instruction fetch from it */
+        __asm volatile ("dsb\n\tisb" ::: "memory");
+    }
+
+    return size;
+}
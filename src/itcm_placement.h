@@ -0,0 +1,27 @@
+/*
+ * itcm_placement.h
+ * Startup copy of profile-selected interpreter functions into ITCM
+ */
+
+#ifndef ITCM_PLACEMENT_H
+#define ITCM_PLACEMENT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Copy the .zork_itcm section from its flash load address to ITCM.
+ * Must run before any function listed in the generated zork_itcm.ld is
+ * called (i.e. before the Fizmo task starts).
+ * Returns: number of bytes copied
+ */
+size_t zork_itcm_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ITCM_PLACEMENT_H */
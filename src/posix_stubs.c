@@ -14,8 +14,20 @@
   #include <stdio.h>
   #include <stdlib.h>
   #include <string.h>
+  #include <stdint.h>
   #include <FreeRTOS.h>
 
+#include "posix_stubs.h"
+#ifdef FIZMO_POOL_ALLOC
+#include "fizmo_pool_alloc.h"
+#endif
+#ifdef FIZMO_HEAP_TELEMETRY
+#include "heap_telemetry.h"
+#endif
+#if defined(FIZMO_POOL_ALLOC) || defined(FIZMO_HEAP_TELEMETRY)
+#include <task.h>
+#endif
+
 static char newlib_heap[4096];  // Small region for stdio buffers, etc.
 static char *newlib_heap_end = newlib_heap;
 
@@ -37,20 +49,247 @@ void* _sbrk(ptrdiff_t incr) {
    * __attribute__((used)) prevents LTO from discarding these symbols.
    */
 
+/* Counters are updated outside the heap lock, so they are diagnostic only */
+static posix_heap_stats_t s_heap_stats;
+
+/*
+ * heap_4 keeps a BlockLink_t header in front of every block it hands out.
+ * Its xBlockSize (with the top "allocated" bit masked off) is the full
+ * block size including the header, which gives the usable capacity
+ * without any extra bookkeeping of our own.
+ */
+typedef struct heap_block_link {
+    struct heap_block_link *next_free;
+    size_t block_size;
+} heap_block_link_t;
+
+#define HEAP_BLOCK_ALLOCATED_BIT  (((size_t)1) << ((sizeof(size_t) * 8) - 1))
+#define HEAP_BLOCK_HEADER_SIZE \
+    ((sizeof(heap_block_link_t) + (portBYTE_ALIGNMENT - 1)) & ~((size_t)portBYTE_ALIGNMENT_MASK))
+
+static size_t heap_block_capacity(void *ptr)
+{
+    const heap_block_link_t *link =
+        (const heap_block_link_t *)((uint8_t *)ptr - HEAP_BLOCK_HEADER_SIZE);
+
+    configASSERT((link->block_size & HEAP_BLOCK_ALLOCATED_BIT) != 0);
+    return (link->block_size & ~HEAP_BLOCK_ALLOCATED_BIT) - HEAP_BLOCK_HEADER_SIZE;
+}
+
+#ifdef FIZMO_POOL_ALLOC
+/*
+ * Small requests (<= FIZMO_POOL_MAX_BLOCK) are served from fixed-block
+ * size-class pools in their own region, so libfizmo's strings, list nodes
+ * and z_file records neither fragment heap_4 nor suspend the scheduler.
+ * A pool operation is a few instructions, so masking interrupts is cheaper
+ * than heap_4's vTaskSuspendAll(). The _FROM_ISR variants save and restore
+ * the mask without touching the critical nesting count, which keeps them
+ * safe for allocations made before the scheduler starts.
+ */
+#ifndef FIZMO_POOL_REGION_SIZE
+#define FIZMO_POOL_REGION_SIZE  (64 * 1024)
+#endif
+
+static uint8_t s_pool_region[FIZMO_POOL_REGION_SIZE] __attribute__((aligned(8)));
+
+static void* pool_alloc(size_t size)
+{
+    void *ptr;
+
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    if (!fizmo_pool_ready()) {
+        fizmo_pool_init(s_pool_region, sizeof(s_pool_region));
+    }
+    ptr = fizmo_pool_alloc(size);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    return ptr;
+}
+#endif
+
+/* Raw block allocation (pool first when enabled), no statistics */
+static void* block_alloc(size_t size)
+{
+#ifdef FIZMO_POOL_ALLOC
+    if (size <= FIZMO_POOL_MAX_BLOCK) {
+        void *ptr = pool_alloc(size);
+        if (ptr) {
+            return ptr;
+        }
+    }
+#endif
+    return pvPortMalloc(size);
+}
+
+static void block_free(void *ptr)
+{
+#ifdef FIZMO_POOL_ALLOC
+    if (ptr && fizmo_pool_owns(ptr)) {
+        UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+        fizmo_pool_free(ptr);
+        taskEXIT_CRITICAL_FROM_ISR(mask);
+        return;
+    }
+#endif
+    vPortFree(ptr);
+}
+
+static size_t block_capacity(void *ptr)
+{
+#ifdef FIZMO_POOL_ALLOC
+    if (fizmo_pool_owns(ptr)) {
+        return fizmo_pool_block_size(ptr);
+    }
+#endif
+    return heap_block_capacity(ptr);
+}
+
+/* Call site recorded by telemetry: the return address of the wrapper */
+#define HEAP_CALLER()  ((uintptr_t)__builtin_return_address(0))
+
+#ifdef FIZMO_HEAP_TELEMETRY
+static void telemetry_request(uintptr_t caller, size_t requested)
+{
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    heap_telemetry_record_request(caller, requested);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+static void telemetry_alloc(uintptr_t caller, size_t requested, void *ptr)
+{
+    size_t usable = ptr ? block_capacity(ptr) : 0;
+
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    heap_telemetry_record_alloc(caller, requested, usable);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+static void telemetry_free(void *ptr)
+{
+    size_t usable = block_capacity(ptr);
+
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    heap_telemetry_record_free(usable);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+bool heap_telemetry_capture(heap_telemetry_snapshot_t *snapshot)
+{
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    heap_telemetry_snapshot(snapshot);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    return true;
+}
+#else
+#define telemetry_request(caller, requested)     ((void)(caller))
+#define telemetry_alloc(caller, requested, ptr)  ((void)(caller))
+#define telemetry_free(ptr)                      ((void)0)
+#endif
+
+static void* heap_malloc(size_t size, uintptr_t caller)
+{
+    telemetry_request(caller, size);
+    void *ptr = block_alloc(size);
+    if (ptr) {
+        s_heap_stats.malloc_count++;
+    }
+    telemetry_alloc(caller, size, ptr);
+    return ptr;
+}
+
+static void heap_free(void *ptr)
+{
+    if (ptr) {
+        s_heap_stats.free_count++;
+        telemetry_free(ptr);
+    }
+    block_free(ptr);
+}
+
+/*
+ * realloc on top of heap_4: stay in the current block whenever the new
+ * size fits its capacity (shrinking, or growing into the alignment and
+ * split slack heap_4 leaves), otherwise move and copy only the old
+ * contents.
+ */
+static void* heap_realloc(void *ptr, size_t size, uintptr_t caller)
+{
+    if (size == 0) {
+        heap_free(ptr);
+        return NULL;
+    }
+    if (ptr == NULL) {
+        return heap_malloc(size, caller);
+    }
+
+    s_heap_stats.realloc_count++;
+
+    size_t capacity = block_capacity(ptr);
+    if (size <= capacity) {
+        s_heap_stats.realloc_in_place++;
+        return ptr;
+    }
+
+    telemetry_request(caller, size);
+    void *new_ptr = block_alloc(size);
+    telemetry_alloc(caller, size, new_ptr);
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, capacity);
+        telemetry_free(ptr);
+        block_free(ptr);
+        s_heap_stats.realloc_moved++;
+        s_heap_stats.realloc_bytes_copied += capacity;
+    }
+    return new_ptr;
+}
+
+void posix_heap_get_stats(posix_heap_stats_t *stats)
+{
+    *stats = s_heap_stats;
+}
+
+void posix_heap_log_stats(void)
+{
+    printf("heap: %lu malloc, %lu free, %lu realloc (%lu in place, %lu moved, %lu bytes copied), "
+           "%lu bytes free (min %lu)\r\n",
+           (unsigned long)s_heap_stats.malloc_count,
+           (unsigned long)s_heap_stats.free_count,
+           (unsigned long)s_heap_stats.realloc_count,
+           (unsigned long)s_heap_stats.realloc_in_place,
+           (unsigned long)s_heap_stats.realloc_moved,
+           (unsigned long)s_heap_stats.realloc_bytes_copied,
+           (unsigned long)xPortGetFreeHeapSize(),
+           (unsigned long)xPortGetMinimumEverFreeHeapSize());
+
+#ifdef FIZMO_POOL_ALLOC
+    for (int i = 0; i < FIZMO_POOL_CLASS_COUNT; i++) {
+        fizmo_pool_class_stats_t pool;
+        fizmo_pool_get_stats(i, &pool);
+        printf("pool %3lu: %lu/%lu in use, peak %lu, %lu allocs, %lu fell back to heap\r\n",
+               (unsigned long)pool.block_size,
+               (unsigned long)pool.in_use,
+               (unsigned long)pool.total_blocks,
+               (unsigned long)pool.peak_in_use,
+               (unsigned long)pool.alloc_count,
+               (unsigned long)pool.exhausted_count);
+    }
+#endif
+}
+
   __attribute__((used))
   void* __wrap_malloc(size_t size) {
-      return pvPortMalloc(size);
+      return heap_malloc(size, HEAP_CALLER());
   }
 
   __attribute__((used))
   void __wrap_free(void* ptr) {
-      vPortFree(ptr);
+      heap_free(ptr);
   }
 
   __attribute__((used))
   void* __wrap_calloc(size_t num, size_t size) {
       size_t total = num * size;
-      void* ptr = pvPortMalloc(total);
+      void* ptr = heap_malloc(total, HEAP_CALLER());
       if (ptr) {
           memset(ptr, 0, total);
       }
@@ -59,20 +298,7 @@ void* _sbrk(ptrdiff_t incr) {
 
   __attribute__((used))
   void* __wrap_realloc(void* ptr, size_t size) {
-      // Simple implementation - allocate new, copy, free old
-      if (size == 0) {
-          vPortFree(ptr);
-          return NULL;
-      }
-      if (ptr == NULL) {
-          return pvPortMalloc(size);
-      }
-      void* new_ptr = pvPortMalloc(size);
-      if (new_ptr) {
-          memcpy(new_ptr, ptr, size);  // Note: may copy too much, but safe
-          vPortFree(ptr);
-      }
-      return new_ptr;
+      return heap_realloc(ptr, size, HEAP_CALLER());
   }
 
   /*
@@ -84,7 +310,7 @@ void* _sbrk(ptrdiff_t incr) {
   char* __wrap_strdup(const char* s) {
       if (s == NULL) return NULL;
       size_t len = strlen(s) + 1;
-      char* dup = pvPortMalloc(len);
+      char* dup = heap_malloc(len, HEAP_CALLER());
       if (dup) {
           memcpy(dup, s, len);
       }
@@ -95,7 +321,7 @@ void* _sbrk(ptrdiff_t incr) {
   char* __wrap_strndup(const char* s, size_t n) {
       if (s == NULL) return NULL;
       size_t len = strnlen(s, n);
-      char* dup = pvPortMalloc(len + 1);
+      char* dup = heap_malloc(len + 1, HEAP_CALLER());
       if (dup) {
           memcpy(dup, s, len);
           dup[len] = '\0';
@@ -145,20 +371,20 @@ int sigaction(int signum, const struct sigaction *act, struct sigaction *oldact)
 __attribute__((used))
 void* __wrap__malloc_r(struct _reent *r, size_t size) {
     (void)r;
-    return pvPortMalloc(size);
+    return heap_malloc(size, HEAP_CALLER());
 }
 
 __attribute__((used))
 void __wrap__free_r(struct _reent *r, void *ptr) {
     (void)r;
-    vPortFree(ptr);
+    heap_free(ptr);
 }
 
 __attribute__((used))
 void* __wrap__calloc_r(struct _reent *r, size_t num, size_t size) {
     (void)r;
     size_t total = num * size;
-    void* ptr = pvPortMalloc(total);
+    void* ptr = heap_malloc(total, HEAP_CALLER());
     if (ptr) memset(ptr, 0, total);
     return ptr;
 }
@@ -166,14 +392,7 @@ void* __wrap__calloc_r(struct _reent *r, size_t num, size_t size) {
 __attribute__((used))
 void* __wrap__realloc_r(struct _reent *r, void *ptr, size_t size) {
     (void)r;
-    if (size == 0) { vPortFree(ptr); return NULL; }
-    if (ptr == NULL) return pvPortMalloc(size);
-    void* new_ptr = pvPortMalloc(size);
-    if (new_ptr) {
-        memcpy(new_ptr, ptr, size);
-        vPortFree(ptr);
-    }
-    return new_ptr;
+    return heap_realloc(ptr, size, HEAP_CALLER());
 }
 
 #endif /* __ARM_EABI__ */
@@ -0,0 +1,39 @@
+/*
+ * posix_stubs.h
+ * Heap statistics from the malloc wrappers in posix_stubs.c (ARM builds)
+ */
+
+#ifndef POSIX_STUBS_H
+#define POSIX_STUBS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t malloc_count;          /* Successful malloc/calloc/strdup */
+    uint32_t free_count;            /* free of non-NULL pointers */
+    uint32_t realloc_count;         /* realloc of an existing block */
+    uint32_t realloc_in_place;      /* ...that fit in the current block */
+    uint32_t realloc_moved;         /* ...that needed a new block */
+    uint32_t realloc_bytes_copied;  /* Bytes memcpy'd by moved reallocs */
+} posix_heap_stats_t;
+
+/*
+ * Snapshot of the allocation counters since boot.
+ */
+void posix_heap_get_stats(posix_heap_stats_t *stats);
+
+/*
+ * Print the counters and FreeRTOS heap headroom to the UART
+ * (plus per-class pool occupancy with FIZMO_POOL_ALLOC).
+ */
+void posix_heap_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSIX_STUBS_H */
@@ -0,0 +1,47 @@
+/*
+ * sd_card_detect.c
+ *
+ * Debounced SD card-detect events.
+ * See sd_card_detect.h for the threading contract.
+ */
+
+#include "sd_card_detect.h"
+
+/* Written by the ISR */
+static volatile bool s_pending = false;
+static volatile bool s_level = false;
+static volatile uint32_t s_event_ms = 0;
+
+/* Task side: last state handed to the storage layer */
+static bool s_reported = false;
+
+void sd_card_detect_event(bool inserted, uint32_t now_ms)
+{
+    s_level = inserted;
+    s_event_ms = now_ms;
+    s_pending = true;
+}
+
+sd_cd_change_t sd_card_detect_poll(uint32_t now_ms, uint32_t debounce_ms)
+{
+    if (!s_pending) {
+        return SD_CD_NONE;
+    }
+
+    /* Clear first: an edge arriving after this point re-arms the flag */
+    s_pending = false;
+    bool level = s_level;
+    uint32_t event_ms = s_event_ms;
+
+    if (level && (uint32_t)(now_ms - event_ms) < debounce_ms) {
+        s_pending = true;   /* Still bouncing - look again next time */
+        return SD_CD_NONE;
+    }
+
+    if (level == s_reported) {
+        return SD_CD_NONE;  /* Bounced back to where it was */
+    }
+
+    s_reported = level;
+    return level ? SD_CD_INSERTED : SD_CD_REMOVED;
+}
@@ -0,0 +1,46 @@
+/*
+ * sd_card_detect.h
+ *
+ * Debounced SD card-detect events, decoupled from the SDK.
+ *
+ * The card-detect GPIO interrupt only records the new level and a
+ * timestamp. The storage layer polls for settled changes when it is about
+ * to touch the card, and mounts or unmounts there, so nothing runs in
+ * interrupt context and the interpreter never waits on a background mount.
+ * Plain C with the time passed in, so it builds and can be exercised on the
+ * host.
+ */
+
+#ifndef SD_CARD_DETECT_H
+#define SD_CARD_DETECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SD_CD_NONE = 0,     /* No settled change since the last poll */
+    SD_CD_INSERTED,     /* Card present for at least the debounce time */
+    SD_CD_REMOVED       /* Card gone (reported immediately) */
+} sd_cd_change_t;
+
+/*
+ * Record a card-detect edge. Safe from interrupt context.
+ */
+void sd_card_detect_event(bool inserted, uint32_t now_ms);
+
+/*
+ * Report a settled change once. Insertions are held back until the level
+ * has been stable for debounce_ms; removals are reported at once so I/O
+ * stops before a half-removed card is touched.
+ */
+sd_cd_change_t sd_card_detect_poll(uint32_t now_ms, uint32_t debounce_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SD_CARD_DETECT_H */
@@ -5,17 +5,30 @@
  */
 
 #include "sd_diskio.h"
+#include "sd_card_detect.h"
+#include "sd_transfer.h"
 #include "ff.h"
 #include "diskio.h"
 
 #include "fsl_sd.h"
+#include "fsl_cache.h"
 #include "sdmmc_config.h"
 
 #include <string.h>
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 /* SD card handle */
 static sd_card_t s_sd_card;
 static volatile int s_card_initialized = 0;
+static int s_host_initialized = 0;
+
+/* Write-coalescing / bounce buffer, one D-cache line aligned */
+static uint8_t s_stage[SD_TRANSFER_STAGE_SECTORS * FSL_SDMMC_DEFAULT_BLOCK_SIZE]
+    __attribute__((aligned(SD_TRANSFER_ALIGN)));
+static sd_transfer_t s_transfer;
+static uint32_t s_au_sectors = 1;
 
 /* Forward declarations */
 static DSTATUS SD_disk_initialize(BYTE lun);
@@ -36,22 +49,93 @@ const Diskio_drvTypeDef SD_Driver = {
 /* IRQ priority for SDMMC - must be >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY */
 #define SDMMC_IRQ_PRIORITY (5U)
 
+static uint32_t tick_ms_from_isr(void)
+{
+    return (uint32_t)(xTaskGetTickCountFromISR() * portTICK_PERIOD_MS);
+}
+
+/*
+ * Card-detect GPIO callback (interrupt context).
+ * Only records the edge; sd_init.c mounts/unmounts from task context.
+ * A removal stops disk I/O immediately so FatFS sees RES_NOTRDY rather
+ * than talking to a card that is half out of the slot.
+ */
+static void SD_Card_DetectCallback(bool isInserted, void *userData)
+{
+    (void)userData;
+
+    if (!isInserted) {
+        s_card_initialized = 0;
+    }
+    sd_card_detect_event(isInserted, tick_ms_from_isr());
+}
+
+static int transfer_read_blocks(void *ctx, uint8_t *buf, uint32_t sector, uint32_t count)
+{
+    return SD_ReadBlocks((sd_card_t *)ctx, buf, sector, count) == kStatus_Success ? 0 : -1;
+}
+
+static int transfer_write_blocks(void *ctx, const uint8_t *buf, uint32_t sector, uint32_t count)
+{
+    return SD_WriteBlocks((sd_card_t *)ctx, (uint8_t *)buf, sector, count) == kStatus_Success ? 0 : -1;
+}
+
+#if !(defined(FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL) && FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL)
+/* The uSDHC driver leaves cache maintenance to us */
+static void transfer_cache_clean(const void *addr, size_t size)
+{
+    DCACHE_CleanByRange((uint32_t)addr, (uint32_t)size);
+}
+
+static void transfer_cache_invalidate(void *addr, size_t size)
+{
+    DCACHE_InvalidateByRange((uint32_t)addr, (uint32_t)size);
+}
+#define TRANSFER_CACHE_CLEAN        transfer_cache_clean
+#define TRANSFER_CACHE_INVALIDATE   transfer_cache_invalidate
+#else
+#define TRANSFER_CACHE_CLEAN        NULL
+#define TRANSFER_CACHE_INVALIDATE   NULL
+#endif
+
+/* Allocation unit from the SD status register, for GET_BLOCK_SIZE */
+static uint32_t read_au_sectors(void)
+{
+    if (SD_ReadStatus(&s_sd_card) == kStatus_Success) {
+        uint32_t au = sd_transfer_au_sectors(s_sd_card.stat.auSize, s_sd_card.blockSize);
+        if (au > 1) {
+            return au;
+        }
+    }
+    /* CSD erase sector size (in write blocks), fixed at 64 KB for SDHC */
+    return (uint32_t)s_sd_card.csd.eraseSectorSize + 1;
+}
+
 int SD_Card_Init(void)
 {
     printf("[SD] SD_Card_Init entry\r\n");
 
-    /* Configure SD card with board-specific settings */
-    printf("[SD] Calling BOARD_SD_Config...\r\n");
-    BOARD_SD_Config(&s_sd_card, NULL, SDMMC_IRQ_PRIORITY, NULL);
-    printf("[SD] BOARD_SD_Config done\r\n");
+    if (s_card_initialized) {
+        return 0;
+    }
 
-    /* Initialize host controller */
-    printf("[SD] Calling SD_HostInit...\r\n");
-    if (SD_HostInit(&s_sd_card) != kStatus_Success) {
-        printf("[SD] Host init failed\r\n");
-        return -1;
+    /* Host and card-detect interrupt are set up once; the card is
+     * (re)initialized on every insertion */
+    if (!s_host_initialized) {
+        /* Configure SD card with board-specific settings */
+        printf("[SD] Calling BOARD_SD_Config...\r\n");
+        BOARD_SD_Config(&s_sd_card, SD_Card_DetectCallback, SDMMC_IRQ_PRIORITY, NULL);
+        printf("[SD] BOARD_SD_Config done\r\n");
+
+        /* Initialize host controller */
+        printf("[SD] Calling SD_HostInit...\r\n");
+        if (SD_HostInit(&s_sd_card) != kStatus_Success) {
+            printf("[SD] Host init failed\r\n");
+            return -1;
+        }
+        printf("[SD] SD_HostInit done\r\n");
+        s_host_initialized = 1;
     }
-    printf("[SD] SD_HostInit done\r\n");
 
     /* Check if card is present (non-blocking) */
     printf("[SD] Calling SD_IsCardPresent...\r\n");
@@ -72,16 +156,42 @@ int SD_Card_Init(void)
         return -2;
     }
 
+    static const sd_transfer_ops_t ops = {
+        transfer_read_blocks,
+        transfer_write_blocks,
+        TRANSFER_CACHE_CLEAN,
+        TRANSFER_CACHE_INVALIDATE,
+        &s_sd_card
+    };
+    sd_transfer_init(&s_transfer, &ops, s_stage, SD_TRANSFER_STAGE_SECTORS, s_sd_card.blockSize);
+    s_au_sectors = read_au_sectors();
+
     s_card_initialized = 1;
-    printf("[SD] Card initialized successfully\r\n");
+    printf("[SD] Card initialized successfully (AU %lu sectors)\r\n", (unsigned long)s_au_sectors);
     return 0;
 }
 
+void SD_Card_Deinit(void)
+{
+    s_card_initialized = 0;
+    sd_transfer_discard(&s_transfer);
+    if (s_host_initialized) {
+        /* Host and card-detect interrupt stay up for the next insertion */
+        SD_CardDeinit(&s_sd_card);
+    }
+}
+
 int SD_Card_IsInserted(void)
 {
     return s_card_initialized;
 }
 
+sd_cd_change_t SD_Card_PollDetect(void)
+{
+    uint32_t now_ms = (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    return sd_card_detect_poll(now_ms, BOARD_SDMMC_SD_CARD_DETECT_DEBOUNCE_DELAY_MS);
+}
+
 static DSTATUS SD_disk_initialize(BYTE lun)
 {
     (void)lun;
@@ -103,7 +213,7 @@ static DRESULT SD_disk_read(BYTE lun, BYTE *buff, DWORD sector, UINT count)
         return RES_NOTRDY;
     }
 
-    if (SD_ReadBlocks(&s_sd_card, buff, sector, count) != kStatus_Success) {
+    if (sd_transfer_read(&s_transfer, buff, sector, count) != 0) {
         return RES_ERROR;
     }
 
@@ -118,7 +228,7 @@ static DRESULT SD_disk_write(BYTE lun, const BYTE *buff, DWORD sector, UINT coun
         return RES_NOTRDY;
     }
 
-    if (SD_WriteBlocks(&s_sd_card, (uint8_t *)buff, sector, count) != kStatus_Success) {
+    if (sd_transfer_write(&s_transfer, buff, sector, count) != 0) {
         return RES_ERROR;
     }
 
@@ -135,8 +245,8 @@ static DRESULT SD_disk_ioctl(BYTE lun, BYTE cmd, void *buff)
 
     switch (cmd) {
         case CTRL_SYNC:
-            /* No buffering in our implementation */
-            return RES_OK;
+            /* Issue any coalesced write still held in the staging buffer */
+            return sd_transfer_sync(&s_transfer) == 0 ? RES_OK : RES_ERROR;
 
         case GET_SECTOR_COUNT:
             *(DWORD *)buff = s_sd_card.blockCount;
@@ -147,8 +257,8 @@ static DRESULT SD_disk_ioctl(BYTE lun, BYTE cmd, void *buff)
             return RES_OK;
 
         case GET_BLOCK_SIZE:
-            /* Erase block size in sectors (1 for SD cards) */
-            *(DWORD *)buff = 1;
+            /* Erase block (allocation unit) size in sectors */
+            *(DWORD *)buff = s_au_sectors;
             return RES_OK;
 
         default:
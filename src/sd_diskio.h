@@ -1,12 +1,16 @@
 /*
  * sd_diskio.h
  * SD card disk I/O driver for FatFS on RT1050
+ *
+ * Sector transfers go through sd_transfer.c: consecutive writes are
+ * coalesced until CTRL_SYNC and unaligned FatFS buffers are bounced.
  */
 
 #ifndef SD_DISKIO_H
 #define SD_DISKIO_H
 
 #include "ff_gen_drv.h"
+#include "sd_card_detect.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,12 +19,23 @@ extern "C" {
 /* SD card driver structure for FatFS */
 extern const Diskio_drvTypeDef SD_Driver;
 
-/* Initialize SD card hardware (call before FATFS_LinkDriver) */
+/*
+ * Initialize SD card hardware (call before FATFS_LinkDriver).
+ * The first call also sets up the host and the card-detect interrupt;
+ * later calls only initialize a newly inserted card.
+ * Returns 0 on success, -1 host init failed, -2 card init failed, -3 no card
+ */
 int SD_Card_Init(void);
 
+/* Deinitialize the card after removal (host stays up) */
+void SD_Card_Deinit(void);
+
 /* Check if card is inserted */
 int SD_Card_IsInserted(void);
 
+/* Task context: settled card-detect change since the last poll, if any */
+sd_cd_change_t SD_Card_PollDetect(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,16 @@
 /*
  * sd_init.c
  * SD card initialization for Zork save/restore
+ *
+ * Single owner of the FatFS volume: the FATFS object, the mount state and
+ * the saves directory live here, and every other module goes through this
+ * API instead of calling f_mount() itself.
+ *
+ * Hot-plug is lazy: the card-detect interrupt only records the edge, and
+ * the next sd_filesystem_available() call (i.e. the next save, restore or
+ * lastfn access) mounts a newly inserted card or drops a removed one.
+ * Nothing polls in the background and the interpreter never waits on a
+ * mount it did not ask for.
  */
 
 #include "sd_init.h"
@@ -10,7 +20,10 @@
 
 #include <stdio.h>
 
-/* FatFS objects */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FatFS objects (the only FATFS in the application) */
 static FATFS s_fatfs;
 static char s_drive_path[4];
 static int s_initialized = 0;
@@ -23,8 +36,14 @@ int sd_filesystem_init(void)
         return 0;  /* Already initialized */
     }
 
+    TickType_t start_tick = xTaskGetTickCount();
+
     /* Initialize SD card hardware */
     ret = SD_Card_Init();
+    if (ret == -3) {
+        printf("SD card not detected\r\n");
+        return -2;  /* Mounted later if a card is inserted */
+    }
     if (ret != 0) {
         printf("SD card init failed: %d\r\n", ret);
         return -1;
@@ -50,17 +69,54 @@ int sd_filesystem_init(void)
         return -4;
     }
 
-    printf("SD card mounted at %s\r\n", s_drive_path);
+    /* Ensure saves directory exists */
+    fres = f_mkdir(SD_SAVES_DIR);
+    if (fres != FR_OK && fres != FR_EXIST) {
+        printf("f_mkdir %s failed: %d\r\n", SD_SAVES_DIR, fres);
+    }
+
+    printf("SD card mounted at %s in %lu ms (FATFS %u bytes)\r\n", s_drive_path,
+           (unsigned long)((xTaskGetTickCount() - start_tick) * portTICK_PERIOD_MS),
+           (unsigned)sizeof(s_fatfs));
     s_initialized = 1;
 
     return 0;
 }
 
+/* Apply a settled card-detect change, if one is pending */
+static void sd_filesystem_refresh(void)
+{
+    switch (SD_Card_PollDetect()) {
+        case SD_CD_INSERTED:
+            if (!s_initialized) {
+                printf("SD card inserted\r\n");
+                sd_filesystem_init();
+            }
+            break;
+
+        case SD_CD_REMOVED:
+            if (s_initialized) {
+                printf("SD card removed\r\n");
+                sd_filesystem_deinit();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
 int sd_filesystem_available(void)
 {
+    sd_filesystem_refresh();
     return s_initialized;
 }
 
+int sd_card_present(void)
+{
+    return SD_Card_IsInserted() ? 1 : 0;
+}
+
 void sd_filesystem_deinit(void)
 {
     if (!s_initialized) {
@@ -69,5 +125,6 @@ void sd_filesystem_deinit(void)
 
     f_mount(NULL, s_drive_path, 0);
     FATFS_UnLinkDriver(s_drive_path);
+    SD_Card_Deinit();
     s_initialized = 0;
 }
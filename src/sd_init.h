@@ -1,6 +1,13 @@
 /*
  * sd_init.h
  * SD card initialization for Zork save/restore
+ *
+ * This module is the volume manager: it owns the one FATFS object and the
+ * mount state. Other modules check sd_filesystem_available() and use plain
+ * FatFS file calls; none of them mount on their own.
+ *
+ * Card insertion and removal are picked up lazily by
+ * sd_filesystem_available() from the card-detect interrupt's record.
  */
 
 #ifndef SD_INIT_H
@@ -10,11 +17,15 @@
 extern "C" {
 #endif
 
+/* Directory for save files, created on mount */
+#define SD_SAVES_DIR    "/saves"
+
 /*
- * Initialize SD card and mount filesystem.
+ * Initialize SD card, mount filesystem and create SD_SAVES_DIR.
+ * Safe to call again once mounted (returns 0).
  * Returns 0 on success, negative on failure:
  *   -1: SD card init failed
- *   -2: Card not detected
+ *   -2: Card not detected (mounted later on insertion)
  *   -3: FatFS link driver failed
  *   -4: FatFS mount failed
  */
@@ -22,9 +33,16 @@ int sd_filesystem_init(void);
 
 /*
  * Check if SD filesystem is available for save/restore.
+ * Applies any pending card-detect change first: mounts a card inserted
+ * since the last call (after debounce) or unmounts a removed one.
  */
 int sd_filesystem_available(void);
 
+/*
+ * Check card-detect (independent of mount state).
+ */
+int sd_card_present(void);
+
 /*
  * Unmount and deinitialize (optional, for clean shutdown).
  */
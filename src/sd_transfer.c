@@ -0,0 +1,178 @@
+/*
+ * sd_transfer.c
+ *
+ * Write coalescing and aligned bounce buffers for SD sector transfers.
+ * See sd_transfer.h for the flushing rules.
+ */
+
+#include "sd_transfer.h"
+
+#include <string.h>
+
+static bool is_aligned(const void *ptr)
+{
+    return ((uintptr_t)ptr & (SD_TRANSFER_ALIGN - 1)) == 0;
+}
+
+static int driver_read(sd_transfer_t *xfer, uint8_t *buf, uint32_t sector, uint32_t count)
+{
+    size_t bytes = (size_t)count * xfer->sector_size;
+
+    /* Drop cached lines over the DMA target so an eviction cannot overwrite it */
+    if (xfer->ops.cache_invalidate) {
+        xfer->ops.cache_invalidate(buf, bytes);
+    }
+    xfer->stats.read_commands++;
+    if (xfer->ops.read_blocks(xfer->ops.ctx, buf, sector, count) != 0) {
+        xfer->stats.errors++;
+        return -1;
+    }
+    /* Drop lines speculatively refilled while the DMA ran */
+    if (xfer->ops.cache_invalidate) {
+        xfer->ops.cache_invalidate(buf, bytes);
+    }
+    xfer->stats.sectors_read += count;
+    return 0;
+}
+
+static int driver_write(sd_transfer_t *xfer, const uint8_t *buf, uint32_t sector, uint32_t count)
+{
+    if (xfer->ops.cache_clean) {
+        xfer->ops.cache_clean(buf, (size_t)count * xfer->sector_size);
+    }
+    xfer->stats.write_commands++;
+    if (xfer->ops.write_blocks(xfer->ops.ctx, buf, sector, count) != 0) {
+        xfer->stats.errors++;
+        return -1;
+    }
+    xfer->stats.sectors_written += count;
+    return 0;
+}
+
+void sd_transfer_init(sd_transfer_t *xfer, const sd_transfer_ops_t *ops,
+                      uint8_t *stage, uint32_t stage_sectors, uint32_t sector_size)
+{
+    memset(xfer, 0, sizeof(*xfer));
+    xfer->ops = *ops;
+    xfer->stage = stage;
+    xfer->stage_sectors = stage_sectors;
+    xfer->sector_size = sector_size;
+}
+
+int sd_transfer_sync(sd_transfer_t *xfer)
+{
+    if (xfer->pending_count == 0) {
+        return 0;
+    }
+
+    uint32_t start = xfer->pending_start;
+    uint32_t count = xfer->pending_count;
+    xfer->pending_count = 0;
+    return driver_write(xfer, xfer->stage, start, count);
+}
+
+void sd_transfer_discard(sd_transfer_t *xfer)
+{
+    xfer->pending_count = 0;
+}
+
+int sd_transfer_read(sd_transfer_t *xfer, uint8_t *buf, uint32_t sector, uint32_t count)
+{
+    /* Staged writes must reach the card before an overlapping read */
+    if (xfer->pending_count != 0 &&
+        sector < xfer->pending_start + xfer->pending_count &&
+        xfer->pending_start < sector + count) {
+        if (sd_transfer_sync(xfer) != 0) {
+            return -1;
+        }
+    }
+
+    if (is_aligned(buf)) {
+        return driver_read(xfer, buf, sector, count);
+    }
+
+    /* Unaligned: read through the staging buffer in multi-block chunks.
+     * Non-overlapping staged writes can stay; flush them first so the
+     * buffer is free. */
+    if (sd_transfer_sync(xfer) != 0) {
+        return -1;
+    }
+    while (count > 0) {
+        uint32_t chunk = count < xfer->stage_sectors ? count : xfer->stage_sectors;
+        size_t bytes = (size_t)chunk * xfer->sector_size;
+
+        if (driver_read(xfer, xfer->stage, sector, chunk) != 0) {
+            return -1;
+        }
+        memcpy(buf, xfer->stage, bytes);
+        xfer->stats.bounced_sectors += chunk;
+
+        buf += bytes;
+        sector += chunk;
+        count -= chunk;
+    }
+    return 0;
+}
+
+int sd_transfer_write(sd_transfer_t *xfer, const uint8_t *buf, uint32_t sector, uint32_t count)
+{
+    /* A run that does not continue the staged one is flushed first */
+    if (xfer->pending_count != 0 &&
+        sector != xfer->pending_start + xfer->pending_count) {
+        if (sd_transfer_sync(xfer) != 0) {
+            return -1;
+        }
+    }
+
+    /* Large aligned writes gain nothing from staging */
+    if (count >= xfer->stage_sectors && is_aligned(buf)) {
+        if (sd_transfer_sync(xfer) != 0) {
+            return -1;
+        }
+        return driver_write(xfer, buf, sector, count);
+    }
+
+    if (xfer->pending_count != 0) {
+        xfer->stats.coalesced_writes++;
+    }
+    if (!is_aligned(buf)) {
+        xfer->stats.bounced_sectors += count;
+    }
+
+    while (count > 0) {
+        if (xfer->pending_count == 0) {
+            xfer->pending_start = sector;
+        }
+        uint32_t room = xfer->stage_sectors - xfer->pending_count;
+        uint32_t chunk = count < room ? count : room;
+        size_t bytes = (size_t)chunk * xfer->sector_size;
+
+        memcpy(xfer->stage + (size_t)xfer->pending_count * xfer->sector_size, buf, bytes);
+        xfer->pending_count += chunk;
+
+        buf += bytes;
+        sector += chunk;
+        count -= chunk;
+
+        if (xfer->pending_count == xfer->stage_sectors) {
+            if (sd_transfer_sync(xfer) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+uint32_t sd_transfer_au_sectors(uint8_t au_size_code, uint32_t sector_size)
+{
+    /* SD Physical Layer spec, SD Status AU_SIZE: 16 KB .. 64 MB in KB */
+    static const uint32_t au_kb[16] = {
+        0, 16, 32, 64, 128, 256, 512, 1024,
+        2048, 4096, 8192, 12288, 16384, 24576, 32768, 65536
+    };
+
+    if (au_size_code >= 16 || au_kb[au_size_code] == 0 || sector_size == 0) {
+        return 1;
+    }
+    return (uint32_t)((au_kb[au_size_code] * 1024u) / sector_size);
+}
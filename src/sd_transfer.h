@@ -0,0 +1,111 @@
+/*
+ * sd_transfer.h
+ *
+ * Sector transfer layer between FatFS and the SD block driver.
+ *
+ * - Consecutive sector writes are gathered in an aligned staging buffer
+ *   and issued as one multi-block write when the run breaks, the buffer
+ *   fills, an overlapping read arrives or FatFS sends CTRL_SYNC.
+ * - Buffers that are not SD_TRANSFER_ALIGN-aligned are bounced through
+ *   the staging buffer, so DMA and cache maintenance never touch cache
+ *   lines shared with neighbouring data.
+ * - Aligned buffers go straight to the driver as one multi-block command,
+ *   with clean-before-write and invalidate-after-read.
+ *
+ * The block driver and cache operations are callbacks, so the same code
+ * runs over fsl_sd on the board and over a RAM disk on the host
+ * (see tools/sd_transfer_bench.c). Not thread-safe: FatFS serializes
+ * calls per volume.
+ */
+
+#ifndef SD_TRANSFER_H
+#define SD_TRANSFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cortex-M7 D-cache line; DMA buffers must not share a line with anything else */
+#define SD_TRANSFER_ALIGN       32
+
+/* Staging buffer size in sectors (override with -DSD_TRANSFER_STAGE_SECTORS) */
+#ifndef SD_TRANSFER_STAGE_SECTORS
+#define SD_TRANSFER_STAGE_SECTORS   8
+#endif
+
+typedef struct {
+    /* Block driver: return 0 on success */
+    int (*read_blocks)(void *ctx, uint8_t *buf, uint32_t sector, uint32_t count);
+    int (*write_blocks)(void *ctx, const uint8_t *buf, uint32_t sector, uint32_t count);
+    /* D-cache maintenance, NULL when the buffer memory is not cached */
+    void (*cache_clean)(const void *addr, size_t size);
+    void (*cache_invalidate)(void *addr, size_t size);
+    void *ctx;
+} sd_transfer_ops_t;
+
+typedef struct {
+    uint32_t read_commands;     /* Driver read calls */
+    uint32_t write_commands;    /* Driver write calls */
+    uint32_t sectors_read;
+    uint32_t sectors_written;
+    uint32_t bounced_sectors;   /* Sectors copied because the caller's buffer was unaligned */
+    uint32_t coalesced_writes;  /* FatFS write requests merged into an earlier command */
+    uint32_t errors;
+} sd_transfer_stats_t;
+
+typedef struct {
+    sd_transfer_ops_t ops;
+    uint8_t *stage;             /* SD_TRANSFER_ALIGN-aligned, stage_sectors * sector_size */
+    uint32_t stage_sectors;
+    uint32_t sector_size;
+    uint32_t pending_start;     /* First sector held in stage */
+    uint32_t pending_count;     /* 0 = nothing staged */
+    sd_transfer_stats_t stats;
+} sd_transfer_t;
+
+/*
+ * Set up a transfer layer over caller-provided staging storage.
+ * stage must be SD_TRANSFER_ALIGN-aligned and hold stage_sectors sectors.
+ */
+void sd_transfer_init(sd_transfer_t *xfer, const sd_transfer_ops_t *ops,
+                      uint8_t *stage, uint32_t stage_sectors, uint32_t sector_size);
+
+/*
+ * Read count sectors into buf (any alignment).
+ * Returns: 0 on success, -1 on driver error
+ */
+int sd_transfer_read(sd_transfer_t *xfer, uint8_t *buf, uint32_t sector, uint32_t count);
+
+/*
+ * Write count sectors from buf (any alignment). May be held in the staging
+ * buffer until sd_transfer_sync().
+ * Returns: 0 on success, -1 on driver error
+ */
+int sd_transfer_write(sd_transfer_t *xfer, const uint8_t *buf, uint32_t sector, uint32_t count);
+
+/*
+ * Issue any staged write (FatFS CTRL_SYNC).
+ * Returns: 0 on success, -1 on driver error
+ */
+int sd_transfer_sync(sd_transfer_t *xfer);
+
+/*
+ * Drop staged data without writing it (card removed).
+ */
+void sd_transfer_discard(sd_transfer_t *xfer);
+
+/*
+ * Convert the SD status register AU_SIZE code to sectors.
+ * Returns: allocation unit in sectors, or 1 if the code is not defined
+ */
+uint32_t sd_transfer_au_sectors(uint8_t au_size_code, uint32_t sector_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SD_TRANSFER_H */
@@ -0,0 +1,151 @@
+/*
+ * story_blocks.c
+ *
+ * Block-compressed story image reader and LZ4 block decoder.
+ * See story_blocks.h and tools/story_pack.py for the format.
+ */
+
+#include "story_blocks.h"
+
+#include <string.h>
+
+#define HEADER_SIZE     16
+#define FORMAT_VERSION  1
+
+static uint32_t read_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t block_offset(const story_blocks_t *blocks, uint32_t index)
+{
+    return read_le32(blocks->offsets + 4u * index);
+}
+
+bool story_blocks_is_packed(const uint8_t *data, size_t size)
+{
+    return size >= HEADER_SIZE && memcmp(data, "ZSTB", 4) == 0;
+}
+
+int story_blocks_open(story_blocks_t *blocks, const uint8_t *image, size_t image_size)
+{
+    if (!story_blocks_is_packed(image, image_size) || image[4] != FORMAT_VERSION ||
+        image[5] < 10 || image[5] > 12) {
+        return -1;
+    }
+
+    blocks->image = image;
+    blocks->image_size = image_size;
+    blocks->block_size = 1u << image[5];
+    blocks->story_size = read_le32(image + 8);
+    blocks->block_count = read_le32(image + 12);
+    blocks->offsets = image + HEADER_SIZE;
+
+    if (blocks->block_count != (blocks->story_size + blocks->block_size - 1) / blocks->block_size ||
+        HEADER_SIZE + 4u * ((size_t)blocks->block_count + 1) > image_size) {
+        return -1;
+    }
+
+    /* Offsets must be ascending and inside the image */
+    for (uint32_t i = 0; i < blocks->block_count; i++) {
+        if (block_offset(blocks, i) > block_offset(blocks, i + 1)) {
+            return -1;
+        }
+    }
+    if (block_offset(blocks, blocks->block_count) > image_size) {
+        return -1;
+    }
+    return 0;
+}
+
+int story_blocks_decode(const story_blocks_t *blocks, uint32_t index, uint8_t *dest)
+{
+    if (index >= blocks->block_count) {
+        return -1;
+    }
+
+    uint32_t start = block_offset(blocks, index);
+    uint32_t packed_size = block_offset(blocks, index + 1) - start;
+    uint32_t size = blocks->story_size - index * blocks->block_size;
+    if (size > blocks->block_size) {
+        size = blocks->block_size;
+    }
+
+    if (packed_size == size) {
+        memcpy(dest, blocks->image + start, size);  /* Stored raw */
+        return (int)size;
+    }
+
+    int decoded = story_lz4_decode(blocks->image + start, packed_size, dest, size);
+    return decoded == (int)size ? decoded : -1;
+}
+
+int story_blocks_read_page(void *ctx, uint32_t offset, uint8_t *dest, uint32_t size)
+{
+    const story_blocks_t *blocks = (const story_blocks_t *)ctx;
+
+    if ((offset & (blocks->block_size - 1)) != 0 || size > blocks->block_size) {
+        return -1;
+    }
+    int decoded = story_blocks_decode(blocks, offset / blocks->block_size, dest);
+    return (decoded >= 0 && (uint32_t)decoded >= size) ? 0 : -1;
+}
+
+static int read_length(const uint8_t **src, const uint8_t *end, size_t *length)
+{
+    uint8_t b;
+    do {
+        if (*src >= end) {
+            return -1;
+        }
+        b = *(*src)++;
+        *length += b;
+    } while (b == 255);
+    return 0;
+}
+
+int story_lz4_decode(const uint8_t *src, size_t src_size, uint8_t *dest, size_t dest_capacity)
+{
+    const uint8_t *end = src + src_size;
+    uint8_t *out = dest;
+    uint8_t *out_end = dest + dest_capacity;
+
+    while (src < end) {
+        uint8_t token = *src++;
+
+        size_t literals = token >> 4;
+        if (literals == 15 && read_length(&src, end, &literals) != 0) {
+            return -1;
+        }
+        if (literals > (size_t)(end - src) || literals > (size_t)(out_end - out)) {
+            return -1;
+        }
+        memcpy(out, src, literals);
+        src += literals;
+        out += literals;
+
+        if (src >= end) {
+            break;      /* Last sequence has no match */
+        }
+
+        if (end - src < 2) {
+            return -1;
+        }
+        size_t offset = (size_t)src[0] | ((size_t)src[1] << 8);
+        src += 2;
+        size_t match = (size_t)(token & 15) + 4;
+        if ((token & 15) == 15 && read_length(&src, end, &match) != 0) {
+            return -1;
+        }
+        if (offset == 0 || offset > (size_t)(out - dest) || match > (size_t)(out_end - out)) {
+            return -1;
+        }
+
+        /* Byte copy: overlapping matches (offset < match) repeat a pattern */
+        const uint8_t *from = out - offset;
+        while (match--) {
+            *out++ = *from++;
+        }
+    }
+    return (int)(out - dest);
+}
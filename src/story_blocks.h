@@ -0,0 +1,71 @@
+/*
+ * story_blocks.h
+ *
+ * Reader for block-compressed story images made by tools/story_pack.py.
+ *
+ * The image is a header, a block offset table and independently
+ * compressed LZ4 blocks of 1-4 KB, so any part of the story can be
+ * decoded without touching the rest. story_blocks_read_page() matches
+ * story_page_read_fn: with a page size equal to the block size, a
+ * story_page_cache_t over it is a decompressed-block cache.
+ *
+ * The image stays in flash and is never written. Portable C.
+ */
+
+#ifndef STORY_BLOCKS_H
+#define STORY_BLOCKS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STORY_BLOCKS_MAX_SIZE   4096
+
+typedef struct {
+    const uint8_t *image;
+    size_t image_size;
+    uint32_t story_size;        /* Uncompressed */
+    uint32_t block_size;
+    uint32_t block_count;
+    const uint8_t *offsets;     /* block_count + 1 little-endian u32 */
+} story_blocks_t;
+
+/*
+ * Returns: true if data starts with the packed image magic
+ */
+bool story_blocks_is_packed(const uint8_t *data, size_t size);
+
+/*
+ * Validate the header and offset table.
+ * Returns: 0 on success, -1 if the image is not a valid packed story
+ */
+int story_blocks_open(story_blocks_t *blocks, const uint8_t *image, size_t image_size);
+
+/*
+ * Decode one block into dest (at least block_size bytes).
+ * Returns: decoded size, or -1 on corrupt data
+ */
+int story_blocks_decode(const story_blocks_t *blocks, uint32_t index, uint8_t *dest);
+
+/*
+ * story_page_read_fn adapter: ctx is the story_blocks_t, offset must be
+ * block-aligned and size at most one block.
+ * Returns: 0 on success, -1 on error
+ */
+int story_blocks_read_page(void *ctx, uint32_t offset, uint8_t *dest, uint32_t size);
+
+/*
+ * Decode an LZ4 block (no frame) with bounds checks on both buffers.
+ * Returns: decoded size, or -1 on corrupt input or output overflow
+ */
+int story_lz4_decode(const uint8_t *src, size_t src_size, uint8_t *dest, size_t dest_capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STORY_BLOCKS_H */
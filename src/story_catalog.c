@@ -0,0 +1,160 @@
+/*
+ * story_catalog.c
+ *
+ * Multi-story catalog reader.
+ * See story_catalog.h and tools/story_catalog.py for the format.
+ */
+
+#include "story_catalog.h"
+
+#include <string.h>
+
+#define HEADER_SIZE     8
+#define ENTRY_SIZE      48
+#define FORMAT_VERSION  1
+
+/* Entry field offsets */
+#define E_NAME          0
+#define E_OFFSET        24
+#define E_SIZE          28
+#define E_RELEASE       32
+#define E_CHECKSUM      34
+#define E_SERIAL        36
+#define E_VERSION       42
+#define E_FLAGS         43
+
+/* Story header fields (big-endian, Z-machine standard section 11) */
+#define H_VERSION       0x00
+#define H_RELEASE       0x02
+#define H_SERIAL        0x12
+#define H_CHECKSUM      0x1C
+#define H_MIN_SIZE      64
+
+static uint16_t read_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static bool is_packed_story(const uint8_t *data, size_t size)
+{
+    return size >= 4 && memcmp(data, "ZSTB", 4) == 0;
+}
+
+/*
+ * Fill the header-derived fields from a raw story.
+ * Returns: 0 on success, -1 if data is not a Z-machine story
+ */
+static int read_story_header(const uint8_t *data, size_t size, story_catalog_entry_t *entry)
+{
+    if (size < H_MIN_SIZE || data[H_VERSION] < 1 || data[H_VERSION] > 8) {
+        return -1;
+    }
+    entry->version = data[H_VERSION];
+    entry->release = read_be16(data + H_RELEASE);
+    entry->checksum = read_be16(data + H_CHECKSUM);
+    memcpy(entry->serial, data + H_SERIAL, 6);
+    entry->serial[6] = '\0';
+    return 0;
+}
+
+bool story_catalog_is_catalog(const uint8_t *data, size_t size)
+{
+    return size >= HEADER_SIZE && memcmp(data, "ZCAT", 4) == 0;
+}
+
+int story_catalog_open(story_catalog_t *catalog, const uint8_t *image, size_t image_size)
+{
+    memset(catalog, 0, sizeof(*catalog));
+    if (image == NULL || image_size == 0) {
+        return -1;
+    }
+    catalog->image = image;
+    catalog->image_size = image_size;
+
+    if (!story_catalog_is_catalog(image, image_size)) {
+        catalog->count = 1;
+        return 0;
+    }
+
+    uint16_t count = read_le16(image + 6);
+    if (image[4] != FORMAT_VERSION || image[5] != ENTRY_SIZE || count == 0 ||
+        HEADER_SIZE + (size_t)count * ENTRY_SIZE > image_size) {
+        return -1;
+    }
+    catalog->entries = image + HEADER_SIZE;
+    catalog->count = count;
+
+    /* Check everything once here so story_catalog_get() needs no checks */
+    for (uint16_t i = 0; i < count; i++) {
+        const uint8_t *e = catalog->entries + (size_t)i * ENTRY_SIZE;
+        uint32_t offset = read_le32(e + E_OFFSET);
+        uint32_t size = read_le32(e + E_SIZE);
+        if (memchr(e + E_NAME, '\0', STORY_CATALOG_NAME_MAX) == NULL ||
+            offset > image_size || size > image_size - offset || size == 0) {
+            return -1;
+        }
+        if (e[E_FLAGS] & STORY_CATALOG_FLAG_PACKED) {
+            if (!is_packed_story(image + offset, size)) {
+                return -1;
+            }
+        } else {
+            story_catalog_entry_t header;
+            if (read_story_header(image + offset, size, &header) != 0 ||
+                header.version != e[E_VERSION] ||
+                header.release != read_le16(e + E_RELEASE) ||
+                header.checksum != read_le16(e + E_CHECKSUM)) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+uint16_t story_catalog_count(const story_catalog_t *catalog)
+{
+    return catalog->count;
+}
+
+int story_catalog_get(const story_catalog_t *catalog, uint16_t index,
+                      story_catalog_entry_t *entry)
+{
+    if (index >= catalog->count) {
+        return -1;
+    }
+    memset(entry, 0, sizeof(*entry));
+
+    if (catalog->entries == NULL) {
+        /* Plain story or packed image: header fields only when readable */
+        entry->name = "story";
+        entry->data = catalog->image;
+        entry->size = (uint32_t)catalog->image_size;
+        if (is_packed_story(catalog->image, catalog->image_size)) {
+            entry->flags = STORY_CATALOG_FLAG_PACKED;
+        } else {
+            read_story_header(catalog->image, catalog->image_size, entry);
+        }
+        return 0;
+    }
+
+    const uint8_t *e = catalog->entries + (size_t)index * ENTRY_SIZE;
+    entry->name = (const char *)(e + E_NAME);
+    entry->data = catalog->image + read_le32(e + E_OFFSET);
+    entry->size = read_le32(e + E_SIZE);
+    entry->release = read_le16(e + E_RELEASE);
+    entry->checksum = read_le16(e + E_CHECKSUM);
+    memcpy(entry->serial, e + E_SERIAL, 6);
+    entry->serial[6] = '\0';
+    entry->version = e[E_VERSION];
+    entry->flags = e[E_FLAGS];
+    return 0;
+}
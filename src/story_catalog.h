@@ -0,0 +1,75 @@
+/*
+ * story_catalog.h
+ *
+ * Reader for multi-story images made by tools/story_catalog.py.
+ *
+ * The image is a header and a table of fixed-size entries followed by the
+ * story files, so entry i sits at a computed address: story_catalog_get()
+ * is O(1) and nothing is copied at boot. Each entry carries the picker
+ * name and the release/serial/checksum from the story header.
+ *
+ * An image without the catalog magic (a plain story file or a single
+ * story_pack.py image) opens as a one-entry catalog named "story", so
+ * single-story builds need no catalog step. Portable C.
+ */
+
+#ifndef STORY_CATALOG_H
+#define STORY_CATALOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STORY_CATALOG_NAME_MAX      24      /* Including the terminator */
+#define STORY_CATALOG_FLAG_PACKED   0x01    /* Story is a story_pack.py image */
+
+typedef struct {
+    const char *name;           /* NUL-terminated, points into the image */
+    const uint8_t *data;        /* Story (or packed image) in flash */
+    uint32_t size;              /* Bytes at data */
+    uint16_t release;
+    uint16_t checksum;
+    char serial[7];             /* NUL-terminated copy of the 6 serial bytes */
+    uint8_t version;            /* Z-machine version */
+    uint8_t flags;
+} story_catalog_entry_t;
+
+typedef struct {
+    const uint8_t *image;
+    size_t image_size;
+    const uint8_t *entries;     /* NULL for a single uncatalogued story */
+    uint16_t count;
+} story_catalog_t;
+
+/*
+ * Returns: true if data starts with the catalog magic
+ */
+bool story_catalog_is_catalog(const uint8_t *data, size_t size);
+
+/*
+ * Validate the header and every entry's bounds, names and story header.
+ * Returns: 0 on success, -1 if the image is not a usable catalog
+ */
+int story_catalog_open(story_catalog_t *catalog, const uint8_t *image, size_t image_size);
+
+/*
+ * Returns: number of stories (at least 1 after a successful open)
+ */
+uint16_t story_catalog_count(const story_catalog_t *catalog);
+
+/*
+ * Describe story index.
+ * Returns: 0 on success, -1 if index is out of range
+ */
+int story_catalog_get(const story_catalog_t *catalog, uint16_t index,
+                      story_catalog_entry_t *entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STORY_CATALOG_H */
@@ -0,0 +1,95 @@
+/*
+ * story_dict_index.c
+ *
+ * Hash index over the story dictionary for the tokenizer.
+ */
+
+#include "story_dict_index.h"
+
+#include <string.h>
+
+/* FNV-1a over the encoded word; the Z-characters are already well mixed */
+static uint32_t hash_key(const uint8_t *key, uint32_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < length; i++) {
+        hash = (hash ^ key[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t story_dict_index_buckets(const uint8_t *mem, uint32_t mem_size, uint32_t dict_addr)
+{
+    if (dict_addr >= mem_size) {
+        return 0;
+    }
+    uint32_t separators = mem[dict_addr];
+    uint32_t count_addr = dict_addr + 2 + separators;
+    if (count_addr + 1 >= mem_size) {
+        return 0;
+    }
+    int16_t entries = (int16_t)((mem[count_addr] << 8) | mem[count_addr + 1]);
+    if (entries <= 0) {
+        return 0;
+    }
+
+    uint32_t buckets = 1;
+    while (buckets < 2u * (uint32_t)entries) {
+        buckets <<= 1;
+    }
+    return buckets;
+}
+
+int story_dict_index_build(story_dict_index_t *index, const uint8_t *mem, uint32_t mem_size,
+                           int version, uint32_t dict_addr,
+                           uint16_t *buckets, uint32_t bucket_count)
+{
+    uint32_t needed = story_dict_index_buckets(mem, mem_size, dict_addr);
+    if (needed == 0 || bucket_count < needed || (bucket_count & (bucket_count - 1)) != 0) {
+        return -1;
+    }
+
+    uint32_t separators = mem[dict_addr];
+    index->mem = mem;
+    index->entry_length = mem[dict_addr + 1 + separators];
+    index->entry_count = (uint32_t)((mem[dict_addr + 2 + separators] << 8) |
+                                    mem[dict_addr + 3 + separators]);
+    index->first = dict_addr + 4 + separators;
+    index->key_bytes = version <= 3 ? 4 : 6;
+    index->buckets = buckets;
+    index->bucket_mask = bucket_count - 1;
+
+    if (index->entry_length < index->key_bytes || index->entry_count >= STORY_DICT_EMPTY ||
+        index->first + index->entry_count * index->entry_length > mem_size) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        buckets[i] = STORY_DICT_EMPTY;
+    }
+    for (uint32_t entry = 0; entry < index->entry_count; entry++) {
+        const uint8_t *key = mem + index->first + entry * index->entry_length;
+        uint32_t slot = hash_key(key, index->key_bytes) & index->bucket_mask;
+        while (buckets[slot] != STORY_DICT_EMPTY) {
+            slot = (slot + 1) & index->bucket_mask;
+        }
+        buckets[slot] = (uint16_t)entry;
+    }
+    return 0;
+}
+
+uint32_t story_dict_index_lookup(const story_dict_index_t *index, const uint8_t *encoded)
+{
+    uint32_t slot = hash_key(encoded, index->key_bytes) & index->bucket_mask;
+    for (;;) {
+        uint16_t entry = index->buckets[slot];
+        if (entry == STORY_DICT_EMPTY) {
+            return 0;
+        }
+        uint32_t addr = index->first + entry * index->entry_length;
+        if (memcmp(index->mem + addr, encoded, index->key_bytes) == 0) {
+            return addr;
+        }
+        slot = (slot + 1) & index->bucket_mask;
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * story_dict_index.h
+ *
+ * Hash index over the story dictionary for the tokenizer.
+ *
+ * tokenise() looks up every typed word in the dictionary, which is sorted
+ * by encoded text and searched in place. This index is built once at story
+ * load: an open-addressing table (linear probing, at most half full) from
+ * the encoded word (4 bytes in V1-3, 6 bytes later) to its entry number,
+ * so a lookup costs one hash and usually one comparison. Buckets are
+ * caller-provided, 2 bytes each: 4 KB for the 685 words of Zork I.
+ *
+ * Read-only after build; portable C, no allocation. tools/dict_index_sim.c
+ * compares it with binary search on the host.
+ */
+
+#ifndef STORY_DICT_INDEX_H
+#define STORY_DICT_INDEX_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STORY_DICT_EMPTY    0xFFFFu
+
+typedef struct {
+    const uint8_t *mem;
+    uint32_t first;             /* Address of entry 0 */
+    uint32_t entry_length;
+    uint32_t entry_count;
+    uint32_t key_bytes;         /* Encoded word length: 4 (V1-3) or 6 */
+    uint16_t *buckets;          /* Entry number, STORY_DICT_EMPTY if free */
+    uint32_t bucket_mask;       /* bucket count - 1 */
+} story_dict_index_t;
+
+/*
+ * Bucket count needed for the dictionary at dict_addr: the smallest power
+ * of two holding twice the entry count.
+ * Returns: bucket count, 0 if the dictionary header is unusable
+ */
+uint32_t story_dict_index_buckets(const uint8_t *mem, uint32_t mem_size, uint32_t dict_addr);
+
+/*
+ * Index the dictionary at dict_addr into bucket_count buckets (a power of
+ * two, at least story_dict_index_buckets()).
+ * Returns: 0 on success, -1 on bad geometry or a dictionary without a
+ * positive entry count (an unsorted one, which must keep the linear search)
+ */
+int story_dict_index_build(story_dict_index_t *index, const uint8_t *mem, uint32_t mem_size,
+                           int version, uint32_t dict_addr,
+                           uint16_t *buckets, uint32_t bucket_count);
+
+/*
+ * Look up an encoded word (key_bytes bytes, as tokenise() encodes it).
+ * Returns: dictionary address of the entry, 0 if the word is not present
+ */
+uint32_t story_dict_index_lookup(const story_dict_index_t *index, const uint8_t *encoded);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STORY_DICT_INDEX_H */
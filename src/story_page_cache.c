@@ -0,0 +1,161 @@
+/*
+ * story_page_cache.c
+ *
+ * LRU page cache for story static/high memory.
+ * See story_page_cache.h for the storage contract.
+ */
+
+#include "story_page_cache.h"
+
+#include <string.h>
+
+#define NO_PAGE     0xFFFFFFFFu
+
+static void unlink_slot(story_page_cache_t *cache, uint16_t index)
+{
+    story_page_slot_t *slot = &cache->slots[index];
+
+    if (slot->prev != STORY_PAGE_NONE) {
+        cache->slots[slot->prev].next = slot->next;
+    } else {
+        cache->mru = slot->next;
+    }
+    if (slot->next != STORY_PAGE_NONE) {
+        cache->slots[slot->next].prev = slot->prev;
+    } else {
+        cache->lru = slot->prev;
+    }
+}
+
+static void push_front(story_page_cache_t *cache, uint16_t index)
+{
+    story_page_slot_t *slot = &cache->slots[index];
+
+    slot->prev = STORY_PAGE_NONE;
+    slot->next = cache->mru;
+    if (cache->mru != STORY_PAGE_NONE) {
+        cache->slots[cache->mru].prev = index;
+    }
+    cache->mru = index;
+    if (cache->lru == STORY_PAGE_NONE) {
+        cache->lru = index;
+    }
+}
+
+uint32_t story_page_map_entries(uint32_t story_size, uint32_t page_size)
+{
+    return (story_size + page_size - 1) / page_size;
+}
+
+int story_page_cache_init(story_page_cache_t *cache, story_page_read_fn read, void *ctx,
+                          uint32_t story_size, uint32_t page_size,
+                          uint8_t *pages, story_page_slot_t *slots, uint16_t page_count,
+                          uint16_t *page_map)
+{
+    if (page_size == 0 || (page_size & (page_size - 1)) != 0 ||
+        page_count == 0 || page_count >= STORY_PAGE_NONE ||
+        story_page_map_entries(story_size, page_size) >= STORY_PAGE_NONE) {
+        return -1;
+    }
+
+    memset(cache, 0, sizeof(*cache));
+    cache->read = read;
+    cache->ctx = ctx;
+    cache->story_size = story_size;
+    while ((1u << cache->page_shift) < page_size) {
+        cache->page_shift++;
+    }
+    cache->pages = pages;
+    cache->slots = slots;
+    cache->page_map = page_map;
+    cache->page_count = page_count;
+
+    story_page_cache_flush(cache);
+    return 0;
+}
+
+void story_page_cache_flush(story_page_cache_t *cache)
+{
+    uint32_t entries = story_page_map_entries(cache->story_size, 1u << cache->page_shift);
+    for (uint32_t i = 0; i < entries; i++) {
+        cache->page_map[i] = STORY_PAGE_NONE;
+    }
+
+    cache->mru = STORY_PAGE_NONE;
+    cache->lru = STORY_PAGE_NONE;
+    for (uint16_t i = 0; i < cache->page_count; i++) {
+        cache->slots[i].page = STORY_PAGE_NONE;
+        push_front(cache, i);
+    }
+    cache->last_page = NO_PAGE;
+    cache->last_data = NULL;
+}
+
+const uint8_t* story_page_cache_page(story_page_cache_t *cache, uint32_t addr)
+{
+    if (addr >= cache->story_size) {
+        return NULL;
+    }
+
+    uint32_t page = addr >> cache->page_shift;
+    uint32_t page_size = 1u << cache->page_shift;
+    uint16_t index = cache->page_map[page];
+
+    if (index != STORY_PAGE_NONE) {
+        cache->stats.hits++;
+        if (index != cache->mru) {
+            unlink_slot(cache, index);
+            push_front(cache, index);
+        }
+    } else {
+        /* Evict the least recently used slot and fill it */
+        cache->stats.misses++;
+        index = cache->lru;
+        story_page_slot_t *slot = &cache->slots[index];
+        if (slot->page != STORY_PAGE_NONE) {
+            cache->page_map[slot->page] = STORY_PAGE_NONE;
+            slot->page = STORY_PAGE_NONE;
+        }
+
+        uint32_t offset = page << cache->page_shift;
+        uint32_t size = cache->story_size - offset < page_size ? cache->story_size - offset : page_size;
+        uint8_t *data = cache->pages + (size_t)index * page_size;
+        if (cache->read(cache->ctx, offset, data, size) != 0) {
+            cache->stats.read_errors++;
+            cache->last_page = NO_PAGE;
+            return NULL;    /* Slot stays empty at the LRU end */
+        }
+
+        slot->page = (uint16_t)page;
+        cache->page_map[page] = index;
+        unlink_slot(cache, index);
+        push_front(cache, index);
+    }
+
+    cache->last_page = page;
+    cache->last_data = cache->pages + (size_t)index * page_size;
+    return cache->last_data;
+}
+
+int story_page_cache_read(story_page_cache_t *cache, uint32_t addr, uint8_t *dest, uint32_t len)
+{
+    uint32_t page_size = 1u << cache->page_shift;
+
+    if (addr > cache->story_size || len > cache->story_size - addr) {
+        return -1;
+    }
+
+    while (len > 0) {
+        const uint8_t *data = story_page_cache_page(cache, addr);
+        if (data == NULL) {
+            return -1;
+        }
+        uint32_t offset = addr & (page_size - 1);
+        uint32_t chunk = page_size - offset < len ? page_size - offset : len;
+        memcpy(dest, data + offset, chunk);
+        dest += chunk;
+        addr += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * story_page_cache.h
+ *
+ * Fixed-size LRU page cache for reading static and high memory of a story
+ * file from slow storage (SD) instead of keeping the whole image in RAM.
+ *
+ * All storage is caller-provided: page_count pages of page_size bytes, a
+ * slot array, and a page map with one entry per story page, so lookups are
+ * O(1) and nothing is allocated after init. Misses are filled through a
+ * read callback (f_lseek/f_read on the device, pread on the host).
+ *
+ * Not thread-safe: only the interpreter task reads story memory. Portable
+ * C, exercised on the host by tools/story_page_sim.c.
+ */
+
+#ifndef STORY_PAGE_CACHE_H
+#define STORY_PAGE_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STORY_PAGE_NONE     0xFFFFu
+
+/* Fill dest with size bytes of the story starting at offset; return 0 on success */
+typedef int (*story_page_read_fn)(void *ctx, uint32_t offset, uint8_t *dest, uint32_t size);
+
+typedef struct {
+    uint16_t page;              /* Story page held, STORY_PAGE_NONE if empty */
+    uint16_t prev;              /* LRU list, towards most recently used */
+    uint16_t next;              /* LRU list, towards least recently used */
+} story_page_slot_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t read_errors;
+} story_page_stats_t;
+
+typedef struct {
+    story_page_read_fn read;
+    void *ctx;
+    uint32_t story_size;
+    uint32_t page_shift;        /* page_size = 1 << page_shift */
+    uint8_t *pages;             /* page_count * page_size bytes */
+    story_page_slot_t *slots;
+    uint16_t *page_map;         /* Story page -> slot, STORY_PAGE_NONE if not cached */
+    uint16_t page_count;
+    uint16_t mru;               /* Head of the LRU list */
+    uint16_t lru;               /* Tail: next victim */
+    uint32_t last_page;         /* One-entry fast path for sequential fetch */
+    const uint8_t *last_data;
+    story_page_stats_t stats;
+} story_page_cache_t;
+
+/*
+ * Number of page_map entries needed for a story of story_size bytes.
+ */
+uint32_t story_page_map_entries(uint32_t story_size, uint32_t page_size);
+
+/*
+ * Set up the cache. page_size must be a power of two; page_count must be
+ * below STORY_PAGE_NONE and page_map must hold story_page_map_entries().
+ * Returns: 0 on success, -1 on bad geometry
+ */
+int story_page_cache_init(story_page_cache_t *cache, story_page_read_fn read, void *ctx,
+                          uint32_t story_size, uint32_t page_size,
+                          uint8_t *pages, story_page_slot_t *slots, uint16_t page_count,
+                          uint16_t *page_map);
+
+/*
+ * Returns: pointer to the cached page holding addr (valid until the next
+ * cache call), or NULL if addr is out of range or the page read failed
+ */
+const uint8_t* story_page_cache_page(story_page_cache_t *cache, uint32_t addr);
+
+/*
+ * Returns: story byte at addr (0 when it cannot be read)
+ */
+static inline uint8_t story_page_cache_byte(story_page_cache_t *cache, uint32_t addr)
+{
+    uint32_t page = addr >> cache->page_shift;
+    if (page == cache->last_page) {
+        cache->stats.hits++;
+        return cache->last_data[addr & ((1u << cache->page_shift) - 1)];
+    }
+    const uint8_t *data = story_page_cache_page(cache, addr);
+    return data ? data[addr & ((1u << cache->page_shift) - 1)] : 0;
+}
+
+/*
+ * Copy len story bytes starting at addr, crossing pages as needed.
+ * Returns: 0 on success, -1 on range or read error
+ */
+int story_page_cache_read(story_page_cache_t *cache, uint32_t addr, uint8_t *dest, uint32_t len);
+
+/*
+ * Forget all cached pages (story file changed).
+ */
+void story_page_cache_flush(story_page_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STORY_PAGE_CACHE_H */
@@ -0,0 +1,149 @@
+/*
+ * upper_window.c
+ *
+ * Upper window character grid with per-cell dirty bits.
+ * See upper_window.h for the threading contract.
+ */
+
+#include "upper_window.h"
+
+/*
+ * Store ch in a cell, marking it dirty only if the cell changes.
+ */
+static void set_cell(upper_window_t *win, uint16_t row, uint16_t column, uint16_t ch)
+{
+    if (win->cells[row][column] == ch) {
+        return;
+    }
+    win->cells[row][column] = ch;
+    win->dirty[row][column / 32] |= 1u << (column % 32);
+    win->dirty_rows |= 1u << row;
+}
+
+void upper_window_init(upper_window_t *win, uint16_t columns)
+{
+    if (columns > UPPER_WINDOW_MAX_COLUMNS) {
+        columns = UPPER_WINDOW_MAX_COLUMNS;
+    }
+    for (uint16_t row = 0; row < UPPER_WINDOW_MAX_ROWS; row++) {
+        for (uint16_t column = 0; column < UPPER_WINDOW_MAX_COLUMNS; column++) {
+            win->cells[row][column] = ' ';
+        }
+        for (uint16_t word = 0; word < UPPER_WINDOW_DIRTY_WORDS; word++) {
+            win->dirty[row][word] = 0;
+        }
+    }
+    win->dirty_rows = 0;
+    win->columns = columns;
+    win->rows = 0;
+    win->cursor_row = 0;
+    win->cursor_column = 0;
+}
+
+void upper_window_split(upper_window_t *win, uint16_t rows)
+{
+    if (rows > UPPER_WINDOW_MAX_ROWS) {
+        rows = UPPER_WINDOW_MAX_ROWS;
+    }
+    win->rows = rows;
+    if (win->cursor_row >= rows) {
+        win->cursor_row = 0;
+        win->cursor_column = 0;
+    }
+}
+
+void upper_window_erase(upper_window_t *win)
+{
+    for (uint16_t row = 0; row < UPPER_WINDOW_MAX_ROWS; row++) {
+        for (uint16_t column = 0; column < win->columns; column++) {
+            set_cell(win, row, column, ' ');
+        }
+    }
+    win->cursor_row = 0;
+    win->cursor_column = 0;
+}
+
+void upper_window_set_cursor(upper_window_t *win, int16_t line, int16_t column)
+{
+    int row = line - 1;
+    int col = column - 1;
+    if (row < 0) {
+        row = 0;
+    } else if (row >= UPPER_WINDOW_MAX_ROWS) {
+        row = UPPER_WINDOW_MAX_ROWS - 1;
+    }
+    if (col < 0) {
+        col = 0;
+    } else if (col > win->columns) {
+        col = win->columns;
+    }
+    win->cursor_row = (uint16_t)row;
+    win->cursor_column = (uint16_t)col;
+}
+
+uint16_t upper_window_cursor_line(const upper_window_t *win)
+{
+    return (uint16_t)(win->cursor_row + 1);
+}
+
+uint16_t upper_window_cursor_column(const upper_window_t *win)
+{
+    return (uint16_t)(win->cursor_column + 1);
+}
+
+void upper_window_write(upper_window_t *win, const uint32_t *text, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        uint32_t ch = text[i];
+        if (ch == '\n') {
+            win->cursor_row++;
+            win->cursor_column = 0;
+            continue;
+        }
+        if (win->cursor_row >= win->rows || win->cursor_column >= win->columns) {
+            continue;   /* Clipped at the window edge */
+        }
+        set_cell(win, win->cursor_row, win->cursor_column, ch < 0x10000 ? (uint16_t)ch : '?');
+        win->cursor_column++;
+    }
+}
+
+void upper_window_erase_line(upper_window_t *win)
+{
+    if (win->cursor_row >= UPPER_WINDOW_MAX_ROWS) {
+        return;
+    }
+    for (uint16_t column = win->cursor_column; column < win->columns; column++) {
+        set_cell(win, win->cursor_row, column, ' ');
+    }
+}
+
+size_t upper_window_read_changes(upper_window_t *win, upper_window_cell_t *changes,
+                                 size_t max_changes)
+{
+    size_t count = 0;
+
+    while (win->dirty_rows != 0 && count < max_changes) {
+        uint16_t row = (uint16_t)__builtin_ctz(win->dirty_rows);
+        bool pending = false;
+
+        for (uint16_t word = 0; word < UPPER_WINDOW_DIRTY_WORDS; word++) {
+            uint32_t bits = win->dirty[row][word];
+            while (bits != 0 && count < max_changes) {
+                uint16_t column = (uint16_t)(word * 32 + __builtin_ctz(bits));
+                changes[count].row = (uint8_t)row;
+                changes[count].column = (uint8_t)column;
+                changes[count].ch = win->cells[row][column];
+                count++;
+                bits &= bits - 1;
+            }
+            win->dirty[row][word] = bits;
+            pending |= (bits != 0);
+        }
+
+        if (!pending) {
+            win->dirty_rows &= ~(1u << row);
+        }
+    }
+    return count;
+}
@@ -0,0 +1,101 @@
+/*
+ * upper_window.h
+ *
+ * Z-machine upper window (window 1) as a fixed-size character grid.
+ *
+ * V4+ stories split the screen and draw status lines, menus and quote
+ * boxes into the upper window by cursor addressing. The grid keeps one
+ * code point per cell plus a dirty bit per cell, set only when a write
+ * changes the cell, so the UI copies out just the cells that changed since
+ * it last looked: a story redrawing its whole status line every turn costs
+ * the handful of characters that differ, not a rebuilt buffer.
+ *
+ * Not thread-safe: the bridges call it under their state lock (the fizmo
+ * task writes, the Qt task reads changes). Portable C, no allocation.
+ */
+
+#ifndef UPPER_WINDOW_H
+#define UPPER_WINDOW_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest grid kept; splits and widths beyond it are clamped */
+#define UPPER_WINDOW_MAX_ROWS       16
+#define UPPER_WINDOW_MAX_COLUMNS    64
+
+#define UPPER_WINDOW_DIRTY_WORDS    ((UPPER_WINDOW_MAX_COLUMNS + 31) / 32)
+
+/* One changed cell, as handed to the UI */
+typedef struct {
+    uint8_t row;                /* 0-based */
+    uint8_t column;             /* 0-based */
+    uint16_t ch;                /* Code point (BMP), ' ' when erased */
+} upper_window_cell_t;
+
+typedef struct {
+    uint16_t cells[UPPER_WINDOW_MAX_ROWS][UPPER_WINDOW_MAX_COLUMNS];
+    uint32_t dirty[UPPER_WINDOW_MAX_ROWS][UPPER_WINDOW_DIRTY_WORDS];
+    uint32_t dirty_rows;        /* Bit per row with at least one dirty cell */
+    uint16_t columns;           /* Screen width, at most UPPER_WINDOW_MAX_COLUMNS */
+    uint16_t rows;              /* Current split height, 0 when not split */
+    uint16_t cursor_row;        /* 0-based */
+    uint16_t cursor_column;     /* 0-based; == columns once a row is full */
+} upper_window_t;
+
+/*
+ * Initialize an empty, unsplit window for a screen columns characters wide.
+ */
+void upper_window_init(upper_window_t *win, uint16_t columns);
+
+/*
+ * split_window: show rows lines of the grid (0 unsplits). Cells are kept,
+ * as the lower window only overlaps them; the cursor moves inside the
+ * window if it fell outside.
+ */
+void upper_window_split(upper_window_t *win, uint16_t rows);
+
+/*
+ * erase_window(1): blank every cell and home the cursor.
+ */
+void upper_window_erase(upper_window_t *win);
+
+/*
+ * set_cursor with the Z-machine's 1-based line and column, clamped to the grid.
+ */
+void upper_window_set_cursor(upper_window_t *win, int16_t line, int16_t column);
+
+/* Cursor as 1-based line and column for get_cursor_row/column */
+uint16_t upper_window_cursor_line(const upper_window_t *win);
+uint16_t upper_window_cursor_column(const upper_window_t *win);
+
+/*
+ * Write text at the cursor. Newline moves to the start of the next row;
+ * text beyond the right margin or below the window is dropped.
+ */
+void upper_window_write(upper_window_t *win, const uint32_t *text, size_t count);
+
+/*
+ * erase_line: blank from the cursor to the end of its row.
+ */
+void upper_window_erase_line(upper_window_t *win);
+
+/*
+ * Copy up to max_changes changed cells (row by row, left to right) and
+ * clear their dirty bits. Cost is proportional to the cells returned.
+ *
+ * Returns: number of cells copied (max_changes means more may be pending)
+ */
+size_t upper_window_read_changes(upper_window_t *win, upper_window_cell_t *changes,
+                                 size_t max_changes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPPER_WINDOW_H */
@@ -0,0 +1,286 @@
+/*
+ * dict_index_sim.c
+ *
+ * Host comparison of dictionary lookup by binary search (what tokenise()
+ * does today) and by the hash index in src/story_dict_index.c.
+ *
+ * Commands come from a walkthrough file (one per line, the ZORK_WALKTHROUGH
+ * format) or a built-in Zork I opening. Each command is split on spaces and
+ * the story's separators, every word is encoded to dictionary form (V1-3
+ * 6 Z-characters, V4+ 9), and both lookups must return the same address.
+ * The script is parsed --repeat times and host ns per command and per word
+ * are reported for each method, with the probe/comparison counts that
+ * carry over to the target.
+ *
+ *   cc -O2 -Isrc tools/dict_index_sim.c src/story_dict_index.c -o dict_index_sim
+ *   ./dict_index_sim zork1.z3 [--walkthrough commands.txt] [--repeat 20000]
+ */
+
+#include "story_dict_index.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_COMMANDS    1024
+#define MAX_WORDS       8192
+
+static const char *s_default_script[] = {
+    "open mailbox", "read leaflet", "drop leaflet", "south", "east",
+    "open window", "enter house", "take lamp", "take sack", "west",
+    "move rug", "open trap door", "turn on lamp", "down", "south",
+    "east", "take painting", "north", "up", "west", "take sword",
+    "open case", "put painting in case", "inventory", "look",
+    "examine the brass lantern", "go north", "climb tree", "take egg",
+    "down", "attack troll with sword", "diagnose", "score",
+};
+
+static const uint8_t *s_image;
+static uint32_t s_story_size;
+static int s_version;
+
+static const char s_alphabet_a2[] = "\n0123456789.,!?_#'\"/\\-:()";
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* Encode a word to dictionary form, as tokenise() does. Returns: key bytes */
+static uint32_t encode_word(const char *word, size_t length, uint8_t *out)
+{
+    uint32_t zchar_count = s_version <= 3 ? 6 : 9;
+    uint8_t zchars[16];
+    uint32_t n = 0;
+
+    for (size_t i = 0; i < length && n < zchar_count; i++) {
+        char c = word[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = (char)(c - 'A' + 'a');
+        }
+        const char *a2 = strchr(s_alphabet_a2, c);
+        if (c >= 'a' && c <= 'z') {
+            zchars[n++] = (uint8_t)(6 + c - 'a');
+        } else if (c != '\0' && a2 != NULL && a2 != s_alphabet_a2) {
+            zchars[n++] = s_version <= 2 ? 3 : 5;
+            zchars[n++] = (uint8_t)(7 + (a2 - s_alphabet_a2));
+        } else {
+            /* ZSCII escape: A2 char 6, then two 5-bit halves */
+            zchars[n++] = s_version <= 2 ? 3 : 5;
+            zchars[n++] = 6;
+            zchars[n++] = (uint8_t)(((uint8_t)c >> 5) & 0x1F);
+            zchars[n++] = (uint8_t)(c & 0x1F);
+        }
+    }
+    while (n < zchar_count) {
+        zchars[n++] = 5;
+    }
+
+    uint32_t bytes = 0;
+    for (uint32_t i = 0; i < zchar_count; i += 3) {
+        uint16_t w = (uint16_t)((zchars[i] << 10) | (zchars[i + 1] << 5) | zchars[i + 2]);
+        if (i + 3 >= zchar_count) {
+            w |= 0x8000;
+        }
+        out[bytes++] = (uint8_t)(w >> 8);
+        out[bytes++] = (uint8_t)w;
+    }
+    return bytes;
+}
+
+static uint32_t s_search_compares;
+
+/* The binary search tokenise() does over the sorted dictionary */
+static uint32_t binary_lookup(const story_dict_index_t *dict, const uint8_t *key)
+{
+    int32_t low = 0, high = (int32_t)dict->entry_count - 1;
+    while (low <= high) {
+        int32_t mid = (low + high) / 2;
+        uint32_t addr = dict->first + (uint32_t)mid * dict->entry_length;
+        int cmp = memcmp(s_image + addr, key, dict->key_bytes);
+        s_search_compares++;
+        if (cmp == 0) {
+            return addr;
+        }
+        if (cmp < 0) low = mid + 1; else high = mid - 1;
+    }
+    return 0;
+}
+
+static uint32_t s_index_compares;
+
+static uint32_t counted_index_lookup(const story_dict_index_t *index, const uint8_t *key)
+{
+    /* Count probes by re-walking the chain the lookup just took */
+    uint32_t addr = story_dict_index_lookup(index, key);
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < index->key_bytes; i++) {
+        hash = (hash ^ key[i]) * 16777619u;
+    }
+    for (uint32_t slot = hash & index->bucket_mask;; slot = (slot + 1) & index->bucket_mask) {
+        uint16_t entry = index->buckets[slot];
+        if (entry == STORY_DICT_EMPTY) {
+            break;
+        }
+        s_index_compares++;
+        if (index->first + entry * index->entry_length == addr) {
+            break;
+        }
+    }
+    return addr;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: dict_index_sim story.z? [--walkthrough commands.txt] [--repeat N]\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    const char *script_path = NULL;
+    long repeat = 20000;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--walkthrough") == 0) script_path = argv[i + 1];
+        else if (strcmp(argv[i], "--repeat") == 0) repeat = atol(argv[i + 1]);
+        else { usage(); return 1; }
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "dict_index_sim: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    static uint8_t image[512 * 1024];
+    s_story_size = (uint32_t)fread(image, 1, sizeof(image), fp);
+    fclose(fp);
+    s_image = image;
+    s_version = image[0];
+    if (s_story_size < 64 || s_version < 1 || s_version > 8) {
+        fprintf(stderr, "dict_index_sim: unsupported story\n");
+        return 1;
+    }
+
+    /* Load the script */
+    static char text[64 * 1024];
+    static char *commands[MAX_COMMANDS];
+    size_t command_count = 0;
+    if (script_path != NULL) {
+        fp = fopen(script_path, "r");
+        if (fp == NULL) {
+            fprintf(stderr, "dict_index_sim: cannot open %s\n", script_path);
+            return 1;
+        }
+        size_t used = fread(text, 1, sizeof(text) - 1, fp);
+        fclose(fp);
+        text[used] = '\0';
+        for (char *line = strtok(text, "\r\n"); line && command_count < MAX_COMMANDS;
+             line = strtok(NULL, "\r\n")) {
+            if (line[0] != '\0' && line[0] != '#') {
+                commands[command_count++] = line;
+            }
+        }
+    } else {
+        for (size_t i = 0; i < sizeof(s_default_script) / sizeof(s_default_script[0]); i++) {
+            commands[command_count++] = (char *)s_default_script[i];
+        }
+    }
+
+    uint32_t dict_addr = (uint32_t)((image[0x08] << 8) | image[0x09]);
+    uint32_t bucket_count = story_dict_index_buckets(image, s_story_size, dict_addr);
+    uint16_t *buckets = malloc((bucket_count ? bucket_count : 1) * sizeof(uint16_t));
+    story_dict_index_t index;
+    double build_start = now_ns();
+    if (buckets == NULL ||
+        story_dict_index_build(&index, image, s_story_size, s_version, dict_addr,
+                               buckets, bucket_count) != 0) {
+        fprintf(stderr, "dict_index_sim: cannot index the dictionary\n");
+        return 1;
+    }
+    double build_ns = now_ns() - build_start;
+
+    /* Tokenise once: split on spaces and the story's separators */
+    static uint8_t keys[MAX_WORDS][8];
+    uint32_t word_count = 0, found = 0;
+    uint32_t separators = image[dict_addr];
+    const uint8_t *separator_list = image + dict_addr + 1;
+    for (size_t c = 0; c < command_count; c++) {
+        const char *p = commands[c];
+        while (*p != '\0' && word_count < MAX_WORDS) {
+            if (*p == ' ') {
+                p++;
+                continue;
+            }
+            size_t length = 0;
+            if (memchr(separator_list, *p, separators) != NULL) {
+                length = 1;
+            } else {
+                while (p[length] != '\0' && p[length] != ' ' &&
+                       memchr(separator_list, p[length], separators) == NULL) {
+                    length++;
+                }
+            }
+            encode_word(p, length, keys[word_count]);
+            uint32_t by_search = binary_lookup(&index, keys[word_count]);
+            uint32_t by_index = story_dict_index_lookup(&index, keys[word_count]);
+            if (by_search != by_index) {
+                fprintf(stderr, "dict_index_sim: lookups disagree on \"%.*s\"\n", (int)length, p);
+                return 1;
+            }
+            found += by_index != 0;
+            word_count++;
+            p += length;
+        }
+    }
+
+    s_search_compares = 0;
+    s_index_compares = 0;
+    for (uint32_t w = 0; w < word_count; w++) {
+        binary_lookup(&index, keys[w]);
+        counted_index_lookup(&index, keys[w]);
+    }
+    uint32_t search_compares = s_search_compares;
+    uint32_t index_compares = s_index_compares;
+
+    volatile uint32_t sink = 0;
+    double start = now_ns();
+    for (long r = 0; r < repeat; r++) {
+        for (uint32_t w = 0; w < word_count; w++) {
+            sink += binary_lookup(&index, keys[w]);
+        }
+    }
+    double search_ns = now_ns() - start;
+    start = now_ns();
+    for (long r = 0; r < repeat; r++) {
+        for (uint32_t w = 0; w < word_count; w++) {
+            sink += story_dict_index_lookup(&index, keys[w]);
+        }
+    }
+    double index_ns = now_ns() - start;
+    (void)sink;
+
+    double per_command = (double)repeat * (double)command_count;
+    double per_word = (double)repeat * (double)word_count;
+    printf("story: %s, version %d, dictionary at 0x%04x: %u entries of %u bytes\n",
+           argv[1], s_version, dict_addr, index.entry_count, index.entry_length);
+    printf("index: %u buckets, %zu bytes, built in %.0f ns on host\n",
+           bucket_count, bucket_count * sizeof(uint16_t), build_ns);
+    printf("script: %zu commands, %u words, %u in dictionary\n",
+           command_count, word_count, found);
+    printf("compares/word: binary search %.2f, index %.2f\n",
+           (double)search_compares / word_count, (double)index_compares / word_count);
+    printf("host: binary search %.1f ns/command (%.1f ns/word), index %.1f ns/command "
+           "(%.1f ns/word)\n", search_ns / per_command, search_ns / per_word,
+           index_ns / per_command, index_ns / per_word);
+
+    free(buckets);
+    return 0;
+}
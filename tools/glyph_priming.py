@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+glyph_priming.py
+
+Font cache priming table from recorded playthroughs (FIZMO_GLYPH_PRIMING).
+
+The desktop build records every glyph that reaches a game text item when
+ZORK_GLYPH_RECORD=<file> is set, one "<pixel size> <code point>" line per
+glyph in the order it first rendered. Run it with ZORK_WALKTHROUGH for a
+repeatable playthrough. This tool merges one or more recordings, keeps the
+glyphs in first-use order until the Spark font cache budget is used up,
+and writes the C++ table FizmoBackend draws during the boot splash, so the
+first screens after boot find their glyphs already rasterized.
+
+  ZORK_GLYPH_RECORD=glyphs.txt ZORK_WALKTHROUGH=commands.txt ./ZorkUI
+  tools/glyph_priming.py glyphs.txt --output ui/qul/ZorkUI/GlyphPrimingTable.h \\
+      --qmlproject ui/qul/ZorkUI/ZorkUI_RT1050.qmlproject \\
+      --fontmap ui/qul/ZorkUI/fonts/ZorkMCUFontmap.fmp
+
+The cache budget is a share of fontCacheSize from the qmlproject (or
+--cache-size); glyph sizes are estimated from the font's advance width and
+line height, as in story_glyphs.py. Only the Python standard library is used.
+"""
+
+import argparse
+import re
+import sys
+
+import story_glyphs
+
+DEFAULT_BUDGET_PERCENT = 50
+FALLBACK_GLYPH_BYTES = 256
+
+
+def read_recordings(paths):
+    """Returns: {pixel size: [code point, ...]} in first-use order, merged
+    across recordings by the earliest position each glyph was seen at."""
+    first_seen = {}
+    for path in paths:
+        with open(path, "r", encoding="ascii") as handle:
+            position = 0
+            for number, line in enumerate(handle, 1):
+                line = line.split("#", 1)[0].strip()
+                if not line:
+                    continue
+                fields = line.split()
+                try:
+                    size, point = int(fields[0]), int(fields[1], 16)
+                except (IndexError, ValueError):
+                    raise ValueError("%s:%d: expected '<pixel size> <hex code point>'"
+                                     % (path, number))
+                key = (size, point)
+                if key not in first_seen or position < first_seen[key]:
+                    first_seen[key] = position
+                position += 1
+    table = {}
+    for (size, point), _position in sorted(first_seen.items(), key=lambda item: item[1]):
+        if point >= 0x20:
+            table.setdefault(size, []).append(point)
+    return table
+
+
+def qmlproject_cache_size(path):
+    """Returns: fontCacheSize from a qmlproject, or None."""
+    with open(path, "r", encoding="utf-8") as handle:
+        match = re.search(r"^\s*fontCacheSize:\s*(\d+)", handle.read(), re.MULTILINE)
+    return int(match.group(1)) if match else None
+
+
+def glyph_bytes(fontmaps, size):
+    """Returns: estimated bytes per cached glyph at size (8-bit alpha),
+    the largest over all fonts in the fontmaps."""
+    estimate = 0
+    for path in fontmaps:
+        with open(path, "rb") as handle:
+            blob = handle.read()
+        for base in story_glyphs.find_sfnts(blob):
+            _name, _covered, upem, advance, line = story_glyphs.sfnt_info(blob, base)
+            w = -(-advance * size // upem)
+            h = -(-line * size // upem)
+            estimate = max(estimate, w * h)
+    return estimate or FALLBACK_GLYPH_BYTES
+
+
+def c_escape(text):
+    return text.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def write_table(path, sources, entries):
+    lines = [
+        "/*",
+        " * GlyphPrimingTable.h",
+        " *",
+        " * Generated by tools/glyph_priming.py from %s - do not edit."
+        % (sources or "no recording (empty table)"),
+        " * Glyphs in the order a recorded playthrough first rendered them, per",
+        " * pixel size, cut to the font cache budget. FizmoBackend::getPrimingText()",
+        " * hands the entry for the game text size to the boot splash.",
+        " */",
+        "",
+        "#ifndef GLYPHPRIMINGTABLE_H",
+        "#define GLYPHPRIMINGTABLE_H",
+        "",
+        "struct GlyphPrimingEntry {",
+        "    int pixelSize;",
+        "    const char *text;   // UTF-8",
+        "};",
+        "",
+        "static const GlyphPrimingEntry GLYPH_PRIMING_TABLE[] = {",
+    ]
+    for size, points in entries:
+        text = "".join(chr(p) for p in points)
+        lines.append('    { %d, "%s" },' % (size, c_escape(text)))
+    lines.append("    { 0, nullptr }")
+    lines.append("};")
+    lines.append("")
+    lines.append("#endif // GLYPHPRIMINGTABLE_H")
+    with open(path, "w", encoding="utf-8") as handle:
+        handle.write("\n".join(lines) + "\n")
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Font cache priming table from glyph recordings")
+    parser.add_argument("recordings", nargs="*", metavar="RECORDING",
+                        help="ZORK_GLYPH_RECORD output (none: write an empty table)")
+    parser.add_argument("--output", required=True, help="C++ header to write")
+    parser.add_argument("--qmlproject", help="read fontCacheSize from this qmlproject")
+    parser.add_argument("--cache-size", type=int, help="font cache size in bytes")
+    parser.add_argument("--budget", type=int, default=DEFAULT_BUDGET_PERCENT,
+                        help="percent of the font cache to fill (default %d)" % DEFAULT_BUDGET_PERCENT)
+    parser.add_argument("--fontmap", action="append", default=[],
+                        help="fontmap (.fmp) or TrueType file for the per-glyph estimate")
+    args = parser.parse_args(argv)
+
+    try:
+        table = read_recordings(args.recordings)
+    except (OSError, ValueError) as err:
+        sys.stderr.write("glyph_priming: %s\n" % err)
+        return 1
+
+    cache_size = args.cache_size
+    if cache_size is None and args.qmlproject:
+        cache_size = qmlproject_cache_size(args.qmlproject)
+    budget = cache_size * args.budget // 100 if cache_size else None
+
+    entries = []
+    used = 0
+    for size in sorted(table):
+        points = table[size]
+        per_glyph = glyph_bytes(args.fontmap, size)
+        keep = len(points)
+        if budget is not None:
+            keep = min(keep, max(0, (budget - used) // per_glyph))
+        used += keep * per_glyph
+        entries.append((size, points[:keep]))
+        print("glyph_priming: %d px: %d glyphs recorded, %d primed (~%d B each%s)"
+              % (size, len(points), keep, per_glyph,
+                 ", over budget" if keep < len(points) else ""))
+    if budget is not None:
+        print("glyph_priming: ~%d of %d B budget (%d%% of fontCacheSize %d)"
+              % (used, budget, args.budget, cache_size))
+
+    sources = ", ".join(p.replace("\\", "/").split("/")[-1] for p in args.recordings)
+    write_table(args.output, sources, entries)
+    print("glyph_priming: wrote %s" % args.output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
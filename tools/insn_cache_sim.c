@@ -0,0 +1,312 @@
+/*
+ * insn_cache_sim.c
+ *
+ * Host measurement of the decoded-instruction cache (src/insn_cache.c).
+ *
+ * Runs the same random walk over a story's real code twice: once decoding
+ * every instruction from the image, once fetching records through the
+ * cache. Calls and jumps with constant targets are followed, branches are
+ * taken at random, variable-target calls go to a random routine seeded from
+ * routine-valued object properties, and each routine returns after
+ * FRAME_BUDGET instructions. Both runs use the same seed, so they execute
+ * the identical instruction stream; the walk itself only reads records.
+ *
+ * Reports the hit rate for the given byte budget and host ns/instruction
+ * for both runs. The interpreter's own execution cost is not included, so
+ * the saving is an upper bound on what the hook in zpu.c would gain.
+ *
+ *   cc -O2 -Isrc tools/insn_cache_sim.c src/insn_cache.c -o insn_cache_sim
+ *   ./insn_cache_sim zork1.z3 --budget 32768 --steps 20000000
+ */
+
+#include "insn_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_DEPTH   32
+#define FRAME_BUDGET 256    /* Instructions before a routine is forced to return */
+#define MAX_ROUTINES 4096
+
+static const uint8_t *s_image;
+static uint32_t s_story_size;
+static uint32_t s_static_base;
+static uint32_t s_initial_pc;
+static int s_version;
+static uint32_t s_rng;
+
+static uint32_t s_routines[MAX_ROUTINES];
+static uint32_t s_routine_count;
+static uint8_t s_routine_seen[512 * 1024 / 8];
+static uint8_t s_seeded_seen[sizeof(s_routine_seen)];
+static uint32_t s_seeded_count;
+
+static uint32_t s_stack[MAX_DEPTH];
+static uint32_t s_executed[MAX_DEPTH];
+static int s_depth;
+
+static uint32_t next_random(void)
+{
+    s_rng = s_rng * 1103515245u + 12345u;
+    return s_rng >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t unpack(uint16_t packed)
+{
+    if (s_version <= 3) return 2u * packed;
+    if (s_version <= 5) return 4u * packed;
+    return 8u * packed;
+}
+
+static void add_routine(uint32_t routine)
+{
+    if (routine >= s_story_size || s_routine_count >= MAX_ROUTINES ||
+        (s_routine_seen[routine >> 3] & (1u << (routine & 7)))) {
+        return;
+    }
+    s_routine_seen[routine >> 3] |= (uint8_t)(1u << (routine & 7));
+    s_routines[s_routine_count++] = routine;
+}
+
+/* Seed the routine list with word properties that point at routines */
+static void scan_property_routines(void)
+{
+    uint32_t high_base = (uint32_t)((s_image[0x04] << 8) | s_image[0x05]);
+    uint32_t objects = (uint32_t)((s_image[0x0A] << 8) | s_image[0x0B]);
+    uint32_t entry_size = s_version <= 3 ? 9 : 14;
+    uint32_t first = objects + (s_version <= 3 ? 31 : 63) * 2;
+    uint32_t lowest_props = s_static_base;
+
+    for (uint32_t obj = first; obj + entry_size <= lowest_props; obj += entry_size) {
+        uint32_t ptr_offset = obj + entry_size - 2;
+        uint32_t props = (uint32_t)((s_image[ptr_offset] << 8) | s_image[ptr_offset + 1]);
+        if (props < lowest_props) {
+            lowest_props = props;
+        }
+        if (props + 1 >= s_static_base) {
+            continue;
+        }
+        uint32_t p = props + 1 + 2u * s_image[props];
+        while (p < s_static_base && s_image[p] != 0) {
+            uint32_t size, header = 1;
+            uint8_t b = s_image[p];
+            if (s_version <= 3) {
+                size = (b >> 5) + 1u;
+            } else if (b & 0x80) {
+                header = 2;
+                size = s_image[p + 1] & 0x3F;
+                if (size == 0) size = 64;
+            } else {
+                size = (b & 0x40) ? 2 : 1;
+            }
+            if (size == 2) {
+                uint32_t routine = unpack((uint16_t)((s_image[p + header] << 8) | s_image[p + header + 1]));
+                if (routine >= high_base && routine < s_story_size && s_image[routine] <= 15) {
+                    add_routine(routine);
+                }
+            }
+            p += header + size;
+        }
+    }
+}
+
+static uint32_t do_return(void)
+{
+    if (s_depth == 0) {
+        return s_initial_pc;
+    }
+    return s_stack[--s_depth];
+}
+
+static uint32_t do_call(const insn_record_t *record)
+{
+    uint32_t routine;
+    if ((record->operand_types >> 14) != INSN_TYPE_VARIABLE) {
+        routine = unpack(record->operands[0]);
+    } else {
+        routine = s_routine_count ? s_routines[next_random() % s_routine_count] : 0;
+    }
+    if (routine == 0 || routine >= s_story_size || s_depth == MAX_DEPTH ||
+        s_image[routine] > 15) {
+        return record->next_pc;
+    }
+    add_routine(routine);
+    s_stack[s_depth] = record->next_pc;
+    s_executed[s_depth++] = 0;
+    return routine + 1 + (s_version <= 4 ? 2u * s_image[routine] : 0);
+}
+
+/* Follow one record's control flow. Returns: next PC */
+static uint32_t step(const insn_record_t *record)
+{
+    if ((record->flags & INSN_HAS_BRANCH) && (next_random() & 1)) {
+        int16_t offset = record->branch_offset;
+        if (offset == 0 || offset == 1) {
+            return do_return();
+        }
+        return (uint32_t)((int32_t)record->next_pc + offset - 2);
+    }
+
+    switch (record->kind) {
+    case INSN_0OP:
+        if (record->number <= 1 || record->number == 3 || record->number == 8) {
+            return do_return();
+        }
+        if (record->number == 7 || record->number == 10) {
+            s_depth = 0;
+            return s_initial_pc;
+        }
+        break;
+    case INSN_1OP:
+        if (record->number == 8 || (record->number == 15 && s_version >= 5)) {
+            return do_call(record);
+        }
+        if (record->number == 11) {
+            return do_return();
+        }
+        if (record->number == 12) {
+            return (uint32_t)((int32_t)record->next_pc + (int16_t)record->operands[0] - 2);
+        }
+        break;
+    case INSN_2OP:
+        if (record->number == 25 || record->number == 26) {
+            return do_call(record);
+        }
+        if (record->number == 28) {
+            return do_return();
+        }
+        break;
+    case INSN_VAR:
+        if (record->number == 0 || record->number == 12 ||
+            record->number == 25 || record->number == 26) {
+            return do_call(record);
+        }
+        break;
+    default:
+        break;
+    }
+    return record->next_pc;
+}
+
+/* One walk. Returns: elapsed ns; *checksum folds every PC visited */
+static double walk(insn_cache_t *cache, long steps, uint32_t seed, uint32_t *checksum)
+{
+    insn_record_t scratch;
+    uint32_t pc = s_initial_pc, sum = 0;
+
+    /* Both runs start from the same routine list and seed */
+    s_routine_count = s_seeded_count;
+    memcpy(s_routine_seen, s_seeded_seen, sizeof(s_routine_seen));
+    s_rng = seed;
+    s_depth = 0;
+    double start = now_ns();
+    for (long i = 0; i < steps; i++) {
+        const insn_record_t *record;
+        if (cache != NULL) {
+            record = insn_cache_fetch(cache, pc);
+        } else {
+            record = insn_decode(s_image, s_story_size, s_version, pc, &scratch) == 0 ? &scratch : NULL;
+        }
+        pc = record ? step(record) : s_initial_pc;
+        sum = sum * 31u + pc;
+        if (s_depth > 0 && ++s_executed[s_depth - 1] > FRAME_BUDGET) {
+            pc = do_return();
+        }
+        if (pc >= s_story_size) {
+            s_depth = 0;
+            pc = s_initial_pc;
+        }
+    }
+    *checksum = sum;
+    return now_ns() - start;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: insn_cache_sim story.z? [--budget BYTES] [--steps N] [--seed S]\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    size_t budget = 32768;
+    long steps = 20000000L;
+    uint32_t seed = 12345;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--budget") == 0) budget = (size_t)atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--steps") == 0) steps = atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atol(argv[i + 1]);
+        else { usage(); return 1; }
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "insn_cache_sim: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    static uint8_t image[512 * 1024];
+    s_story_size = (uint32_t)fread(image, 1, sizeof(image), fp);
+    fclose(fp);
+
+    s_image = image;
+    s_version = image[0];
+    s_static_base = (uint32_t)((image[0x0E] << 8) | image[0x0F]);
+    s_initial_pc = (uint32_t)((image[0x06] << 8) | image[0x07]);
+    if (s_story_size < 64 || s_version < 1 || s_version == 6 || s_version == 7 || s_version > 8) {
+        fprintf(stderr, "insn_cache_sim: unsupported story (version %d)\n", s_version);
+        return 1;
+    }
+
+    uint32_t slot_count = insn_cache_slots_for_budget(budget);
+    insn_record_t *slots = malloc((slot_count ? slot_count : 1) * sizeof(*slots));
+    if (slots == NULL) {
+        fprintf(stderr, "insn_cache_sim: out of memory\n");
+        return 1;
+    }
+    insn_cache_t cache;
+    insn_cache_init(&cache, slots, slot_count, image, s_story_size, s_version);
+
+    scan_property_routines();
+    s_seeded_count = s_routine_count;
+    memcpy(s_seeded_seen, s_routine_seen, sizeof(s_routine_seen));
+
+    uint32_t decode_sum, cached_sum;
+    double decode_ns = walk(NULL, steps, seed, &decode_sum);
+    insn_cache_clear(&cache);
+    double cached_ns = walk(&cache, steps, seed, &cached_sum);
+    if (decode_sum != cached_sum) {
+        fprintf(stderr, "insn_cache_sim: cached walk diverged from decoded walk\n");
+        return 1;
+    }
+
+    const insn_cache_stats_t *stats = &cache.stats;
+    double fetches = (double)stats->hits + stats->misses + stats->uncached;
+    printf("story: %s, version %d, %u bytes, high memory from 0x%05x\n",
+           argv[1], s_version, s_story_size, cache.high_base);
+    printf("cache: %u records x %zu B = %zu B of %zu B budget\n",
+           slot_count, sizeof(insn_record_t), slot_count * sizeof(insn_record_t), budget);
+    printf("routines: %u seeded from properties, %u reached\n", s_seeded_count, s_routine_count);
+    printf("fetches: %.0f, hits %.3f%%, misses %u, evictions %u, uncached %u\n",
+           fetches, fetches > 0 ? 100.0 * stats->hits / fetches : 0.0,
+           stats->misses, stats->evictions, stats->uncached);
+    printf("host: decode every time %.2f ns/instr, cached %.2f ns/instr (%.1f%% of decode)\n",
+           decode_ns / (double)steps, cached_ns / (double)steps,
+           decode_ns > 0 ? 100.0 * cached_ns / decode_ns : 0.0);
+
+    free(slots);
+    return 0;
+}
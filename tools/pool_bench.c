@@ -0,0 +1,300 @@
+/*
+ * pool_bench.c
+ *
+ * Host benchmark for src/fizmo_pool_alloc.c.
+ *
+ * Replays a synthetic libfizmo-like allocation pattern (mostly short
+ * strings, list nodes and z_file records, with occasional large buffers)
+ * against a model of FreeRTOS heap_4, once on its own and once behind the
+ * size-class pools, as the device's malloc wrappers do. Prints time per
+ * operation, heap_4 free-list steps per allocation, failed requests, and
+ * the heap's fragmentation (free bytes, free blocks and the largest free
+ * block) at the end of the run, then per-class pool occupancy.
+ *
+ *   cc -O2 -Isrc tools/pool_bench.c src/fizmo_pool_alloc.c -o pool_bench
+ *   ./pool_bench [region_kb] [operations] [heap_kb]
+ *
+ * heap_kb defaults to configTOTAL_HEAP_SIZE of the FreeRTOS build (1 MB);
+ * the pool region is a separate static array on the device, so both runs
+ * get the same heap. Add -DFIZMO_POOL_WEIGHTS=a,b,c,d,e to try the weights
+ * tools/pool_weights.py suggests.
+ */
+
+#include "fizmo_pool_alloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LIVE_SLOTS 2048
+
+static uint32_t s_rng = 12345;
+
+static uint32_t next_random(void)
+{
+    s_rng = s_rng * 1103515245u + 12345u;
+    return s_rng >> 8;
+}
+
+/* Size mix: ~85% <= 64 bytes, ~12% up to 256, ~3% large buffers */
+static size_t next_size(void)
+{
+    uint32_t r = next_random() % 100;
+    if (r < 50) return 8 + next_random() % 24;
+    if (r < 85) return 24 + next_random() % 40;
+    if (r < 97) return 64 + next_random() % 192;
+    return 512 + next_random() % 3584;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/*
+ * heap_4 model: first fit over an address-ordered free list, blocks split
+ * when the remainder exceeds the minimum block size, neighbours coalesced
+ * on free. Headers are the 8-byte BlockLink_t of the 32-bit port (offsets
+ * instead of pointers), with the top size bit marking allocated blocks.
+ */
+#define H4_ALIGN        8u
+#define H4_HEADER       8u
+#define H4_MIN_BLOCK    (2u * H4_HEADER)
+#define H4_ALLOCATED    0x80000000u
+#define H4_END          0xFFFFFFFFu
+
+typedef struct {
+    uint32_t next;      /* Offset of the next free block, or H4_END */
+    uint32_t size;      /* Block size including the header */
+} h4_link_t;
+
+static uint8_t *s_h4 = NULL;
+static uint32_t s_h4_first = H4_END;   /* xStart.pxNextFreeBlock */
+static uint32_t s_h4_free_bytes = 0;
+static uint64_t s_h4_steps = 0;        /* Free blocks visited by malloc */
+static uint64_t s_h4_allocs = 0;
+static uint64_t s_h4_failed = 0;
+
+static h4_link_t* h4_link(uint32_t offset)
+{
+    return (h4_link_t *)(s_h4 + offset);
+}
+
+static void h4_insert(uint32_t block)
+{
+    /* Find the free block just below this one */
+    uint32_t prev = H4_END;
+    uint32_t next = s_h4_first;
+    while (next != H4_END && next < block) {
+        prev = next;
+        next = h4_link(next)->next;
+    }
+
+    /* Merge with the block above, then with the one below */
+    h4_link_t *link = h4_link(block);
+    if (next != H4_END && block + link->size == next) {
+        link->size += h4_link(next)->size;
+        link->next = h4_link(next)->next;
+    } else {
+        link->next = next;
+    }
+    if (prev != H4_END && prev + h4_link(prev)->size == block) {
+        h4_link(prev)->size += link->size;
+        h4_link(prev)->next = link->next;
+    } else if (prev != H4_END) {
+        h4_link(prev)->next = block;
+    } else {
+        s_h4_first = block;
+    }
+}
+
+static void h4_init(size_t size)
+{
+    free(s_h4);
+    s_h4 = aligned_alloc(H4_ALIGN, size);
+    if (s_h4 == NULL) {
+        fprintf(stderr, "pool_bench: cannot allocate %zu byte heap\n", size);
+        exit(1);
+    }
+    s_h4_first = 0;
+    h4_link(0)->next = H4_END;
+    h4_link(0)->size = (uint32_t)size & ~(H4_ALIGN - 1);
+    s_h4_free_bytes = h4_link(0)->size;
+    s_h4_steps = 0;
+    s_h4_allocs = 0;
+    s_h4_failed = 0;
+}
+
+static void* h4_malloc(size_t size)
+{
+    uint32_t want = (uint32_t)((size + H4_HEADER + H4_ALIGN - 1) & ~(size_t)(H4_ALIGN - 1));
+
+    uint32_t prev = H4_END;
+    uint32_t block = s_h4_first;
+    s_h4_allocs++;
+    while (block != H4_END && h4_link(block)->size < want) {
+        s_h4_steps++;
+        prev = block;
+        block = h4_link(block)->next;
+    }
+    if (block == H4_END) {
+        s_h4_failed++;
+        return NULL;
+    }
+    s_h4_steps++;
+
+    h4_link_t *link = h4_link(block);
+    if (prev != H4_END) {
+        h4_link(prev)->next = link->next;
+    } else {
+        s_h4_first = link->next;
+    }
+    if (link->size - want > H4_MIN_BLOCK) {
+        uint32_t rest = block + want;
+        h4_link(rest)->size = link->size - want;
+        link->size = want;
+        h4_insert(rest);
+    }
+    s_h4_free_bytes -= link->size;
+    link->size |= H4_ALLOCATED;
+    link->next = H4_END;
+    return s_h4 + block + H4_HEADER;
+}
+
+static void h4_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    uint32_t block = (uint32_t)((uint8_t *)ptr - s_h4) - H4_HEADER;
+    h4_link(block)->size &= ~H4_ALLOCATED;
+    s_h4_free_bytes += h4_link(block)->size;
+    h4_insert(block);
+}
+
+typedef struct {
+    uint32_t free_bytes;
+    uint32_t free_blocks;
+    uint32_t largest_free;
+} h4_layout_t;
+
+static void h4_layout(h4_layout_t *layout)
+{
+    memset(layout, 0, sizeof(*layout));
+    layout->free_bytes = s_h4_free_bytes;
+    for (uint32_t block = s_h4_first; block != H4_END; block = h4_link(block)->next) {
+        layout->free_blocks++;
+        if (h4_link(block)->size > layout->largest_free) {
+            layout->largest_free = h4_link(block)->size;
+        }
+    }
+}
+
+static void* pool_malloc(size_t size)
+{
+    void *ptr = fizmo_pool_alloc(size);
+    return ptr ? ptr : h4_malloc(size);
+}
+
+static void pool_release(void *ptr)
+{
+    if (fizmo_pool_owns(ptr)) {
+        fizmo_pool_free(ptr);
+    } else {
+        h4_free(ptr);
+    }
+}
+
+typedef struct {
+    double ns_per_op;
+    double steps_per_alloc;
+    uint64_t heap_allocs;
+    uint64_t failed;
+    h4_layout_t layout;     /* With the run's live blocks still allocated */
+} run_result_t;
+
+static void run(void* (*alloc_fn)(size_t), void (*free_fn)(void *), long operations,
+                size_t heap_bytes, run_result_t *result)
+{
+    static void *slots[LIVE_SLOTS];
+    memset(slots, 0, sizeof(slots));
+    s_rng = 12345;
+    h4_init(heap_bytes);
+
+    double start = now_seconds();
+    for (long i = 0; i < operations; i++) {
+        uint32_t slot = next_random() % LIVE_SLOTS;
+        if (slots[slot]) {
+            free_fn(slots[slot]);
+            slots[slot] = NULL;
+        } else {
+            slots[slot] = alloc_fn(next_size());
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    result->ns_per_op = elapsed * 1e9 / (double)operations;
+    result->heap_allocs = s_h4_allocs;
+    result->steps_per_alloc = s_h4_allocs ? (double)s_h4_steps / (double)s_h4_allocs : 0.0;
+    result->failed = s_h4_failed;
+    h4_layout(&result->layout);
+
+    for (int i = 0; i < LIVE_SLOTS; i++) {
+        if (slots[i]) {
+            free_fn(slots[i]);
+        }
+    }
+}
+
+static void print_result(const char *label, const run_result_t *result)
+{
+    const h4_layout_t *layout = &result->layout;
+    double fragmentation = layout->free_bytes
+        ? 100.0 * (1.0 - (double)layout->largest_free / (double)layout->free_bytes) : 0.0;
+
+    printf("%-14s %6.1f  %10llu  %6.2f  %6llu  %8u  %6u  %8u  %5.1f%%\n", label,
+           result->ns_per_op, (unsigned long long)result->heap_allocs,
+           result->steps_per_alloc, (unsigned long long)result->failed,
+           layout->free_bytes, layout->free_blocks, layout->largest_free, fragmentation);
+}
+
+int main(int argc, char **argv)
+{
+    size_t region_kb = argc > 1 ? (size_t)atol(argv[1]) : 64;
+    long operations = argc > 2 ? atol(argv[2]) : 10000000L;
+    size_t heap_kb = argc > 3 ? (size_t)atol(argv[3]) : 1024;
+
+    void *region = aligned_alloc(8, region_kb * 1024);
+    if (region == NULL) {
+        fprintf(stderr, "pool_bench: cannot allocate %zu KB region\n", region_kb);
+        return 1;
+    }
+    fizmo_pool_init(region, region_kb * 1024);
+
+    run_result_t pool_result;
+    run_result_t heap_result;
+    run(pool_malloc, pool_release, operations, heap_kb * 1024, &pool_result);
+    run(h4_malloc, h4_free, operations, heap_kb * 1024, &heap_result);
+
+    printf("operations: %ld, region: %zu KB, heap_4: %zu KB\n", operations, region_kb, heap_kb);
+    printf("\n                ns/op  heap allocs  steps  failed  free B    blocks  largest   frag\n");
+    print_result("pool+heap_4", &pool_result);
+    print_result("heap_4 only", &heap_result);
+    printf("\n(steps: heap_4 free blocks visited per heap allocation; frag: share of free\n"
+           " bytes outside the largest free block, measured with the live set in place)\n");
+
+    printf("\n class  blocks  peak   allocs      exhausted\n");
+    for (int i = 0; i < FIZMO_POOL_CLASS_COUNT; i++) {
+        fizmo_pool_class_stats_t stats;
+        fizmo_pool_get_stats(i, &stats);
+        printf(" %5zu  %6u  %5u  %10u  %9u\n", stats.block_size, stats.total_blocks,
+               stats.peak_in_use, stats.alloc_count, stats.exhausted_count);
+    }
+
+    free(region);
+    free(s_h4);
+    return 0;
+}
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""
+pool_weights.py
+
+Pool class weights (FIZMO_POOL_WEIGHTS) from a device log.
+
+Run a walkthrough on the board with FIZMO_POOL_ALLOC and FIZMO_BENCHMARK,
+which log one line per pool class after every command:
+
+  pool  32: 12/384 in use, peak 301, 5120 allocs, 0 fell back to heap
+
+and/or FIZMO_HEAP_TELEMETRY, whose snapshot (on exit and from the
+malloc-failed hook) includes the request-size histogram:
+
+  heap:  <=   32: 4711
+
+Live-block peaks are what the pool slices have to hold, so the pool lines
+are used when present. A class that fell back to the heap was too small to
+show its real peak; its figure is a lower bound and is flagged. Without
+pool lines the histogram's allocation counts stand in for the peaks, which
+assumes similar block lifetimes across classes. Several logs can be given;
+each class takes its highest figure.
+
+  tools/pool_weights.py uart.log
+  cmake ... -DFIZMO_POOL_WEIGHTS=4,8,5,1,2
+
+Only the Python standard library is used.
+"""
+
+import argparse
+import re
+import sys
+
+CLASS_SIZES = [16, 32, 64, 128, 256]
+HEADROOM_PERCENT = 25
+
+POOL_LINE = re.compile(r"pool\s+(\d+): (\d+)/(\d+) in use, peak (\d+), (\d+) allocs, (\d+) fell back")
+HISTOGRAM_LINE = re.compile(r"heap:\s+<=\s*(\d+): (\d+)")
+
+
+def read_log(path, peaks, fallbacks, histogram):
+    """Collect the last figures of one log into the per-class dicts."""
+    log_peaks = {}
+    log_fallbacks = {}
+    log_histogram = {}
+    with open(path, "r", encoding="ascii", errors="replace") as handle:
+        for line in handle:
+            match = POOL_LINE.search(line)
+            if match:
+                size = int(match.group(1))
+                log_peaks[size] = int(match.group(4))
+                log_fallbacks[size] = int(match.group(6))
+                continue
+            match = HISTOGRAM_LINE.search(line)
+            if match:
+                log_histogram[int(match.group(1))] = int(match.group(2))
+    for size, peak in log_peaks.items():
+        peaks[size] = max(peaks.get(size, 0), peak)
+        fallbacks[size] = max(fallbacks.get(size, 0), log_fallbacks[size])
+    for size, count in log_histogram.items():
+        histogram[size] = max(histogram.get(size, 0), count)
+
+
+def weights_from(figures):
+    """Returns: small integer weights proportional to figures, the
+    smallest non-zero class getting 1."""
+    smallest = min(value for value in figures if value > 0)
+    return [int(round(value / smallest)) if value > 0 else 0 for value in figures]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Derive FIZMO_POOL_WEIGHTS from a device log")
+    parser.add_argument("logs", nargs="+", help="UART logs with 'pool' and/or 'heap:' lines")
+    args = parser.parse_args()
+
+    peaks, fallbacks, histogram = {}, {}, {}
+    for path in args.logs:
+        read_log(path, peaks, fallbacks, histogram)
+
+    if any(size in peaks for size in CLASS_SIZES):
+        source = "live-block peaks (pool lines)"
+        figures = [peaks.get(size, 0) for size in CLASS_SIZES]
+    elif any(size in histogram for size in CLASS_SIZES):
+        source = "allocation counts (heap histogram)"
+        figures = [histogram.get(size, 0) for size in CLASS_SIZES]
+    else:
+        sys.exit("pool_weights: no 'pool' or 'heap:' lines in the log")
+    if not any(figures):
+        sys.exit("pool_weights: every pool class is empty in the log")
+
+    weights = weights_from(figures)
+    print("source: %s" % source)
+    print(" class  figure  weight")
+    for size, figure, weight in zip(CLASS_SIZES, figures, weights):
+        note = "  lower bound: %d fell back to heap" % fallbacks[size] if fallbacks.get(size) else ""
+        print(" %5d  %6d  %6d%s" % (size, figure, weight, note))
+
+    if source.startswith("live"):
+        needed = sum(size * peak for size, peak in zip(CLASS_SIZES, figures))
+        print("pool region for these peaks + %d%%: %d bytes (FIZMO_POOL_REGION_SIZE)"
+              % (HEADROOM_PERCENT, needed * (100 + HEADROOM_PERCENT) // 100))
+    print("-DFIZMO_POOL_WEIGHTS=%s" % ",".join(str(weight) for weight in weights))
+
+
+if __name__ == "__main__":
+    main()
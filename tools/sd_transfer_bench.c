@@ -0,0 +1,160 @@
+/*
+ * sd_transfer_bench.c
+ *
+ * Host check for src/sd_transfer.c over a RAM disk.
+ *
+ * Replays a FatFS-like sector pattern (single-sector FAT/directory
+ * updates, sequential multi-sector file data, buffers at random byte
+ * offsets) through the transfer layer and, in parallel, straight into a
+ * reference image. Every read is compared with the reference and the
+ * final disk must match it after sync. Prints driver command counts with
+ * and without the transfer layer.
+ *
+ *   cc -O2 -Isrc tools/sd_transfer_bench.c src/sd_transfer.c -o sd_transfer_bench
+ *   ./sd_transfer_bench [operations]
+ */
+
+#include "sd_transfer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTOR_SIZE     512
+#define DISK_SECTORS    4096
+#define MAX_RUN         16
+
+typedef struct {
+    uint8_t *data;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t unaligned;     /* Driver calls with a buffer DMA could not use */
+} ram_disk_t;
+
+static uint32_t s_rng = 12345;
+
+static uint32_t next_random(void)
+{
+    s_rng = s_rng * 1103515245u + 12345u;
+    return s_rng >> 8;
+}
+
+static int ram_read(void *ctx, uint8_t *buf, uint32_t sector, uint32_t count)
+{
+    ram_disk_t *disk = ctx;
+    if (sector + count > DISK_SECTORS) {
+        return -1;
+    }
+    if ((uintptr_t)buf & (SD_TRANSFER_ALIGN - 1)) {
+        disk->unaligned++;
+    }
+    memcpy(buf, disk->data + (size_t)sector * SECTOR_SIZE, (size_t)count * SECTOR_SIZE);
+    disk->reads++;
+    return 0;
+}
+
+static int ram_write(void *ctx, const uint8_t *buf, uint32_t sector, uint32_t count)
+{
+    ram_disk_t *disk = ctx;
+    if (sector + count > DISK_SECTORS) {
+        return -1;
+    }
+    if ((uintptr_t)buf & (SD_TRANSFER_ALIGN - 1)) {
+        disk->unaligned++;
+    }
+    memcpy(disk->data + (size_t)sector * SECTOR_SIZE, buf, (size_t)count * SECTOR_SIZE);
+    disk->writes++;
+    return 0;
+}
+
+/* One request: mostly short FAT/dir touches, some sequential data runs */
+static void next_request(uint32_t *sector, uint32_t *count, uint32_t *next_data)
+{
+    uint32_t r = next_random() % 100;
+    if (r < 40) {
+        *sector = next_random() % 64;               /* FAT and root directory */
+        *count = 1;
+    } else {
+        if (r < 50 || *next_data + MAX_RUN >= DISK_SECTORS) {
+            *next_data = 64 + next_random() % (DISK_SECTORS - 64 - MAX_RUN);
+        }
+        *sector = *next_data;
+        *count = 1 + next_random() % 4;
+        *next_data += *count;                        /* Consecutive cluster writes */
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long operations = argc > 1 ? atol(argv[1]) : 200000L;
+
+    ram_disk_t disk = { calloc(DISK_SECTORS, SECTOR_SIZE), 0, 0, 0 };
+    uint8_t *reference = calloc(DISK_SECTORS, SECTOR_SIZE);
+    uint8_t *window = aligned_alloc(SD_TRANSFER_ALIGN, MAX_RUN * SECTOR_SIZE + SD_TRANSFER_ALIGN);
+    uint8_t *stage = aligned_alloc(SD_TRANSFER_ALIGN, SD_TRANSFER_STAGE_SECTORS * SECTOR_SIZE);
+    if (!disk.data || !reference || !window || !stage) {
+        fprintf(stderr, "sd_transfer_bench: out of memory\n");
+        return 1;
+    }
+
+    sd_transfer_ops_t ops = { ram_read, ram_write, NULL, NULL, &disk };
+    sd_transfer_t xfer;
+    sd_transfer_init(&xfer, &ops, stage, SD_TRANSFER_STAGE_SECTORS, SECTOR_SIZE);
+
+    uint32_t requests_read = 0, requests_write = 0, next_data = 64, mismatches = 0;
+    for (long i = 0; i < operations; i++) {
+        uint32_t sector, count;
+        next_request(&sector, &count, &next_data);
+
+        /* FatFS passes its window or the caller's buffer: aligned or any offset */
+        uint8_t *buf = window + (next_random() % 2 ? 0 : 4 * (next_random() % (SD_TRANSFER_ALIGN / 4)));
+        size_t bytes = (size_t)count * SECTOR_SIZE;
+        uint8_t *ref = reference + (size_t)sector * SECTOR_SIZE;
+
+        uint32_t op = next_random() % 100;
+        if (op < 55) {
+            for (size_t b = 0; b < bytes; b++) {
+                buf[b] = (uint8_t)next_random();
+            }
+            memcpy(ref, buf, bytes);
+            if (sd_transfer_write(&xfer, buf, sector, count) != 0) {
+                fprintf(stderr, "sd_transfer_bench: write error\n");
+                return 1;
+            }
+            requests_write++;
+        } else if (op < 97) {
+            if (sd_transfer_read(&xfer, buf, sector, count) != 0) {
+                fprintf(stderr, "sd_transfer_bench: read error\n");
+                return 1;
+            }
+            if (memcmp(buf, ref, bytes) != 0) {
+                mismatches++;
+            }
+            requests_read++;
+        } else {
+            sd_transfer_sync(&xfer);                 /* f_sync / f_close */
+        }
+    }
+    sd_transfer_sync(&xfer);
+
+    if (memcmp(disk.data, reference, (size_t)DISK_SECTORS * SECTOR_SIZE) != 0) {
+        mismatches++;
+    }
+
+    printf("requests: %u reads, %u writes (stage %u sectors)\n",
+           requests_read, requests_write, (unsigned)SD_TRANSFER_STAGE_SECTORS);
+    printf("driver:   %u reads, %u writes, %u unaligned buffers\n",
+           disk.reads, disk.writes, disk.unaligned);
+    printf("layer:    %u sectors read, %u written, %u bounced, %u coalesced\n",
+           xfer.stats.sectors_read, xfer.stats.sectors_written,
+           xfer.stats.bounced_sectors, xfer.stats.coalesced_writes);
+    printf("write commands saved: %.1f%%\n",
+           requests_write ? 100.0 * (1.0 - (double)disk.writes / requests_write) : 0.0);
+    printf("%s\n", mismatches == 0 ? "PASS: disk matches reference" : "FAIL: data mismatch");
+
+    free(stage);
+    free(window);
+    free(reference);
+    free(disk.data);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""
+story_catalog.py
+
+Multi-story image for the embedded build (FIZMO_STORY_CATALOG).
+
+Several story files are concatenated behind a fixed-size entry table, so
+the firmware finds story i at a computed address without scanning
+(src/story_catalog.c). Each entry carries the name shown in the picker
+and the release/serial/checksum from the story header, so the UI can
+tell two releases of the same game apart.
+
+Image layout (little-endian):
+
+  "ZCAT"              magic
+  u8   version        1
+  u8   entry_size     48
+  u16  count
+  entries[count]:
+    char name[24]     NUL-padded
+    u32  offset       from image start, 4-byte aligned
+    u32  size         bytes stored (packed image size when FLAG_PACKED)
+    u16  release      story header 0x02
+    u16  checksum     story header 0x1C
+    char serial[6]    story header 0x12
+    u8   zversion     story header 0x00
+    u8   flags        bit 0: story stored as a story_pack.py image
+    u8   reserved[4]
+  ...  story data
+
+Only the Python standard library is used:
+
+  tools/story_catalog.py build zork.zcat zork1=zork1.z3 zork2=zork2.z3 --pack
+  tools/story_catalog.py info zork.zcat
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+import story_pack
+
+MAGIC = b"ZCAT"
+VERSION = 1
+HEADER = struct.Struct("<4sBBH")
+ENTRY = struct.Struct("<24sIIHH6sBB4x")
+NAME_MAX = 23
+FLAG_PACKED = 0x01
+ALIGN = 4
+
+
+def story_metadata(story):
+    """Returns: (zversion, release, serial, checksum) from a story header."""
+    if len(story) < 64 or story[0] not in (1, 2, 3, 4, 5, 6, 7, 8):
+        raise ValueError("not a Z-machine story file")
+    release = (story[2] << 8) | story[3]
+    serial = bytes(story[0x12:0x18])
+    checksum = (story[0x1C] << 8) | story[0x1D]
+    return story[0], release, serial, checksum
+
+
+def build(stories, block_shift=None):
+    """stories: list of (name, bytes). Returns: the catalog image."""
+    header_size = HEADER.size + ENTRY.size * len(stories)
+    entries = []
+    payloads = []
+    offset = header_size
+    for name, story in stories:
+        zversion, release, serial, checksum = story_metadata(story)
+        data = story
+        flags = 0
+        if block_shift is not None:
+            data = story_pack.pack(story, block_shift)
+            flags |= FLAG_PACKED
+        offset = (offset + ALIGN - 1) & ~(ALIGN - 1)
+        entries.append(ENTRY.pack(name.encode("ascii"), offset, len(data),
+                                  release, checksum, serial, zversion, flags))
+        payloads.append((offset, data))
+        offset += len(data)
+
+    image = bytearray(HEADER.pack(MAGIC, VERSION, ENTRY.size, len(stories)))
+    for entry in entries:
+        image.extend(entry)
+    for start, data in payloads:
+        image.extend(b"\0" * (start - len(image)))
+        image.extend(data)
+    return bytes(image)
+
+
+def parse(image):
+    """Returns: list of entry dicts, raising ValueError on a bad image."""
+    magic, version, entry_size, count = HEADER.unpack_from(image, 0)
+    if magic != MAGIC or version != VERSION or entry_size != ENTRY.size:
+        raise ValueError("not a ZCAT v%d image" % VERSION)
+    entries = []
+    for i in range(count):
+        name, offset, size, release, checksum, serial, zversion, flags = \
+            ENTRY.unpack_from(image, HEADER.size + i * ENTRY.size)
+        if offset + size > len(image):
+            raise ValueError("entry %d runs past the end of the image" % i)
+        data = image[offset:offset + size]
+        if flags & FLAG_PACKED:
+            data = story_pack.unpack(data)[0]
+        if story_metadata(data) != (zversion, release, serial, checksum):
+            raise ValueError("entry %d header does not match its story" % i)
+        entries.append({
+            "name": name.rstrip(b"\0").decode("ascii"),
+            "offset": offset, "size": size, "story_size": len(data),
+            "release": release, "serial": serial.decode("ascii", "replace"),
+            "checksum": checksum, "zversion": zversion, "flags": flags,
+        })
+    return entries
+
+
+def parse_story_arg(arg):
+    """NAME=PATH, or PATH with the basename (no extension) as the name."""
+    if "=" in arg:
+        name, path = arg.split("=", 1)
+    else:
+        path = arg
+        name = os.path.splitext(os.path.basename(path))[0]
+    if not name or len(name) > NAME_MAX or not all(32 <= ord(c) < 127 for c in name):
+        raise ValueError("story name must be 1-%d printable ASCII characters: %r" % (NAME_MAX, name))
+    return name, path
+
+
+def cmd_build(args):
+    stories = []
+    for arg in args.stories:
+        try:
+            name, path = parse_story_arg(arg)
+        except ValueError as err:
+            sys.stderr.write("story_catalog: %s\n" % err)
+            return 1
+        with open(path, "rb") as handle:
+            stories.append((name, handle.read()))
+    if len(stories) > 0xFFFF:
+        sys.stderr.write("story_catalog: too many stories\n")
+        return 1
+
+    block_shift = None
+    if args.pack:
+        if args.block_size not in (1024, 2048, 4096):
+            sys.stderr.write("story_catalog: block size must be 1024, 2048 or 4096\n")
+            return 1
+        block_shift = args.block_size.bit_length() - 1
+
+    try:
+        image = build(stories, block_shift)
+        entries = parse(image)
+    except ValueError as err:
+        sys.stderr.write("story_catalog: %s\n" % err)
+        return 1
+    with open(args.output, "wb") as handle:
+        handle.write(image)
+    raw = sum(len(story) for _name, story in stories)
+    print("story_catalog: %u stories, %u bytes (%u bytes of story data%s): %s"
+          % (len(entries), len(image), raw, ", packed" if args.pack else "",
+             ", ".join(e["name"] for e in entries)))
+    return 0
+
+
+def cmd_info(args):
+    with open(args.image, "rb") as handle:
+        image = handle.read()
+    for index, e in enumerate(parse(image)):
+        print("%2u  %-23s  v%u  release %u / %s  checksum %04X  %u bytes%s"
+              % (index, e["name"], e["zversion"], e["release"], e["serial"], e["checksum"],
+                 e["size"], " (packed, %u unpacked)" % e["story_size"]
+                 if e["flags"] & FLAG_PACKED else ""))
+    return 0
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Multi-story catalog image")
+    sub = parser.add_subparsers(dest="command")
+    sub.required = True
+
+    bd = sub.add_parser("build", help="build a catalog from story files")
+    bd.add_argument("output")
+    bd.add_argument("stories", nargs="+", metavar="[NAME=]STORY",
+                    help="story file, optionally named (default: file name without extension)")
+    bd.add_argument("--pack", action="store_true",
+                    help="store each story block-compressed (see story_pack.py)")
+    bd.add_argument("--block-size", type=int, default=2048,
+                    help="block size with --pack: 1024, 2048 or 4096 (default 2048)")
+    bd.set_defaults(func=cmd_build)
+
+    inf = sub.add_parser("info", help="verify and list a catalog image")
+    inf.add_argument("image")
+    inf.set_defaults(func=cmd_info)
+
+    args = parser.parse_args(argv)
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,704 @@
+#!/usr/bin/env python3
+"""
+story_glyphs.py
+
+Exact glyph set for a story: decodes every string the story file can print
+and adds the interpreter's and UI's own text, then
+
+  - writes a QML priming component (hidden Text items per pixel size) so
+    the font engine has every glyph the game can show, and nothing else,
+  - checks a fontmap (.fmp) or TrueType font for missing and unused code
+    points and estimates the glyph cache the set needs per pixel size,
+  - optionally subsets a TrueType font to the set (needs fontTools).
+
+Story text is collected from the abbreviation table, object short names,
+the dictionary, inline print/print_ret strings and constant print_paddr,
+print_addr and print_char operands in code reachable from the entry point
+and from routine-valued object properties, print_num digits, and the
+string area that follows the last routine. Interpreter messages are read
+from character and string literals in C sources (--source), UI text from
+`text: "..."` and `keyPressed("...")` in QML files (--qml-source).
+
+  tools/story_glyphs.py zork1.z3 --source src/fizmo_locale_stubs.c \\
+      --source src/fizmo_rtos_bridge.c \\
+      --qml-source ui/qul/ZorkUI/ZorkUI_RT1050.qml \\
+      --qml-source ui/qul/ZorkUI/ZorkKeyboard.qml \\
+      --qml ui/qul/ZorkUI/StoryGlyphs.qml --sizes 16 \\
+      --fontmap ui/qul/ZorkUI/fonts/ZorkMCUFontmap.fmp
+
+Several story files give the union of their glyph sets (catalog builds).
+
+Supports story versions 1-5, 7 and 8. Only the Python standard library is
+used, except for --subset.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+A0 = "abcdefghijklmnopqrstuvwxyz"
+A1 = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+A2_V1 = "\0" + "0123456789.,!?_#'\"/\\<-:()"          # z-char 6 = ZSCII escape
+A2 = "\0\n" + "0123456789.,!?_#'\"/\\-:()"            # z-char 7 = newline (V2+)
+
+# ZSCII 155-223 without a Unicode translation table (standard 3.8.5.4.1)
+DEFAULT_EXTRA = [
+    0xE4, 0xF6, 0xFC, 0xC4, 0xD6, 0xDC, 0xDF, 0xBB, 0xAB, 0xEB, 0xEF, 0xFF,
+    0xCB, 0xCF, 0xE1, 0xE9, 0xED, 0xF3, 0xFA, 0xFD, 0xC1, 0xC9, 0xCD, 0xD3,
+    0xDA, 0xDD, 0xE0, 0xE8, 0xEC, 0xF2, 0xF9, 0xC0, 0xC8, 0xCC, 0xD2, 0xD9,
+    0xE2, 0xEA, 0xEE, 0xF4, 0xFB, 0xC2, 0xCA, 0xCE, 0xD4, 0xDB, 0xE5, 0xC5,
+    0xF8, 0xD8, 0xE3, 0xF1, 0xF5, 0xC3, 0xD1, 0xD5, 0xE6, 0xC6, 0xE7, 0xC7,
+    0xFE, 0xF0, 0xDE, 0xD0, 0xA3, 0x153, 0x152, 0xA1, 0xBF,
+]
+
+# Opcode kinds
+OP0, OP1, OP2, VAR, EXT = range(5)
+
+
+class DecodeError(Exception):
+    pass
+
+
+class Story:
+    def __init__(self, data):
+        if len(data) < 64:
+            raise DecodeError("file too short for a story header")
+        self.data = data
+        self.size = len(data)
+        self.version = data[0]
+        if self.version not in (1, 2, 3, 4, 5, 7, 8):
+            raise DecodeError("unsupported story version %d" % self.version)
+        self.high_base = self.word(0x04)
+        self.static_base = self.word(0x0E)
+        length = self.word(0x1A) * (2 if self.version <= 3 else 4 if self.version <= 5 else 8)
+        self.size = min(len(data), length) if length else len(data)
+        self.packing = 2 if self.version <= 3 else 4 if self.version <= 5 else 8
+        self.string_offset = 8 * self.word(0x2A) if self.version == 7 else 0
+        self.routine_offset = 8 * self.word(0x28) if self.version == 7 else 0
+        self.alphabets = self._alphabets()
+        self.extra = self._unicode_table()
+
+    def byte(self, addr):
+        if addr >= self.size:
+            raise DecodeError("read past end of story at 0x%X" % addr)
+        return self.data[addr]
+
+    def word(self, addr):
+        return (self.byte(addr) << 8) | self.byte(addr + 1)
+
+    def unpack_routine(self, packed):
+        return packed * self.packing + self.routine_offset
+
+    def unpack_string(self, packed):
+        return packed * self.packing + self.string_offset
+
+    def _alphabets(self):
+        if self.version == 1:
+            return [A0, A1, A2_V1]
+        table = self.word(0x34) if self.version >= 5 else 0
+        if table == 0:
+            return [A0, A1, A2]
+        rows = []
+        for row in range(3):
+            chars = "".join(chr(self.byte(table + 26 * row + i)) for i in range(26))
+            rows.append(chars)
+        # Z-char 6 of A2 is always the escape and 7 always newline
+        rows[2] = "\0\n" + rows[2][2:]
+        return rows
+
+    def _unicode_table(self):
+        if self.version < 5:
+            return DEFAULT_EXTRA
+        ext = self.word(0x36)
+        if ext == 0 or self.word(ext) < 3:
+            return DEFAULT_EXTRA
+        table = self.word(ext + 6)
+        if table == 0:
+            return DEFAULT_EXTRA
+        count = self.byte(table)
+        return [self.word(table + 1 + 2 * i) for i in range(count)]
+
+    def zscii(self, code):
+        """Returns: the character for a ZSCII output code, or None."""
+        if code == 13:
+            return "\n"
+        if 32 <= code <= 126:
+            return chr(code)
+        if 155 <= code < 155 + len(self.extra):
+            return chr(self.extra[code - 155])
+        return None
+
+    def decode(self, addr, max_words=None, abbreviations=True):
+        """Decode a Z-string. Returns: (text, address after the string)."""
+        out = []
+        alphabet = lock = 0
+        pending_abbrev = 0
+        escape = []
+        words = 0
+        while True:
+            w = self.word(addr)
+            addr += 2
+            words += 1
+            for shift in (10, 5, 0):
+                zc = (w >> shift) & 0x1F
+                if escape:
+                    escape.append(zc)
+                    if len(escape) == 3:
+                        ch = self.zscii((escape[1] << 5) | escape[2])
+                        if ch is not None:
+                            out.append(ch)
+                        escape = []
+                    continue
+                if pending_abbrev:
+                    if abbreviations:
+                        out.append(self.abbreviation(32 * (pending_abbrev - 1) + zc))
+                    pending_abbrev = 0
+                    continue
+                current = alphabet
+                alphabet = lock
+                if zc == 0:
+                    out.append(" ")
+                elif zc == 1 and self.version == 1:
+                    out.append("\n")
+                elif zc <= 3 and (self.version >= 3 or zc == 1):
+                    pending_abbrev = zc
+                elif zc <= 5:
+                    if self.version <= 2:
+                        step = 1 if zc in (2, 4) else 2
+                        alphabet = (lock + step) % 3
+                        if zc >= 4:
+                            lock = alphabet
+                    else:
+                        alphabet = 1 if zc == 4 else 2
+                elif current == 2 and zc == 6:
+                    escape = [zc]
+                else:
+                    out.append(self.alphabets[current][zc - 6])
+            if w & 0x8000 or (max_words is not None and words >= max_words):
+                break
+        return "".join(out), addr
+
+    def abbreviation(self, index):
+        table = self.word(0x18)
+        if table == 0:
+            return ""
+        return self.decode(2 * self.word(table + 2 * index), abbreviations=False)[0]
+
+
+class Collector:
+    """Walks the story and gathers every string it can print."""
+
+    def __init__(self, story):
+        self.story = story
+        self.texts = []
+        self.routines_done = set()
+        self.code_end = 0
+        self.string_refs = set()
+
+    def add(self, text):
+        self.texts.append(text)
+
+    def abbreviations(self):
+        table = self.story.word(0x18)
+        count = 96 if self.story.version >= 3 else 32
+        if self.story.version == 1 or table == 0:
+            return
+        for i in range(count):
+            self.add(self.story.decode(2 * self.story.word(table + 2 * i), abbreviations=False)[0])
+
+    def objects(self):
+        """Short names; also returns word-sized property values."""
+        s = self.story
+        objects = s.word(0x0A)
+        entry_size = 9 if s.version <= 3 else 14
+        first = objects + (31 if s.version <= 3 else 63) * 2
+        lowest_props = s.static_base
+        values = []
+        obj = first
+        while obj + entry_size <= lowest_props:
+            props = s.word(obj + entry_size - 2)
+            lowest_props = min(lowest_props, props)
+            obj += entry_size
+            if props + 1 >= s.static_base:
+                continue
+            name_words = s.byte(props)
+            if name_words:
+                self.add(s.decode(props + 1, max_words=name_words)[0])
+            p = props + 1 + 2 * name_words
+            while p < s.static_base and s.byte(p) != 0:
+                b = s.byte(p)
+                header = 1
+                if s.version <= 3:
+                    size = (b >> 5) + 1
+                elif b & 0x80:
+                    header = 2
+                    size = (s.byte(p + 1) & 0x3F) or 64
+                else:
+                    size = 2 if b & 0x40 else 1
+                if size == 2:
+                    values.append(s.word(p + header))
+                p += header + size
+        return values
+
+    def dictionary(self):
+        s = self.story
+        d = s.word(0x08)
+        separators = s.byte(d)
+        self.add("".join(s.zscii(s.byte(d + 1 + i)) or "" for i in range(separators)))
+        entry_length = s.byte(d + 1 + separators)
+        count = s.word(d + 2 + separators)
+        if count >= 0x8000:
+            count = 0x10000 - count     # Negative: unsorted, same layout
+        first = d + 4 + separators
+        text_words = 2 if s.version <= 3 else 3
+        for i in range(count):
+            self.add(s.decode(first + i * entry_length, max_words=text_words)[0])
+
+    # --- Code walk -------------------------------------------------------
+
+    def has_store(self, kind, op):
+        v = self.story.version
+        if kind == OP2:
+            return 8 <= op <= 9 or 15 <= op <= 25
+        if kind == OP1:
+            return 1 <= op <= 4 or op == 8 or op == 14 or (op == 15 and v <= 4)
+        if kind == OP0:
+            return v == 4 if op in (5, 6) else (op == 9 and v >= 5)
+        if kind == VAR:
+            return op in (0, 7, 12, 22, 23) or (op in (4, 24) and v >= 5)
+        return op <= 4 or op in (9, 10, 19, 29)
+
+    def has_branch(self, kind, op):
+        v = self.story.version
+        if kind == OP2:
+            return 1 <= op <= 7 or op == 10
+        if kind == OP1:
+            return op <= 2
+        if kind == OP0:
+            return (op in (5, 6) and v <= 3) or op in (13, 15)
+        if kind == VAR:
+            return op in (23, 31)
+        return op in (6, 24, 27)
+
+    def operands(self, pc, types, values):
+        for shift in (6, 4, 2, 0):
+            t = (types >> shift) & 3
+            if t == 3:
+                break
+            if t == 0:
+                values.append((self.story.word(pc), True))
+                pc += 2
+            else:
+                values.append((self.story.byte(pc), t == 1))
+                pc += 1
+        return pc
+
+    def walk_routine(self, addr):
+        """Disassemble one routine. Returns: (texts, callees, string refs, end)."""
+        s = self.story
+        locals_count = s.byte(addr)
+        if locals_count > 15:
+            raise DecodeError("not a routine")
+        return self.walk_code(addr + 1 + (2 * locals_count if s.version <= 4 else 0))
+
+    def walk_code(self, start):
+        """Follow every path from start, raising DecodeError on invalid code."""
+        s = self.story
+        texts, callees, refs = [], [], []
+        pending = [start]
+        seen = set()
+        end = start
+        while pending:
+            pc = pending.pop()
+            while pc not in seen:
+                if pc >= s.size:
+                    raise DecodeError("code runs past end of story")
+                seen.add(pc)
+                opcode = s.byte(pc)
+                pc += 1
+                values = []
+                if opcode == 0xBE and s.version >= 5:
+                    kind, op = EXT, s.byte(pc)
+                    pc = self.operands(pc + 2, s.byte(pc + 1), values)
+                    if op > 29:
+                        raise DecodeError("bad extended opcode")
+                elif opcode < 0x80:
+                    kind, op = OP2, opcode & 0x1F
+                    values = [(s.byte(pc), not opcode & 0x40), (s.byte(pc + 1), not opcode & 0x20)]
+                    pc += 2
+                elif opcode < 0xC0:
+                    t = (opcode >> 4) & 3
+                    op = opcode & 0x0F
+                    if t == 3:
+                        kind = OP0
+                    else:
+                        kind = OP1
+                        pc = self.operands(pc, (t << 6) | 0x3F, values)
+                else:
+                    kind = VAR if opcode & 0x20 else OP2
+                    op = opcode & 0x1F
+                    if kind == VAR and op in (12, 26):
+                        types1, types2 = s.byte(pc), s.byte(pc + 1)
+                        pc = self.operands(pc + 2, types1, values)
+                        if len(values) == 4:
+                            pc = self.operands(pc, types2, values)
+                    else:
+                        pc = self.operands(pc + 1, s.byte(pc), values)
+                if kind == OP2 and op == 0 or (kind == OP0 and op == 14) or \
+                        (kind == OP0 and op in (5, 6) and s.version >= 5):
+                    raise DecodeError("illegal opcode")
+
+                if self.has_store(kind, op):
+                    pc += 1
+                if self.has_branch(kind, op):
+                    b = s.byte(pc)
+                    pc += 1
+                    offset = b & 0x3F
+                    if not b & 0x40:
+                        offset = (offset << 8) | s.byte(pc)
+                        pc += 1
+                        if offset & 0x2000:
+                            offset -= 0x4000
+                    if offset > 1:
+                        pending.append(pc + offset - 2)
+
+                # Text and calls
+                if kind == OP0 and op in (2, 3):
+                    text, pc = s.decode(pc)
+                    texts.append(text)
+                const = [v for v, c in values if c]
+                first_const = values[0][1] if values else False
+                if first_const and (
+                        (kind == VAR and op in (0, 12, 25, 26)) or
+                        (kind == OP2 and op in (25, 26)) or
+                        (kind == OP1 and (op == 8 or (op == 15 and s.version >= 5)))):
+                    if values[0][0]:
+                        callees.append(s.unpack_routine(values[0][0]))
+                if kind == OP1 and op == 13 and first_const:
+                    refs.append(s.unpack_string(values[0][0]))
+                if kind == OP1 and op == 7 and first_const:
+                    texts.append(s.decode(values[0][0])[0])
+                if kind == VAR and op == 5 and first_const:
+                    texts.append(s.zscii(values[0][0]) or "")
+                if kind == EXT and op == 11 and first_const:
+                    texts.append(chr(values[0][0]))
+                if kind == VAR and op == 6:
+                    texts.append("-0123456789")
+                del const
+
+                end = max(end, pc)
+                # Unconditional control transfer
+                if (kind == OP0 and op in (0, 1, 3, 7, 8, 10)) or (kind == OP1 and op == 11):
+                    break
+                if kind == OP1 and op == 12:
+                    offset = values[0][0]
+                    if offset & 0x8000:
+                        offset -= 0x10000
+                    pending.append(pc + offset - 2)
+                    break
+        return texts, callees, refs, end
+
+    def walk(self, queue):
+        while queue:
+            item = queue.pop()
+            if item in self.routines_done:
+                continue
+            self.routines_done.add(item)
+            try:
+                if item == "entry":
+                    # V1-5/7/8 start at an instruction, V6 at a packed routine
+                    if self.story.version == 6:
+                        result = self.walk_routine(self.story.unpack_routine(self.story.word(0x06)))
+                    else:
+                        result = self.walk_code(self.story.word(0x06))
+                else:
+                    result = self.walk_routine(item)
+            except DecodeError:
+                continue        # Property value that only looked like a routine
+            texts, callees, refs, end = result
+            self.texts.extend(texts)
+            self.string_refs.update(refs)
+            self.code_end = max(self.code_end, end)
+            queue.extend(c for c in callees if c not in self.routines_done)
+
+    def code(self, property_values):
+        """Walk the entry point and its constant calls, then routine-valued
+        properties (action routines) that lie inside or directly after the
+        code found so far; property values above it are strings."""
+        s = self.story
+        self.walk(["entry"])
+        candidates = {s.unpack_routine(v) for v in property_values}
+        candidates = {a for a in candidates if s.high_base <= a < s.size}
+        while True:
+            # A routine may also start right after the code found so far
+            limit = (self.code_end + s.packing - 1) // s.packing * s.packing
+            inside = [a for a in candidates if a <= limit and a not in self.routines_done]
+            if not inside:
+                break
+            self.walk(inside)
+
+    def chains_to(self, addr, candidates, steps=4):
+        """Returns: True if decoding strings from addr reaches another
+        candidate string start within a few strings."""
+        s = self.story
+        for _ in range(steps):
+            try:
+                addr = s.decode(addr)[1]
+            except DecodeError:
+                return False
+            addr = (addr + s.packing - 1) // s.packing * s.packing
+            if addr in candidates:
+                return True
+        return False
+
+    def string_area(self, property_values):
+        """Decode the strings stored after the last routine, starting at the
+        lowest string address that code or properties refer to and that
+        is followed by more of them."""
+        s = self.story
+        candidates = set(self.string_refs)
+        for value in property_values:
+            candidates.add(s.unpack_string(value))
+        above = sorted(a for a in candidates if self.code_end <= a < s.size)
+        start = (self.code_end + s.packing - 1) // s.packing * s.packing
+        for a in above:
+            # Undetected code can sit in front of the first real string, so
+            # trust a candidate once the scan from it lands on another one
+            if self.chains_to(a, candidates):
+                start = a
+                break
+        addr = start
+        while addr + 1 < s.size:
+            try:
+                text, addr = s.decode(addr)
+            except DecodeError:
+                break
+            self.add(text)
+            addr = (addr + s.packing - 1) // s.packing * s.packing
+
+    def run(self):
+        self.abbreviations()
+        property_values = self.objects()
+        self.dictionary()
+        self.code(property_values)
+        for addr in self.string_refs:
+            if addr < self.story.size:
+                self.add(self.story.decode(addr)[0])
+        self.string_area(property_values)
+
+
+# --- Extra text sources ---------------------------------------------------
+
+C_ESCAPES = {"n": "\n", "t": "\t", "r": "", "0": "", "\\": "\\", "'": "'", '"': '"'}
+
+
+def unescape(text):
+    return re.sub(r"\\(.)", lambda m: C_ESCAPES.get(m.group(1), m.group(1)), text)
+
+
+def c_source_text(path):
+    """Character and string literals of a C file (interpreter messages)."""
+    with open(path, encoding="utf-8") as handle:
+        source = handle.read()
+    source = re.sub(r"/\*.*?\*/|//[^\n]*", "", source, flags=re.S)
+    source = re.sub(r"^\s*#\s*include[^\n]*", "", source, flags=re.M)
+    chars = re.findall(r"'((?:\\.|[^'\\]))'", source)
+    strings = re.findall(r'"((?:\\.|[^"\\])*)"', source)
+    return unescape("".join(chars)) + unescape("".join(strings))
+
+
+def qml_source_text(path):
+    """Literal text shown or typed in a QML file."""
+    with open(path, encoding="utf-8") as handle:
+        source = handle.read()
+    literals = re.findall(r'(?:\btext:\s*|keyPressed\()"((?:\\.|[^"\\])*)"', source)
+    return unescape("".join(literals))
+
+
+# --- Font inspection --------------------------------------------------------
+
+def find_sfnts(blob):
+    """Returns: offsets of TrueType fonts inside blob (a .ttf or a fontmap)."""
+    found = []
+    for m in re.finditer(b"\x00\x01\x00\x00", blob):
+        base = m.start()
+        if base + 12 > len(blob):
+            continue
+        num_tables = struct.unpack_from(">H", blob, base + 4)[0]
+        if not 4 <= num_tables <= 64 or base + 12 + 16 * num_tables > len(blob):
+            continue
+        tags = [blob[base + 12 + 16 * i:base + 16 + 16 * i] for i in range(num_tables)]
+        if b"cmap" in tags and all(re.match(b"^[ -~]{4}$", t) for t in tags):
+            found.append(base)
+    return found
+
+
+def sfnt_tables(blob, base):
+    num_tables = struct.unpack_from(">H", blob, base + 4)[0]
+    tables = {}
+    for i in range(num_tables):
+        tag, _checksum, offset, length = struct.unpack_from(">4sIII", blob, base + 12 + 16 * i)
+        tables[tag.decode("ascii")] = (base + offset, length)
+    return tables
+
+
+def sfnt_info(blob, base):
+    """Returns: (name, covered code points, units per em, advance max, line height)."""
+    tables = sfnt_tables(blob, base)
+    cmap, _ = tables["cmap"]
+    covered = set()
+    count = struct.unpack_from(">H", blob, cmap + 2)[0]
+    for i in range(count):
+        platform, encoding, offset = struct.unpack_from(">HHI", blob, cmap + 4 + 8 * i)
+        sub = cmap + offset
+        fmt = struct.unpack_from(">H", blob, sub)[0]
+        if platform == 3 and encoding in (1, 10) and fmt == 4:
+            segs = struct.unpack_from(">H", blob, sub + 6)[0] // 2
+            ends = struct.unpack_from(">%dH" % segs, blob, sub + 14)
+            starts = struct.unpack_from(">%dH" % segs, blob, sub + 16 + 2 * segs)
+            for start, end in zip(starts, ends):
+                if start != 0xFFFF:
+                    covered.update(range(start, end + 1))
+        elif platform == 3 and encoding == 10 and fmt == 12:
+            groups = struct.unpack_from(">I", blob, sub + 12)[0]
+            for g in range(groups):
+                start, end, _glyph = struct.unpack_from(">III", blob, sub + 16 + 12 * g)
+                covered.update(range(start, end + 1))
+    head, _ = tables["head"]
+    units_per_em = struct.unpack_from(">H", blob, head + 18)[0]
+    hhea, _ = tables["hhea"]
+    ascent, descent, _gap, advance_max = struct.unpack_from(">hhhH", blob, hhea + 4)
+    name = "font@0x%X" % base
+    return name, covered, units_per_em, advance_max, ascent - descent
+
+
+def format_ranges(points):
+    ranges = []
+    for p in sorted(points):
+        if ranges and p == ranges[-1][1] + 1:
+            ranges[-1][1] = p
+        else:
+            ranges.append([p, p])
+    return ",".join("U+%04X" % a if a == b else "U+%04X-%04X" % (a, b) for a, b in ranges)
+
+
+def format_chars(points):
+    return "".join(chr(p) for p in sorted(points))
+
+
+def qml_escape(text):
+    return text.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def write_qml(path, story_name, points, sizes):
+    text = qml_escape(format_chars(points))
+    lines = [
+        "/*",
+        " * StoryGlyphs.qml",
+        " *",
+        " * Generated by tools/story_glyphs.py from %s - do not edit." % story_name,
+        " * Hidden Text items listing every character the story, interpreter and",
+        " * UI can show (%d code points), so the font engine has exactly those" % len(points),
+        " * glyphs at each pixel size used for game text.",
+        " */",
+        "import QtQuick",
+        "",
+        "Item {",
+        "    visible: false",
+        "",
+    ]
+    for size in sizes:
+        lines.append("    Text {")
+        lines.append("        font.pixelSize: %d" % size)
+        lines.append('        text: "%s"' % text)
+        lines.append("    }")
+    lines.append("}")
+    with open(path, "w", encoding="utf-8") as handle:
+        handle.write("\n".join(lines) + "\n")
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Exact glyph set of a story file")
+    parser.add_argument("stories", nargs="+", metavar="STORY",
+                        help="story file(s); several give the union, e.g. for a catalog build")
+    parser.add_argument("--source", action="append", default=[],
+                        help="C file whose character/string literals the interpreter can print")
+    parser.add_argument("--qml-source", action="append", default=[],
+                        help="QML file whose text:/keyPressed() literals are shown or typed")
+    parser.add_argument("--text", action="append", default=[], help="extra characters")
+    parser.add_argument("--qml", help="write a QML priming component here")
+    parser.add_argument("--sizes", default="16",
+                        help="comma-separated pixel sizes for --qml and the cache estimate")
+    parser.add_argument("--fontmap", action="append", default=[],
+                        help="fontmap (.fmp) or TrueType file to check coverage against")
+    parser.add_argument("--subset", nargs=2, metavar=("FONT", "OUTPUT"),
+                        help="subset a TrueType font to the set (requires fontTools)")
+    parser.add_argument("--list", action="store_true", help="print the characters")
+    args = parser.parse_args(argv)
+
+    story_points = set()
+    routines = strings = 0
+    for path in args.stories:
+        with open(path, "rb") as handle:
+            collector = Collector(Story(handle.read()))
+        collector.run()
+        story_points |= {ord(c) for t in collector.texts for c in t if c >= " "}
+        routines += len(collector.routines_done)
+        strings += len(collector.texts)
+    names = ", ".join(p.replace("\\", "/").split("/")[-1] for p in args.stories)
+    extra = "".join(args.text)
+    for path in args.source:
+        extra += c_source_text(path)
+    for path in args.qml_source:
+        extra += qml_source_text(path)
+    points = story_points | {ord(c) for c in extra if c >= " "}
+
+    print("story_glyphs: %s: %d code points from the story (%d routines, %d strings), %d in total"
+          % (names, len(story_points), routines, strings, len(points)))
+    print("story_glyphs: %s" % format_ranges(points))
+    if args.list:
+        print(format_chars(points))
+
+    sizes = [int(s) for s in args.sizes.split(",") if s]
+    for path in args.fontmap:
+        with open(path, "rb") as handle:
+            blob = handle.read()
+        for base in find_sfnts(blob):
+            name, covered, upem, advance, line = sfnt_info(blob, base)
+            missing = points - covered
+            unused = {p for p in covered - points if p >= 0x20}
+            print("story_glyphs: %s %s: %d code points, %d missing%s, %d unused"
+                  % (path, name, len(covered), len(missing),
+                     " (%s)" % format_ranges(missing) if missing else "", len(unused)))
+            for size in sizes:
+                w = -(-advance * size // upem)
+                h = -(-line * size // upem)
+                print("story_glyphs:   %d px: ~%d B per glyph, ~%d B for the set (8-bit alpha)"
+                      % (size, w * h, w * h * len(points)))
+
+    if args.qml:
+        write_qml(args.qml, names, points, sizes)
+        print("story_glyphs: wrote %s" % args.qml)
+
+    if args.subset:
+        try:
+            from fontTools import subset
+        except ImportError:
+            sys.stderr.write("story_glyphs: --subset needs fontTools; run instead:\n"
+                             "  pyftsubset %s --unicodes=%s --output-file=%s\n"
+                             % (args.subset[0], format_ranges(points).replace("U+", ""),
+                                args.subset[1]))
+            return 1
+        options = subset.Options()
+        font = subset.load_font(args.subset[0], options)
+        subsetter = subset.Subsetter(options)
+        subsetter.populate(unicodes=sorted(points))
+        subsetter.subset(font)
+        subset.save_font(font, args.subset[1], options)
+        print("story_glyphs: wrote %s" % args.subset[1])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
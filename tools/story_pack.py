@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+"""
+story_pack.py
+
+Block-compressed story image for the embedded build (FIZMO_STORY_PACK=ON).
+
+The story is split into fixed-size blocks (1-4 KB) that are compressed
+independently with the LZ4 block format, so any block can be decoded on
+its own by src/story_blocks.c. Blocks that do not shrink are stored raw.
+
+Image layout (little-endian):
+
+  "ZSTB"              magic
+  u8   version        1
+  u8   block_shift    log2(block size), 10..12
+  u16  reserved       0
+  u32  story_size     uncompressed bytes
+  u32  block_count
+  u32  offsets[block_count + 1]   from image start; block i is
+                                  offsets[i] .. offsets[i + 1]
+  ...  block data
+
+Only the Python standard library is used:
+
+  tools/story_pack.py pack zork1.z3 zork1.zstb --block-size 2048
+  tools/story_pack.py info zork1.zstb
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"ZSTB"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHII")
+
+MIN_MATCH = 4
+LAST_LITERALS = 5       # LZ4: the last 5 bytes are always literals
+MFLIMIT = 12            # LZ4: no match may start within 12 bytes of the end
+MAX_OFFSET = 0xFFFF
+HASH_BITS = 12
+CHAIN_DEPTH = 32
+
+
+def _write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def _emit(out, literals, match_length, offset):
+    lit_len = len(literals)
+    token_lit = min(lit_len, 15)
+    token_match = 0 if match_length is None else min(match_length - MIN_MATCH, 15)
+    out.append((token_lit << 4) | token_match)
+    if lit_len >= 15:
+        _write_length(out, lit_len - 15)
+    out.extend(literals)
+    if match_length is None:
+        return
+    out.extend(struct.pack("<H", offset))
+    if match_length - MIN_MATCH >= 15:
+        _write_length(out, match_length - MIN_MATCH - 15)
+
+
+def lz4_compress(data):
+    """Returns: LZ4 block (no frame) for data, using hash chains."""
+    n = len(data)
+    out = bytearray()
+    if n < MFLIMIT + 1:
+        _emit(out, data, None, 0)
+        return bytes(out)
+
+    head = {}
+    chain = [-1] * n
+    anchor = 0
+    pos = 0
+    match_limit = n - LAST_LITERALS
+    while pos < n - MFLIMIT:
+        key = data[pos:pos + MIN_MATCH]
+        best_len = 0
+        best_pos = -1
+        candidate = head.get(key, -1)
+        depth = 0
+        while candidate >= 0 and pos - candidate <= MAX_OFFSET and depth < CHAIN_DEPTH:
+            length = MIN_MATCH
+            while pos + length < match_limit and data[candidate + length] == data[pos + length]:
+                length += 1
+            if length > best_len:
+                best_len = length
+                best_pos = candidate
+            candidate = chain[candidate]
+            depth += 1
+        chain[pos] = head.get(key, -1)
+        head[key] = pos
+
+        if best_len < MIN_MATCH:
+            pos += 1
+            continue
+
+        _emit(out, data[anchor:pos], best_len, pos - best_pos)
+        # Index the positions covered by the match so later data can refer to them
+        for p in range(pos + 1, min(pos + best_len, n - MFLIMIT)):
+            k = data[p:p + MIN_MATCH]
+            chain[p] = head.get(k, -1)
+            head[k] = p
+        pos += best_len
+        anchor = pos
+
+    _emit(out, data[anchor:], None, 0)
+    return bytes(out)
+
+
+def lz4_decompress(block, size):
+    """Reference decoder, used to verify every packed block."""
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        token = block[i]
+        i += 1
+        lit_len = token >> 4
+        if lit_len == 15:
+            while True:
+                b = block[i]
+                i += 1
+                lit_len += b
+                if b != 255:
+                    break
+        out.extend(block[i:i + lit_len])
+        i += lit_len
+        if i >= len(block):
+            break
+        offset = block[i] | (block[i + 1] << 8)
+        i += 2
+        match_len = (token & 15) + MIN_MATCH
+        if (token & 15) == 15:
+            while True:
+                b = block[i]
+                i += 1
+                match_len += b
+                if b != 255:
+                    break
+        start = len(out) - offset
+        if offset == 0 or start < 0:
+            raise ValueError("bad match offset")
+        for k in range(match_len):
+            out.append(out[start + k])
+    if len(out) != size:
+        raise ValueError("decoded %d bytes, expected %d" % (len(out), size))
+    return bytes(out)
+
+
+def pack(story, block_shift):
+    block_size = 1 << block_shift
+    blocks = []
+    for start in range(0, len(story), block_size):
+        raw = story[start:start + block_size]
+        packed = lz4_compress(raw)
+        if len(packed) >= len(raw):
+            packed = raw            # Stored: decoder sees length == block length
+        elif lz4_decompress(packed, len(raw)) != raw:
+            raise ValueError("block at 0x%X does not round-trip" % start)
+        blocks.append(packed)
+
+    table_size = 4 * (len(blocks) + 1)
+    offset = HEADER.size + table_size
+    offsets = []
+    for packed in blocks:
+        offsets.append(offset)
+        offset += len(packed)
+    offsets.append(offset)
+
+    image = bytearray(HEADER.pack(MAGIC, VERSION, block_shift, 0, len(story), len(blocks)))
+    image.extend(struct.pack("<%dI" % len(offsets), *offsets))
+    for packed in blocks:
+        image.extend(packed)
+    return bytes(image)
+
+
+def unpack(image):
+    magic, version, block_shift, _reserved, story_size, block_count = HEADER.unpack_from(image, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a ZSTB v%d image" % VERSION)
+    offsets = struct.unpack_from("<%dI" % (block_count + 1), image, HEADER.size)
+    block_size = 1 << block_shift
+    story = bytearray()
+    stored = 0
+    for i in range(block_count):
+        packed = image[offsets[i]:offsets[i + 1]]
+        size = min(block_size, story_size - i * block_size)
+        if len(packed) == size:
+            story.extend(packed)
+            stored += 1
+        else:
+            story.extend(lz4_decompress(packed, size))
+    return bytes(story), block_size, block_count, stored
+
+
+def cmd_pack(args):
+    if args.block_size not in (1024, 2048, 4096):
+        sys.stderr.write("story_pack: block size must be 1024, 2048 or 4096\n")
+        return 1
+    with open(args.story, "rb") as handle:
+        story = handle.read()
+    block_shift = args.block_size.bit_length() - 1
+    image = pack(story, block_shift)
+    if unpack(image)[0] != story:
+        sys.stderr.write("story_pack: image does not round-trip\n")
+        return 1
+    with open(args.output, "wb") as handle:
+        handle.write(image)
+    print("story_pack: %u -> %u bytes (%.1f%%, saves %u bytes of flash), %u x %u B blocks"
+          % (len(story), len(image), 100.0 * len(image) / len(story),
+             len(story) - len(image), (len(story) + args.block_size - 1) // args.block_size,
+             args.block_size))
+    return 0
+
+
+def cmd_info(args):
+    with open(args.image, "rb") as handle:
+        image = handle.read()
+    story, block_size, block_count, stored = unpack(image)
+    print("story_pack: %s: %u bytes for a %u byte story (%.1f%%), %u x %u B blocks, %u stored raw"
+          % (args.image, len(image), len(story), 100.0 * len(image) / len(story),
+             block_count, block_size, stored))
+    return 0
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Block-compressed story image")
+    sub = parser.add_subparsers(dest="command")
+    sub.required = True
+
+    pk = sub.add_parser("pack", help="compress a story file")
+    pk.add_argument("story")
+    pk.add_argument("output")
+    pk.add_argument("--block-size", type=int, default=2048,
+                    help="uncompressed block size: 1024, 2048 or 4096 (default 2048)")
+    pk.set_defaults(func=cmd_pack)
+
+    inf = sub.add_parser("info", help="verify and describe a packed image")
+    inf.add_argument("image")
+    inf.set_defaults(func=cmd_info)
+
+    args = parser.parse_args(argv)
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
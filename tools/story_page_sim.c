@@ -0,0 +1,595 @@
+/*
+ * story_page_sim.c
+ *
+ * Host simulation of demand-paged story memory (src/story_page_cache.c).
+ *
+ * Loads a story file, keeps dynamic memory resident as the device would,
+ * and serves every static/high memory byte through the LRU page cache.
+ * The access stream comes from a random walk over the story's real code:
+ * instructions are decoded from the entry point (V1-5, V8), calls and
+ * jumps with constant targets are followed, branches are taken at random,
+ * inline and packed strings are read with their abbreviations, and each
+ * input opcode performs dictionary lookups for a few words. Calls through
+ * variables go to a random known routine (seeded from routine-valued
+ * object properties, then grown by constant calls), and each routine
+ * returns after FRAME_BUDGET instructions since random branches do not
+ * find loop exits reliably.
+ *
+ * Throughput is modelled, not measured: each instruction costs
+ * --instr-ns and each page miss costs --latency-us plus the page
+ * transfer at --read-kbps.
+ *
+ * With --packed (a tools/story_pack.py image of the same story) pages are
+ * the compressed blocks instead: misses are filled by really decoding the
+ * block, and a miss costs the measured host decode time times --cpu-scale
+ * (host to Cortex-M7 slowdown).
+ *
+ *   cc -O2 -Isrc tools/story_page_sim.c src/story_page_cache.c src/story_blocks.c \
+ *       -o story_page_sim
+ *   ./story_page_sim zork1.z3 --pages 64 --page-size 512 --latency-us 300
+ *   ./story_page_sim zork1.z3 --packed zork1.zstb --pages 4
+ */
+
+#include "story_page_cache.h"
+#include "story_blocks.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_DEPTH   32
+#define FRAME_BUDGET 256    /* Instructions before a routine is forced to return */
+
+typedef struct {
+    const uint8_t *image;
+    uint32_t size;
+    uint32_t reads;
+} story_file_t;
+
+static story_page_cache_t s_cache;
+static const uint8_t *s_image;
+static uint32_t s_static_base;
+static uint32_t s_story_size;
+static int s_version;
+static uint32_t s_rng = 12345;
+
+static uint32_t next_random(void)
+{
+    s_rng = s_rng * 1103515245u + 12345u;
+    return s_rng >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double s_decode_ns;
+static uint32_t s_decodes;
+
+static int packed_read(void *ctx, uint32_t offset, uint8_t *dest, uint32_t size)
+{
+    double start = now_ns();
+    int result = story_blocks_read_page(ctx, offset, dest, size);
+    s_decode_ns += now_ns() - start;
+    s_decodes++;
+    return result;
+}
+
+static int file_read(void *ctx, uint32_t offset, uint8_t *dest, uint32_t size)
+{
+    story_file_t *file = ctx;
+    if (offset + size > file->size) {
+        return -1;
+    }
+    memcpy(dest, file->image + offset, size);
+    file->reads++;
+    return 0;
+}
+
+/* Dynamic memory is resident; everything above goes through the cache */
+static uint8_t mem_byte(uint32_t addr)
+{
+    if (addr < s_static_base) {
+        return s_image[addr];
+    }
+    return story_page_cache_byte(&s_cache, addr);
+}
+
+static uint16_t mem_word(uint32_t addr)
+{
+    return (uint16_t)((mem_byte(addr) << 8) | mem_byte(addr + 1));
+}
+
+static uint32_t unpack(uint16_t packed)
+{
+    if (s_version <= 3) return 2u * packed;
+    if (s_version <= 5) return 4u * packed;
+    return 8u * packed;
+}
+
+/* Read a Z-string, expanding abbreviations one level deep. Returns: bytes consumed */
+static uint32_t read_string(uint32_t addr, int allow_abbrev)
+{
+    uint32_t start = addr;
+    int pending_abbrev = 0, escape = 0;
+    uint16_t abbrev_table = (uint16_t)((s_image[0x18] << 8) | s_image[0x19]);
+
+    for (;;) {
+        if (addr + 1 >= s_story_size) {
+            break;
+        }
+        uint16_t word = mem_word(addr);
+        addr += 2;
+        for (int shift = 10; shift >= 0; shift -= 5) {
+            int zchar = (word >> shift) & 0x1F;
+            if (escape > 0) {
+                escape--;
+            } else if (pending_abbrev) {
+                uint32_t entry = abbrev_table + 2u * (32u * (pending_abbrev - 1) + zchar);
+                if (allow_abbrev) {
+                    read_string(2u * mem_word(entry), 0);
+                }
+                pending_abbrev = 0;
+            } else if (zchar >= 1 && zchar <= 3 && s_version >= 2) {
+                pending_abbrev = zchar;
+            } else if (zchar == 6) {
+                escape = 2;     /* Approximation: treat every A2 6 as a ZSCII escape */
+            }
+        }
+        if (word & 0x8000) {
+            break;
+        }
+    }
+    return addr - start;
+}
+
+/* Binary search the dictionary for a few random words, as tokenising input does */
+static void dictionary_lookup(int words)
+{
+    uint32_t dict = (uint32_t)((s_image[0x08] << 8) | s_image[0x09]);
+    uint32_t separators = mem_byte(dict);
+    uint32_t entry_length = mem_byte(dict + 1 + separators);
+    int16_t entries = (int16_t)mem_word(dict + 2 + separators);
+    uint32_t first = dict + 4 + separators;
+    if (entries <= 0 || entry_length == 0) {
+        return;
+    }
+
+    for (int w = 0; w < words; w++) {
+        int32_t target = (int32_t)(next_random() % (uint32_t)entries);
+        int32_t low = 0, high = entries - 1;
+        while (low <= high) {
+            int32_t mid = (low + high) / 2;
+            uint32_t entry = first + (uint32_t)mid * entry_length;
+            mem_word(entry);
+            mem_word(entry + 2);
+            if (mid == target) break;
+            if (mid < target) low = mid + 1; else high = mid - 1;
+        }
+    }
+}
+
+typedef struct {
+    uint32_t return_pc;
+    uint32_t executed;
+} frame_t;
+
+static frame_t s_stack[MAX_DEPTH];
+static int s_depth;
+static uint32_t s_initial_pc;
+
+/* Routines reached through constant calls; variable-target calls (action
+ * routines from properties, etc.) pick one of these at random */
+#define MAX_ROUTINES 4096
+static uint32_t s_routines[MAX_ROUTINES];
+static uint32_t s_routine_count;
+static uint8_t s_routine_seen[512 * 1024 / 8];
+
+static void add_routine(uint32_t routine)
+{
+    if (routine >= s_story_size || s_routine_count >= MAX_ROUTINES ||
+        (s_routine_seen[routine >> 3] & (1u << (routine & 7)))) {
+        return;
+    }
+    s_routine_seen[routine >> 3] |= (uint8_t)(1u << (routine & 7));
+    s_routines[s_routine_count++] = routine;
+}
+
+static uint32_t do_return(void)
+{
+    if (s_depth == 0) {
+        return s_initial_pc;    /* Main routine returned: start over */
+    }
+    return s_stack[--s_depth].return_pc;
+}
+
+static uint32_t do_call(uint32_t routine, uint32_t return_pc)
+{
+    if (routine == 0 || routine >= s_story_size || s_depth == MAX_DEPTH) {
+        return return_pc;       /* call 0 returns false; too deep: treat as returned */
+    }
+    s_stack[s_depth].return_pc = return_pc;
+    s_stack[s_depth++].executed = 0;
+    uint8_t locals = mem_byte(routine);
+    if (locals <= 15) {
+        add_routine(routine);
+    }
+    if (locals > 15) {
+        return do_return();     /* Not a routine: a variable target we cannot follow */
+    }
+    return routine + 1 + (s_version <= 4 ? 2u * locals : 0);
+}
+
+/* Seed the routine list with word properties that point at routines in
+ * high memory (ACTION and similar), read straight from the image */
+static void scan_property_routines(void)
+{
+    uint32_t high_base = (uint32_t)((s_image[0x04] << 8) | s_image[0x05]);
+    uint32_t objects = (uint32_t)((s_image[0x0A] << 8) | s_image[0x0B]);
+    uint32_t entry_size = s_version <= 3 ? 9 : 14;
+    uint32_t first = objects + (s_version <= 3 ? 31 : 63) * 2;
+    uint32_t lowest_props = s_static_base;
+
+    for (uint32_t obj = first; obj + entry_size <= lowest_props; obj += entry_size) {
+        uint32_t ptr_offset = obj + entry_size - 2;
+        uint32_t props = (uint32_t)((s_image[ptr_offset] << 8) | s_image[ptr_offset + 1]);
+        if (props < lowest_props) {
+            lowest_props = props;   /* Property tables follow the last object */
+        }
+        if (props + 1 >= s_static_base) {
+            continue;
+        }
+        uint32_t p = props + 1 + 2u * s_image[props];
+        while (p < s_static_base && s_image[p] != 0) {
+            uint32_t size, header = 1;
+            uint8_t b = s_image[p];
+            if (s_version <= 3) {
+                size = (b >> 5) + 1u;
+            } else if (b & 0x80) {
+                header = 2;
+                size = s_image[p + 1] & 0x3F;
+                if (size == 0) size = 64;
+            } else {
+                size = (b & 0x40) ? 2 : 1;
+            }
+            if (size == 2) {
+                uint32_t routine = unpack((uint16_t)((s_image[p + header] << 8) | s_image[p + header + 1]));
+                if (routine >= high_base && routine < s_story_size && s_image[routine] <= 15) {
+                    add_routine(routine);
+                }
+            }
+            p += header + size;
+        }
+    }
+}
+
+static uint32_t call_target(uint16_t value, int is_const)
+{
+    if (is_const) {
+        return unpack(value);
+    }
+    return s_routine_count ? s_routines[next_random() % s_routine_count] : 0;
+}
+
+static int has_store(int kind, int op)
+{
+    switch (kind) {
+    case 2:
+        return (op >= 8 && op <= 9) || (op >= 15 && op <= 25);
+    case 1:
+        return (op >= 1 && op <= 4) || op == 8 || (op == 14) || (op == 15 && s_version <= 4);
+    case 0:
+        return (op == 5 || op == 6) ? s_version == 4 : (op == 9 && s_version >= 5);
+    case 3:
+        return op == 0 || op == 7 || op == 12 || op == 22 || op == 23 ||
+               (op == 4 && s_version >= 5) || (op == 24 && s_version >= 5);
+    default:    /* Extended */
+        return op <= 4 || op == 9 || op == 10;
+    }
+}
+
+static int has_branch(int kind, int op)
+{
+    switch (kind) {
+    case 2:
+        return (op >= 1 && op <= 7) || op == 10;
+    case 1:
+        return op <= 2;
+    case 0:
+        return ((op == 5 || op == 6) && s_version <= 3) || op == 13 || op == 15;
+    case 3:
+        return op == 23 || op == 31;
+    default:
+        return 0;
+    }
+}
+
+/* Decode one operand list. Returns: operand count; values are 0 for variables */
+static int read_operands(uint32_t *pc, uint8_t types, uint16_t *values, int *is_const, int base)
+{
+    int count = base;
+    for (int shift = 6; shift >= 0; shift -= 2) {
+        int type = (types >> shift) & 3;
+        if (type == 3) break;
+        if (type == 0) {
+            values[count] = mem_word(*pc);
+            *pc += 2;
+            is_const[count] = 1;
+        } else {
+            values[count] = type == 1 ? mem_byte(*pc) : 0;
+            *pc += 1;
+            is_const[count] = type == 1;
+        }
+        count++;
+    }
+    return count;
+}
+
+/* Execute one instruction's memory traffic. Returns: next PC */
+static uint32_t step(uint32_t pc)
+{
+    uint16_t values[8] = {0};
+    int is_const[8] = {0};
+    int kind, op, count = 0;
+    uint8_t opcode = mem_byte(pc++);
+
+    if (opcode == 0xBE && s_version >= 5) {
+        kind = 4;
+        op = mem_byte(pc++);
+        uint8_t types = mem_byte(pc++);
+        count = read_operands(&pc, types, values, is_const, 0);
+    } else if (opcode < 0x80) {
+        kind = 2;
+        op = opcode & 0x1F;
+        values[0] = mem_byte(pc++);
+        is_const[0] = !(opcode & 0x40);
+        values[1] = mem_byte(pc++);
+        is_const[1] = !(opcode & 0x20);
+        count = 2;
+    } else if (opcode < 0xC0) {
+        int type = (opcode >> 4) & 3;
+        op = opcode & 0x0F;
+        if (type == 3) {
+            kind = 0;
+        } else {
+            kind = 1;
+            count = read_operands(&pc, (uint8_t)((type << 6) | 0x3F), values, is_const, 0);
+        }
+    } else {
+        kind = (opcode & 0x20) ? 3 : 2;
+        op = opcode & 0x1F;
+        if (kind == 3 && (op == 12 || op == 26)) {
+            uint8_t types1 = mem_byte(pc++);
+            uint8_t types2 = mem_byte(pc++);
+            count = read_operands(&pc, types1, values, is_const, 0);
+            if (count == 4) count = read_operands(&pc, types2, values, is_const, 4);
+        } else {
+            uint8_t types = mem_byte(pc++);
+            count = read_operands(&pc, types, values, is_const, 0);
+        }
+    }
+    (void)count;
+
+    if (has_store(kind, op)) {
+        pc++;
+    }
+
+    int branch_taken = 0;
+    uint32_t branch_target = 0;
+    if (has_branch(kind, op)) {
+        uint8_t b = mem_byte(pc++);
+        int32_t offset = b & 0x3F;
+        if (!(b & 0x40)) {
+            offset = (offset << 8) | mem_byte(pc++);
+            if (offset & 0x2000) offset -= 0x4000;
+        }
+        if (next_random() & 1) {
+            branch_taken = 1;
+            branch_target = (offset == 0 || offset == 1) ? do_return() : (uint32_t)((int32_t)pc + offset - 2);
+        }
+    }
+
+    /* Control flow and string reads */
+    if (kind == 0) {
+        switch (op) {
+        case 0: case 1: case 8:
+            return do_return();
+        case 2:
+            return pc + read_string(pc, 1);
+        case 3:
+            read_string(pc, 1);
+            return do_return();
+        case 7: case 10:
+            s_depth = 0;
+            return s_initial_pc;
+        default:
+            break;
+        }
+    } else if (kind == 1) {
+        switch (op) {
+        case 7:
+            if (is_const[0]) read_string(values[0], 1);
+            break;
+        case 8:
+            return do_call(call_target(values[0], is_const[0]), pc);
+        case 11:
+            return do_return();
+        case 12:
+            return (uint32_t)((int32_t)pc + (int16_t)values[0] - 2);
+        case 13:
+            if (is_const[0]) read_string(unpack(values[0]), 1);
+            break;
+        case 15:
+            if (s_version >= 5) return do_call(call_target(values[0], is_const[0]), pc);
+            break;
+        default:
+            break;
+        }
+    } else if (kind == 2 && (op == 25 || op == 26)) {
+        return do_call(call_target(values[0], is_const[0]), pc);
+    } else if (kind == 2 && op == 28) {
+        return do_return();
+    } else if (kind == 3) {
+        switch (op) {
+        case 0: case 12: case 25: case 26:
+            return do_call(call_target(values[0], is_const[0]), pc);
+        case 4:
+            dictionary_lookup(3);
+            break;
+        default:
+            break;
+        }
+    }
+
+    return branch_taken ? branch_target : pc;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: story_page_sim story.z? [--pages N] [--page-size B] [--steps N]\n"
+        "                       [--latency-us U] [--read-kbps K] [--instr-ns T] [--seed S]\n"
+        "                       [--packed image.zstb] [--cpu-scale X]\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    uint32_t page_count = 64, page_size = 512;
+    long steps = 5000000L;
+    double latency_us = 300.0, read_kbps = 10000.0, instr_ns = 2000.0, cpu_scale = 8.0;
+    const char *packed_path = NULL;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--pages") == 0) page_count = (uint32_t)atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--page-size") == 0) page_size = (uint32_t)atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--steps") == 0) steps = atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--latency-us") == 0) latency_us = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--read-kbps") == 0) read_kbps = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--instr-ns") == 0) instr_ns = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) s_rng = (uint32_t)atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--packed") == 0) packed_path = argv[i + 1];
+        else if (strcmp(argv[i], "--cpu-scale") == 0) cpu_scale = atof(argv[i + 1]);
+        else { usage(); return 1; }
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "story_page_sim: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    static uint8_t image[512 * 1024];
+    story_file_t file = { image, (uint32_t)fread(image, 1, sizeof(image), fp), 0 };
+    fclose(fp);
+
+    s_image = image;
+    s_story_size = file.size;
+    s_version = image[0];
+    s_static_base = (uint32_t)((image[0x0E] << 8) | image[0x0F]);
+    s_initial_pc = (uint32_t)((image[0x06] << 8) | image[0x07]);
+    if (s_story_size < 64 || s_version < 1 || s_version == 6 || s_version == 7 || s_version > 8) {
+        fprintf(stderr, "story_page_sim: unsupported story (version %d)\n", s_version);
+        return 1;
+    }
+
+    static uint8_t packed_image[512 * 1024];
+    size_t packed_size = 0;
+    story_blocks_t blocks;
+    story_page_read_fn read_fn = file_read;
+    void *read_ctx = &file;
+    if (packed_path != NULL) {
+        fp = fopen(packed_path, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "story_page_sim: cannot open %s\n", packed_path);
+            return 1;
+        }
+        packed_size = fread(packed_image, 1, sizeof(packed_image), fp);
+        fclose(fp);
+        if (story_blocks_open(&blocks, packed_image, packed_size) != 0 ||
+            blocks.story_size != s_story_size) {
+            fprintf(stderr, "story_page_sim: %s is not a packed image of %s\n", packed_path, argv[1]);
+            return 1;
+        }
+
+        /* Every block must decode to the original story */
+        static uint8_t block[STORY_BLOCKS_MAX_SIZE];
+        for (uint32_t b = 0; b < blocks.block_count; b++) {
+            int size = story_blocks_decode(&blocks, b, block);
+            if (size < 0 || memcmp(block, image + b * blocks.block_size, (size_t)size) != 0) {
+                fprintf(stderr, "story_page_sim: block %u does not match the story\n", b);
+                return 1;
+            }
+        }
+        page_size = blocks.block_size;
+        read_fn = packed_read;
+        read_ctx = &blocks;
+    }
+
+    uint8_t *pages = malloc((size_t)page_count * page_size);
+    story_page_slot_t *slots = malloc(page_count * sizeof(*slots));
+    uint16_t *page_map = malloc(story_page_map_entries(s_story_size, page_size) * sizeof(uint16_t));
+    if (!pages || !slots || !page_map ||
+        story_page_cache_init(&s_cache, read_fn, read_ctx, s_story_size, page_size,
+                              pages, slots, (uint16_t)page_count, page_map) != 0) {
+        fprintf(stderr, "story_page_sim: bad cache geometry\n");
+        return 1;
+    }
+
+    scan_property_routines();
+    uint32_t seeded = s_routine_count;
+
+    uint32_t pc = s_initial_pc;
+    for (long i = 0; i < steps; i++) {
+        pc = step(pc);
+        /* Random branches cannot find loop exits; bound each routine */
+        if (s_depth > 0 && ++s_stack[s_depth - 1].executed > FRAME_BUDGET) {
+            pc = do_return();
+        }
+        if (pc >= s_story_size) {
+            s_depth = 0;
+            pc = s_initial_pc;
+        }
+    }
+
+    const story_page_stats_t *stats = &s_cache.stats;
+    double accesses = (double)stats->hits + stats->misses;
+    double miss_ns = latency_us * 1000.0 + (double)page_size / (read_kbps * 1024.0) * 1e9;
+    if (packed_path != NULL) {
+        miss_ns = s_decodes ? s_decode_ns / s_decodes * cpu_scale : 0.0;
+    }
+    double total_ns = (double)steps * instr_ns + (double)stats->misses * miss_ns;
+    uint32_t resident = s_static_base + page_count * page_size;
+
+    printf("story: %s, version %d, %u bytes, dynamic %u bytes\n",
+           argv[1], s_version, s_story_size, s_static_base);
+    printf("cache: %u x %u B pages (%u KB), resident %u KB vs %u KB fully loaded\n",
+           page_count, page_size, page_count * page_size / 1024,
+           resident / 1024, s_story_size / 1024);
+    printf("accesses: %.0f, hits %.3f%%, misses %u, page reads %u, errors %u\n",
+           accesses, accesses > 0 ? 100.0 * stats->hits / accesses : 0.0,
+           stats->misses, packed_path ? s_decodes : file.reads, stats->read_errors);
+    if (packed_path != NULL) {
+        printf("packed: %zu bytes in flash vs %u (saves %u), decode %.0f ns/block on host, "
+               "x%.1f on target\n", packed_size, s_story_size,
+               s_story_size - (uint32_t)packed_size,
+               s_decodes ? s_decode_ns / s_decodes : 0.0, cpu_scale);
+    }
+    printf("routines: %u seeded from properties, %u reached\n", seeded, s_routine_count);
+    printf("instructions: %ld, %.1f accesses/instruction, %.4f misses/instruction\n",
+           steps, accesses / (double)steps, (double)stats->misses / (double)steps);
+    printf("modelled: %.0f instr/s paged vs %.0f instr/s in RAM (%.1f%%)\n",
+           (double)steps * 1e9 / total_ns, 1e9 / instr_ns,
+           100.0 * ((double)steps * instr_ns) / total_ns);
+
+    free(page_map);
+    free(slots);
+    free(pages);
+    return 0;
+}
@@ -0,0 +1,322 @@
+#!/usr/bin/env python3
+"""
+tcm_placement.py
+
+Profile-driven ITCM placement for the libfizmo hot path.
+
+  select  Read a gprof flat profile from a desktop run (FIZMO_GPROF=ON) and,
+          optionally, a ZorkUI.map from a previous target build for function
+          sizes (without it each function is assumed --estimated-size bytes).
+          Emit a GNU ld fragment that places the hottest functions in ITCM
+          (copied from flash at startup by zork_itcm_init()).
+
+  report  Read the ZorkUI.map of a build that used the fragment and list
+          where each selected function ended up.
+
+Only the Python standard library is used, so both steps run on the host:
+
+  gprof -b -p ZorkUI gmon.out > profile.txt
+  tools/tcm_placement.py select --profile profile.txt --map ZorkUI.map \\
+      --budget 65536 --output zork_itcm.ld
+  tools/tcm_placement.py report --map ZorkUI.map --fragment zork_itcm.ld
+"""
+
+import argparse
+import re
+import sys
+
+SECTION_NAME = ".zork_itcm"
+REGION_NAME = "ZORK_ITCM"
+
+# Assumed size of a function when no map file is given (first build). Large
+# on purpose: libfizmo's hot functions are mostly opcode handlers well under
+# 1 KB, so the budget is under-filled rather than overflowed.
+DEFAULT_ESTIMATED_SIZE = 1024
+
+# GCC clones keep the original name as a prefix (foo.lto_priv.0, foo.isra.1)
+CLONE_SUFFIX = re.compile(r"\.(lto_priv|isra|part|constprop|cold)\.\d+$")
+
+# gprof flat profile row; the calls/per-call columns are empty for
+# functions that were sampled but never entered through mcount
+GPROF_ROW = re.compile(
+    r"^\s*([\d.]+)\s+([\d.]+)\s+([\d.]+)\s+"
+    r"(?:(\d+)\s+([\d.]+)\s+([\d.]+)\s+)?(\S+)\s*$")
+
+# Map file input section: " .text.foo  0x00001234  0x56 file.o", where the
+# section name may be on a line of its own when it is too long
+MAP_INPUT = re.compile(r"^ (\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*))?$")
+MAP_CONT = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+MAP_OUTPUT = re.compile(r"^(\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+
+
+def base_name(symbol):
+    while True:
+        stripped = CLONE_SUFFIX.sub("", symbol)
+        if stripped == symbol:
+            return symbol
+        symbol = stripped
+
+
+def parse_gprof(lines):
+    """Returns: list of (function, self_seconds, calls) in profile order."""
+    rows = []
+    for line in lines:
+        match = GPROF_ROW.match(line)
+        if not match:
+            continue
+        self_seconds = float(match.group(3))
+        calls = int(match.group(4)) if match.group(4) else 0
+        rows.append((match.group(7), self_seconds, calls))
+    return rows
+
+
+def parse_map_sections(lines):
+    """Returns: list of (section, address, size, origin) for input sections."""
+    sections = []
+    pending = None
+    for line in lines:
+        line = line.rstrip("\n")
+        if pending is not None:
+            cont = MAP_CONT.match(line)
+            if cont:
+                sections.append((pending, int(cont.group(1), 16),
+                                 int(cont.group(2), 16), cont.group(3)))
+            pending = None
+            continue
+        match = MAP_INPUT.match(line)
+        if not match:
+            continue
+        if match.group(2) is None:
+            pending = match.group(1)
+        else:
+            sections.append((match.group(1), int(match.group(2), 16),
+                             int(match.group(3), 16), match.group(4)))
+    return sections
+
+
+def parse_map_output_section(lines, name):
+    """Returns: (address, size) of an output section, or None."""
+    for line in lines:
+        match = MAP_OUTPUT.match(line)
+        if match and match.group(1) == name:
+            return int(match.group(2), 16), int(match.group(3), 16)
+    return None
+
+
+def function_sizes(sections):
+    """Returns: dict of function base name -> largest .text.<name> size."""
+    sizes = {}
+    for section, _address, size, _origin in sections:
+        if not section.startswith(".text.") or size == 0:
+            continue
+        name = base_name(section[len(".text."):])
+        sizes[name] = max(size, sizes.get(name, 0))
+    return sizes
+
+
+def select_functions(profile, sizes, budget, min_share=0.0,
+                     estimated_size=DEFAULT_ESTIMATED_SIZE):
+    """
+    Greedy selection by self time per byte within budget.
+    Without sizes (first build) functions are taken in profile order, each
+    counted as estimated_size bytes against the budget.
+
+    Returns: list of (function, self_seconds, size or None)
+    """
+    total = sum(seconds for _name, seconds, _calls in profile) or 1.0
+    candidates = []
+    for name, seconds, _calls in profile:
+        name = base_name(name)
+        if seconds <= 0.0 or seconds / total < min_share:
+            continue
+        if sizes is None:
+            candidates.append((name, seconds, None))
+        elif name in sizes:
+            candidates.append((name, seconds, sizes[name]))
+
+    if sizes is None:
+        return candidates[:budget // max(estimated_size, 1)]
+
+    candidates.sort(key=lambda c: c[1] / c[2], reverse=True)
+    chosen = []
+    used = 0
+    for name, seconds, size in candidates:
+        aligned = (size + 3) & ~3
+        if used + aligned > budget:
+            continue
+        chosen.append((name, seconds, size))
+        used += aligned
+    return chosen
+
+
+def render_fragment(chosen, origin, budget, load_region, insert_before):
+    out = []
+    out.append("/* Generated by tools/tcm_placement.py - do not edit */")
+    out.append("")
+    out.append("MEMORY")
+    out.append("{")
+    out.append("    %s (RX) : ORIGIN = 0x%08X, LENGTH = 0x%X" % (REGION_NAME, origin, budget))
+    out.append("}")
+    out.append("")
+    out.append("SECTIONS")
+    out.append("{")
+    out.append("    %s : ALIGN(4)" % SECTION_NAME)
+    out.append("    {")
+    out.append("        __zork_itcm_start = .;")
+    for name, seconds, size in chosen:
+        size_note = "%u bytes" % size if size is not None else "size unknown"
+        out.append("        /* %s: %.3f s, %s */" % (name, seconds, size_note))
+        out.append("        *(.text.%s .text.%s.*)" % (name, name))
+    out.append("        . = ALIGN(4);")
+    out.append("        __zork_itcm_end = .;")
+    out.append("    } > %s AT> %s" % (REGION_NAME, load_region))
+    out.append("    __zork_itcm_load = LOADADDR(%s);" % SECTION_NAME)
+    out.append("}")
+    out.append("INSERT BEFORE %s;" % insert_before)
+    out.append("")
+    return "\n".join(out)
+
+
+def fragment_functions(lines):
+    """Returns: function names listed in a generated fragment, in order."""
+    names = []
+    for line in lines:
+        match = re.match(r"^\s*\*\(\.text\.(\S+) ", line)
+        if match:
+            names.append(match.group(1))
+    return names
+
+
+def placement_report(map_lines, functions, itcm_range):
+    """
+    Returns: (rows, itcm_used) where rows are (function, address, size, in_itcm)
+    with address None for functions the linker never saw (inlined by LTO).
+    """
+    sections = parse_map_sections(map_lines)
+    start, length = itcm_range if itcm_range else (0, 0)
+    found = {}
+    for section, address, size, _origin in sections:
+        if not section.startswith(".text.") or size == 0:
+            continue
+        name = base_name(section[len(".text."):])
+        if name in functions and name not in found:
+            found[name] = (address, size)
+
+    rows = []
+    for name in functions:
+        if name not in found:
+            rows.append((name, None, 0, False))
+            continue
+        address, size = found[name]
+        in_itcm = itcm_range is not None and start <= address < start + length
+        rows.append((name, address, size, in_itcm))
+    return rows, length
+
+
+def read_lines(path):
+    with open(path, "r", errors="replace") as handle:
+        return handle.readlines()
+
+
+def cmd_select(args):
+    profile = parse_gprof(read_lines(args.profile))
+    if not profile:
+        sys.stderr.write("tcm_placement: no gprof flat profile rows in %s\n" % args.profile)
+        return 1
+
+    sizes = None
+    if args.map:
+        sizes = function_sizes(parse_map_sections(read_lines(args.map)))
+        if not sizes:
+            sys.stderr.write("tcm_placement: no .text.* sections in %s "
+                             "(built without -ffunction-sections?)\n" % args.map)
+            return 1
+
+    chosen = select_functions(profile, sizes, args.budget, args.min_share,
+                              args.estimated_size)
+    if args.max_functions:
+        chosen = chosen[:args.max_functions]
+
+    fragment = render_fragment(chosen, args.origin, args.budget,
+                               args.load_region, args.insert_before)
+    with open(args.output, "w") as handle:
+        handle.write(fragment)
+
+    total = sum(seconds for _name, seconds, _calls in profile) or 1.0
+    hot = sum(seconds for _name, seconds, _size in chosen)
+    if sizes is None:
+        print("tcm_placement: no --map, assuming %u bytes per function; "
+              "rebuild with the resulting map for an exact fit" % args.estimated_size)
+        used = len(chosen) * args.estimated_size
+    else:
+        used = sum(size for _name, _seconds, size in chosen)
+    print("tcm_placement: %d functions, %.1f%% of profiled time, %u/%u bytes -> %s"
+          % (len(chosen), 100.0 * hot / total, used, args.budget, args.output))
+    return 0
+
+
+def cmd_report(args):
+    map_lines = read_lines(args.map)
+    if args.fragment:
+        functions = fragment_functions(read_lines(args.fragment))
+    else:
+        functions = args.functions or []
+
+    itcm = parse_map_output_section(map_lines, SECTION_NAME)
+    if itcm is None:
+        print("tcm_placement: %s not present in %s" % (SECTION_NAME, args.map))
+    else:
+        print("tcm_placement: %s at 0x%08X, %u bytes" % (SECTION_NAME, itcm[0], itcm[1]))
+
+    rows, _length = placement_report(map_lines, functions, itcm)
+    missing = 0
+    for name, address, size, in_itcm in rows:
+        if address is None:
+            print("  %-40s  (not in map - inlined or discarded)" % name)
+            missing += 1
+        else:
+            print("  %-40s  0x%08X  %6u  %s"
+                  % (name, address, size, "ITCM" if in_itcm else "flash"))
+    placed = sum(1 for row in rows if row[3])
+    print("tcm_placement: %d/%d selected functions in ITCM, %d not found"
+          % (placed, len(rows), missing))
+    return 0
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Profile-driven ITCM placement")
+    sub = parser.add_subparsers(dest="command")
+    sub.required = True
+
+    sel = sub.add_parser("select", help="generate the linker fragment")
+    sel.add_argument("--profile", required=True, help="gprof -b -p output")
+    sel.add_argument("--map", help="ZorkUI.map from a previous build (for sizes)")
+    sel.add_argument("--budget", type=lambda v: int(v, 0), default=0x10000,
+                     help="ITCM bytes available (default 64 KB)")
+    sel.add_argument("--origin", type=lambda v: int(v, 0), default=0x1000,
+                     help="ITCM start address (default 0x1000, keeps NULL unmapped)")
+    sel.add_argument("--load-region", default="m_text",
+                     help="flash region holding the load image")
+    sel.add_argument("--insert-before", default=".text",
+                     help="output section the fragment is inserted before")
+    sel.add_argument("--min-share", type=float, default=0.001,
+                     help="ignore functions below this share of self time")
+    sel.add_argument("--estimated-size", type=lambda v: int(v, 0),
+                     default=DEFAULT_ESTIMATED_SIZE,
+                     help="bytes assumed per function without --map (default 1024)")
+    sel.add_argument("--max-functions", type=int, default=0)
+    sel.add_argument("--output", required=True)
+    sel.set_defaults(func=cmd_select)
+
+    rep = sub.add_parser("report", help="report placement from a map file")
+    rep.add_argument("--map", required=True)
+    rep.add_argument("--fragment", help="fragment listing the selected functions")
+    rep.add_argument("functions", nargs="*")
+    rep.set_defaults(func=cmd_report)
+
+    args = parser.parse_args(argv)
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -29,6 +29,10 @@
     #define DISPLAY_STATUS_HEIGHT   24
     #define DISPLAY_INPUT_HEIGHT    32
     #define DISPLAY_MARGIN          4
+
+    // Game text (ZorkUI_RT1050.qml uses fixed 16 px and reserves 70 px for icons)
+    #define DISPLAY_TEXT_PIXEL_SIZE 16
+    #define DISPLAY_TEXT_WIDTH      (DISPLAY_WIDTH - 2 * DISPLAY_MARGIN - 70)
 #endif
 
 /*
@@ -46,6 +50,10 @@
     #define DISPLAY_STATUS_HEIGHT   48
     #define DISPLAY_INPUT_HEIGHT    56
     #define DISPLAY_MARGIN          8
+
+    // Game text
+    #define DISPLAY_TEXT_PIXEL_SIZE DISPLAY_FONT_SIZE
+    #define DISPLAY_TEXT_WIDTH      (DISPLAY_WIDTH - 2 * DISPLAY_MARGIN)
 #endif
 
 /*
@@ -64,6 +72,39 @@
     #define DISPLAY_STATUS_HEIGHT   36
     #define DISPLAY_INPUT_HEIGHT    42
     #define DISPLAY_MARGIN          6
+
+    // Game text
+    #define DISPLAY_TEXT_PIXEL_SIZE DISPLAY_FONT_SIZE
+    #define DISPLAY_TEXT_WIDTH      (DISPLAY_WIDTH - 2 * DISPLAY_MARGIN)
 #endif
 
+/*
+ * Fixed-pitch text metrics
+ *
+ * fonts/ZorkMCUFontmap.fmp is CascadiaCode: every glyph advances by the
+ * same width, so the game text area is a character grid. Values are in
+ * font units (head.unitsPerEm, hhea.advanceWidthMax, ascent - descent);
+ * tools/story_glyphs.py --fontmap prints them for another font.
+ */
+#define DISPLAY_FONT_UNITS_PER_EM   2048
+#define DISPLAY_FONT_ADVANCE        1200
+#define DISPLAY_FONT_LINE_HEIGHT    2380
+
+// Characters per game text line and pixel height of a line
+#define DISPLAY_TEXT_COLUMNS    (DISPLAY_TEXT_WIDTH * DISPLAY_FONT_UNITS_PER_EM / \
+                                 (DISPLAY_FONT_ADVANCE * DISPLAY_TEXT_PIXEL_SIZE))
+#define DISPLAY_LINE_HEIGHT     ((DISPLAY_FONT_LINE_HEIGHT * DISPLAY_TEXT_PIXEL_SIZE + \
+                                  DISPLAY_FONT_UNITS_PER_EM - 1) / DISPLAY_FONT_UNITS_PER_EM)
+
+// Game text lines between the status bar and the input line (keyboard hidden)
+#define DISPLAY_TEXT_ROWS       ((DISPLAY_HEIGHT - DISPLAY_STATUS_HEIGHT - DISPLAY_INPUT_HEIGHT - \
+                                  2 * DISPLAY_MARGIN) / DISPLAY_LINE_HEIGHT)
+
+/*
+ * The interpreter is told the screen is DISPLAY_TEXT_COLUMNS x DISPLAY_TEXT_ROWS
+ * (fizmo_rtos_bridge.h, fizmo_bridge.cpp), so libfizmo wraps game text to
+ * the width QML shows and the output Text needs no wrapping of its own.
+ * DisplayConfig.h is included from the C bridges: keep it C-compatible.
+ */
+
 #endif // DISPLAYCONFIG_H
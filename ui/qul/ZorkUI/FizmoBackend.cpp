@@ -5,6 +5,10 @@
  */
 
 #include "FizmoBackend.h"
+#include "GlyphPrimingTable.h"
+#include "OutputLines.h"
+#include "UpperWindow.h"
+#include "fizmo_output_ring.h"
 
 #include <cstring>
 #include <cstdlib>
@@ -60,6 +64,28 @@ void fizmo_submit_line(const char *line) {
 }
 
 void fizmo_submit_char(uint32_t ch) { (void)ch; }
+void fizmo_edit_insert(const char *text, size_t length) { (void)text; (void)length; }
+void fizmo_edit_erase(size_t count) { (void)count; }
+bool fizmo_get_preloaded_line(uint32_t *serial, char *line, size_t size) {
+    (void)serial; (void)line; (void)size;
+    return false;
+}
+
+uint16_t fizmo_story_count(void) { return 1; }
+bool fizmo_get_story_name(uint16_t index, char *name, size_t name_size) {
+    if (index != 0 || name_size == 0) return false;
+    strncpy(name, "zork1", name_size - 1);
+    name[name_size - 1] = '\0';
+    return true;
+}
+bool fizmo_waiting_for_story(void) { return false; }
+int fizmo_select_story(uint16_t index) { (void)index; return -1; }
+
+uint16_t fizmo_get_upper_window_rows(void) { return 0; }
+size_t fizmo_read_upper_window_changes(upper_window_cell_t *changes, size_t max_changes) {
+    (void)changes; (void)max_changes;
+    return 0;
+}
 
 void fizmo_bridge_init(const char *) {}
 void fizmo_start_interpreter(void) {}
@@ -93,27 +119,208 @@ static const int POLL_INTERVAL_MS = 50;
 static const int READ_BUFFER_SIZE = 256;
 static uint32_t s_readBuffer[READ_BUFFER_SIZE];
 
+// Upper window cells are fetched in batches of this many changes
+static const int UPPER_CHANGE_BATCH = 64;
+static upper_window_cell_t s_upperChanges[UPPER_CHANGE_BATCH];
+
 // Story file path - can be overridden via ZORK_STORY_PATH environment variable
 #ifndef ZORK_STORY_PATH
 #define ZORK_STORY_PATH "zork1.z3"
 #endif
 
+#ifndef FIZMO_GLYPH_PRIMING
+#define FIZMO_GLYPH_PRIMING 0
+#endif
+
+#ifndef FIZMO_TEXT_GRID
+#define FIZMO_TEXT_GRID 0
+#endif
+
+#if defined(DESKTOP_STUB)
+#define FIZMO_OUTPUT_WRAPPED 0
+#else
+#define FIZMO_OUTPUT_WRAPPED 1
+#endif
+
+/*
+ * Helper: break an echoed command (" text\n", printed after the ">" prompt)
+ * at spaces so it fits DISPLAY_TEXT_COLUMNS like the interpreter's own
+ * output; the output Text does not wrap it when outputWrapped is set
+ */
+static void wrap_echo(char *echo)
+{
+    int column = 1;             // The prompt
+    char *space = nullptr;
+    int spaceColumn = 0;
+    for (char *p = echo; *p != '\0' && *p != '\n'; p++) {
+        if ((*p & 0xC0) == 0x80) {
+            continue;           // UTF-8 continuation byte
+        }
+        if (column >= DISPLAY_TEXT_COLUMNS && space != nullptr) {
+            *space = '\n';
+            column -= spaceColumn + 1;
+            space = nullptr;
+        }
+        if (*p == ' ') {
+            space = p;
+            spaceColumn = column;
+        }
+        column++;
+    }
+}
+
+#if defined(DESKTOP_STUB) || defined(USE_FIZMO_BRIDGE)
+// Desktop glyph recording and frame timing for FIZMO_GLYPH_PRIMING:
+//   ZORK_GLYPH_RECORD=<file>  write "<pixel size> <code point>" the first time
+//                             each glyph reaches a game text item, for
+//                             tools/glyph_priming.py
+//   ZORK_GLYPH_PRIMING=0|1    override FIZMO_GLYPH_PRIMING to compare runs
+//   ZORK_TEXT_GRID=0|1        override FIZMO_TEXT_GRID to compare runs
+//   ZORK_FRAME_LOG=1          log the stall after every poll that shows new output
+// The [glyphs] lines are only printed with priming built in or
+// ZORK_GLYPH_PRIMING set. What they report is how late the UI-thread poll
+// timer fires: an upper bound on the time the UI thread spent since the
+// previous poll (including rendering the new text), not the render time
+// itself. For per-frame render times on the board, build with Qt for MCUs'
+// QUL_ENABLE_PERFORMANCE_LOGGING.
+#include <chrono>
+#include <cstdio>
+
+static FILE *s_glyphRecord = nullptr;
+static uint32_t s_glyphSeen[0x10000 / 32];
+
+static void record_glyphs(const char *utf8)
+{
+    if (s_glyphRecord == nullptr || utf8 == nullptr) {
+        return;
+    }
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(utf8);
+    while (*p != '\0') {
+        uint32_t ch = *p++;
+        int extra = (ch >= 0xF0) ? 3 : (ch >= 0xE0) ? 2 : (ch >= 0xC0) ? 1 : 0;
+        ch &= (extra == 0) ? 0x7F : (0x3F >> extra);
+        for (; extra > 0 && (*p & 0xC0) == 0x80; extra--) {
+            ch = (ch << 6) | (*p++ & 0x3F);
+        }
+        if (ch < 0x20 || ch >= 0x10000 || (s_glyphSeen[ch / 32] & (1u << (ch % 32)))) {
+            continue;
+        }
+        s_glyphSeen[ch / 32] |= 1u << (ch % 32);
+        fprintf(s_glyphRecord, "%d %04X\n", DISPLAY_TEXT_PIXEL_SIZE, static_cast<unsigned>(ch));
+        fflush(s_glyphRecord);
+    }
+}
+
+// Frames reported: the first one after boot (splash, and priming if on),
+// the one showing the first output, and the one showing the first response
+enum class FrameStage { FirstOutput, FirstPause, FirstResponse, Done };
+static FrameStage s_frameStage = FrameStage::FirstOutput;
+static const char *s_frameProbe = "boot";  // Reported at the next poll tick
+static bool s_glyphLog = false;
+static std::chrono::steady_clock::time_point s_lastPoll;
+static bool s_frameLog = false;
+static bool s_frameLogPending = false;
+static unsigned s_frameLogCount = 0;
+static long long s_frameLogTotal = 0;
+
+static void frame_probe_tick(bool priming, bool grid)
+{
+    auto now = std::chrono::steady_clock::now();
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(now - s_lastPoll).count()
+                   - POLL_INTERVAL_MS * 1000LL;
+    if (us < 0) {
+        us = 0;
+    }
+    if (s_frameProbe != nullptr && s_glyphLog) {
+        fprintf(stderr, "[glyphs] %s: poll %lld us late (priming %s)\n",
+                s_frameProbe, us, priming ? "on" : "off");
+    }
+    s_frameProbe = nullptr;
+    if (s_frameLogPending) {
+        s_frameLogCount++;
+        s_frameLogTotal += us;
+        fprintf(stderr, "[frame] #%u poll %lld us late, average %lld us (%s)\n",
+                s_frameLogCount, us, s_frameLogTotal / s_frameLogCount,
+                grid ? "text grid" : "Text");
+        s_frameLogPending = false;
+    }
+    s_lastPoll = now;
+}
+
+static void frame_probe_poll(bool hadOutput)
+{
+    s_frameLogPending = s_frameLog && hadOutput;
+
+    switch (s_frameStage) {
+        case FrameStage::FirstOutput:
+            if (hadOutput) {
+                s_frameProbe = "first output";
+                s_frameStage = FrameStage::FirstPause;
+            }
+            break;
+        case FrameStage::FirstPause:
+            // A poll without output ends the intro; the next output answers a command
+            if (!hadOutput) {
+                s_frameStage = FrameStage::FirstResponse;
+            }
+            break;
+        case FrameStage::FirstResponse:
+            if (hadOutput) {
+                s_frameProbe = "first response";
+                s_frameStage = FrameStage::Done;
+            }
+            break;
+        case FrameStage::Done:
+            break;
+    }
+}
+#endif
+
 FizmoBackend::FizmoBackend()
     : outputVersion(0)
     , statusVersion(0)
     , commandVersion(0)
+    , preloadVersion(0)
     , waitingForInput(false)
     , waitingForChar(false)
     , gameExited(false)
+    , storyCount(0)
+    , choosingStory(false)
+    , glyphPriming(FIZMO_GLYPH_PRIMING != 0)
+    , textGrid(FIZMO_TEXT_GRID != 0)
+    , outputWrapped(FIZMO_OUTPUT_WRAPPED != 0)
     , m_outputLength(0)
     , m_currentOutputStart(0)
     , m_commandLength(0)
+    , m_editSerial(0)
 {
     m_outputBuffer[0] = '\0';
     m_statusRoom[0] = '\0';
     m_statusScore[0] = '\0';
     m_commandBuffer[0] = '\0';
 
+#if defined(DESKTOP_STUB) || defined(USE_FIZMO_BRIDGE)
+    const char *recordPath = getenv("ZORK_GLYPH_RECORD");
+    if (recordPath != nullptr && recordPath[0] != '\0') {
+        s_glyphRecord = fopen(recordPath, "w");
+        if (s_glyphRecord == nullptr) {
+            fprintf(stderr, "[glyphs] Cannot open %s\n", recordPath);
+        }
+    }
+    const char *primingEnv = getenv("ZORK_GLYPH_PRIMING");
+    if (primingEnv != nullptr && primingEnv[0] != '\0') {
+        glyphPriming.setValue(primingEnv[0] != '0');
+    }
+    s_glyphLog = FIZMO_GLYPH_PRIMING != 0 || (primingEnv != nullptr && primingEnv[0] != '\0');
+    const char *gridEnv = getenv("ZORK_TEXT_GRID");
+    if (gridEnv != nullptr && gridEnv[0] != '\0') {
+        textGrid.setValue(gridEnv[0] != '0');
+    }
+    const char *frameLogEnv = getenv("ZORK_FRAME_LOG");
+    s_frameLog = frameLogEnv != nullptr && frameLogEnv[0] == '1';
+    s_lastPoll = std::chrono::steady_clock::now();
+#endif
+
 #if defined(USE_FIZMO_BRIDGE)
     // Initialize and start the fizmo interpreter
     const char *storyPath = ZORK_STORY_PATH;
@@ -129,6 +336,19 @@ FizmoBackend::FizmoBackend()
     }
 #endif
 
+    // Story names for the picker (the interpreter waits for selectStory()
+    // when there is more than one)
+    int count = fizmo_story_count();
+    if (count > MAX_STORIES) {
+        count = MAX_STORIES;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!fizmo_get_story_name(static_cast<uint16_t>(i), m_storyNames[i], sizeof(m_storyNames[i]))) {
+            m_storyNames[i][0] = '\0';
+        }
+    }
+    storyCount.setValue(count);
+
     // Set up polling timer
     m_pollTimer.setInterval(POLL_INTERVAL_MS);
     m_pollTimer.setSingleShot(false);
@@ -153,11 +373,44 @@ const char* FizmoBackend::getStatusScore() const
     return m_statusScore;
 }
 
+const char* FizmoBackend::getStoryName(int index) const
+{
+    if (index < 0 || index >= storyCount.value()) {
+        return "";
+    }
+    return m_storyNames[index];
+}
+
+const char* FizmoBackend::getPrimingText() const
+{
+    for (const GlyphPrimingEntry *entry = GLYPH_PRIMING_TABLE; entry->text != nullptr; entry++) {
+        if (entry->pixelSize == DISPLAY_TEXT_PIXEL_SIZE) {
+            return entry->text;
+        }
+    }
+    return "";
+}
+
+void FizmoBackend::selectStory(int index)
+{
+    if (index < 0 || index >= storyCount.value()) {
+        return;
+    }
+    if (fizmo_select_story(static_cast<uint16_t>(index)) == 0) {
+        choosingStory.setValue(false);
+    }
+}
+
 void FizmoBackend::submitLine(const Qul::Private::String &text)
 {
     // Mark where the new output will start (after existing content)
     m_currentOutputStart = m_outputLength;
 
+    // The bridge drops its copy of the line on submit; so does the mirror,
+    // which makes the TextInput's clear() afterwards a no-op
+    m_commandLength = 0;
+    m_commandBuffer[0] = '\0';
+
     // Get raw string data - QML TextInput provides UTF-8 or Latin1 format
     const char *utf8 = text.maybeUtf8();
     if (utf8 != nullptr) {
@@ -181,6 +434,9 @@ void FizmoBackend::submitLine(const Qul::Private::String &text)
             }
             echoBuffer[len + 1] = '\n';
             echoBuffer[len + 2] = '\0';
+            if (outputWrapped.value()) {
+                wrap_echo(echoBuffer);
+            }
 
             appendOutput(echoBuffer);
 #else
@@ -192,6 +448,9 @@ void FizmoBackend::submitLine(const Qul::Private::String &text)
             }
             echoBuffer[len + 1] = '\n';
             echoBuffer[len + 2] = '\0';
+            if (outputWrapped.value()) {
+                wrap_echo(echoBuffer);
+            }
 
             appendOutput(echoBuffer);
 #endif
@@ -216,6 +475,9 @@ void FizmoBackend::submitLine(const Qul::Private::String &text)
             memcpy(echoBuffer + 1, buffer, len);
             echoBuffer[len + 1] = '\n';
             echoBuffer[len + 2] = '\0';
+            if (outputWrapped.value()) {
+                wrap_echo(echoBuffer);
+            }
 
             appendOutput(echoBuffer);            
             fizmo_submit_line(buffer);
@@ -268,6 +530,9 @@ void FizmoBackend::clearOutput()
     m_outputLength = 0;
     m_outputBuffer[0] = '\0';
     m_currentOutputStart = 0;
+    if (textGrid.value()) {
+        OutputLines::instance().clear();
+    }
     outputVersion.setValue(outputVersion.value() + 1);
 }
 
@@ -399,12 +664,26 @@ void FizmoBackend::appendOutput(const char *text)
     // Apply smart trimming to maintain scrollback buffer
     trim_output_buffer(m_outputBuffer, &m_outputLength, &m_currentOutputStart);
 
+#if defined(DESKTOP_STUB) || defined(USE_FIZMO_BRIDGE)
+    record_glyphs(text);
+#endif
+
+    // The grid only rewrites the lines this text lands on
+    if (textGrid.value()) {
+        OutputLines::instance().append(text);
+    }
+
     // Increment version to trigger QML rebinding
     outputVersion.setValue(outputVersion.value() + 1);
 }
 
 void FizmoBackend::pollFizmoOutput()
 {
+#if defined(DESKTOP_STUB) || defined(USE_FIZMO_BRIDGE)
+    frame_probe_tick(glyphPriming.value(), textGrid.value());
+    frame_probe_poll(fizmo_output_available() > 0);
+#endif
+
     // Check for output from fizmo
     size_t available = fizmo_output_available();
     while (available > 0) {
@@ -419,6 +698,15 @@ void FizmoBackend::pollFizmoOutput()
             for (size_t i = 0; i < read && utf8Len < (int)sizeof(utf8Buffer) - 4; i++) {
                 uint32_t ch = s_readBuffer[i];
 
+                if (ch & FIZMO_OUTPUT_STYLE_MARKER) {
+                    // Style change: text so far goes out in the old style
+                    utf8Buffer[utf8Len] = '\0';
+                    appendOutput(utf8Buffer);
+                    utf8Len = 0;
+                    OutputLines::instance().setStyle(static_cast<int>(ch & ~FIZMO_OUTPUT_STYLE_MARKER));
+                    continue;
+                }
+
                 if (ch < 0x80) {
                     utf8Buffer[utf8Len++] = static_cast<char>(ch);
                 } else if (ch < 0x800) {
@@ -444,12 +732,39 @@ void FizmoBackend::pollFizmoOutput()
         available = fizmo_output_available();
     }
 
+    // Upper window: apply only the cells written since the last poll
+    UpperWindow &upper = UpperWindow::instance();
+    size_t changes;
+    do {
+        changes = fizmo_read_upper_window_changes(s_upperChanges, UPPER_CHANGE_BATCH);
+        upper.apply(s_upperChanges, static_cast<int>(changes));
+    } while (changes == UPPER_CHANGE_BATCH);
+    upper.commit();
+
+    int upperRows = fizmo_get_upper_window_rows();
+    if (upperRows != upper.rows.value()) {
+        upper.rows.setValue(upperRows);
+    }
+
+    // Story picker state
+    bool choosing = fizmo_waiting_for_story();
+    if (choosing != choosingStory.value()) {
+        choosingStory.setValue(choosing);
+    }
+
     // Update input waiting state
     bool waiting = fizmo_waiting_for_input();
     if (waiting != waitingForInput.value()) {
         waitingForInput.setValue(waiting);
     }
 
+    // A preloaded line (story's read with preloaded_input) replaces the typed one
+    if (fizmo_get_preloaded_line(&m_editSerial, m_commandBuffer, sizeof(m_commandBuffer))) {
+        m_commandLength = static_cast<int>(strlen(m_commandBuffer));
+        commandVersion.setValue(commandVersion.value() + 1);
+        preloadVersion.setValue(preloadVersion.value() + 1);
+    }
+
     bool waitingCh = fizmo_waiting_for_char();
     if (waitingCh != waitingForChar.value()) {
         waitingForChar.setValue(waitingCh);
@@ -471,6 +786,10 @@ void FizmoBackend::pollFizmoOutput()
             changed = true;
         }
         if (changed) {
+#if defined(DESKTOP_STUB) || defined(USE_FIZMO_BRIDGE)
+            record_glyphs(m_statusRoom);
+            record_glyphs(m_statusScore);
+#endif
             statusVersion.setValue(statusVersion.value() + 1);
         }
     }
@@ -531,6 +850,10 @@ void FizmoBackend::appendCommandChar(const Qul::Private::String &key)
         memcpy(m_commandBuffer + m_commandLength, str, len);
         m_commandLength += len;
         m_commandBuffer[m_commandLength] = '\0';
+        fizmo_edit_insert(str, len);
+#if defined(DESKTOP_STUB) || defined(USE_FIZMO_BRIDGE)
+        record_glyphs(m_commandBuffer);
+#endif
         
         // Notify QML
         commandVersion.setValue(commandVersion.value() + 1);
@@ -543,6 +866,7 @@ void FizmoBackend::commandBackspace()
         // Simple backspace - remove last byte (assumes ASCII for now)
         m_commandLength--;
         m_commandBuffer[m_commandLength] = '\0';
+        fizmo_edit_erase(1);
         
         // Notify QML
         commandVersion.setValue(commandVersion.value() + 1);
@@ -561,6 +885,9 @@ void FizmoBackend::submitCommand()
         memcpy(echoBuffer + 1, m_commandBuffer, m_commandLength);
         echoBuffer[m_commandLength + 1] = '\n';
         echoBuffer[m_commandLength + 2] = '\0';
+        if (outputWrapped.value()) {
+            wrap_echo(echoBuffer);
+        }
 
         appendOutput(echoBuffer);
     }
@@ -579,5 +906,34 @@ const char* FizmoBackend::getCommandText() const
     return m_commandBuffer;
 }
 
+void FizmoBackend::syncCommandText(const Qul::Private::String &text)
+{
+    const char *utf8 = text.maybeUtf8();
+    const char *str = utf8 ? utf8 : text.maybeLatin1();
+    int len = str ? text.rawLength() : 0;
+    if (len > (int)sizeof(m_commandBuffer) - 1) {
+        len = sizeof(m_commandBuffer) - 1;
+    }
+
+    // Typing and backspace change the end of the line; send only that part
+    int common = 0;
+    while (common < len && common < m_commandLength && str[common] == m_commandBuffer[common]) {
+        common++;
+    }
+    if (common == len && common == m_commandLength) {
+        return;
+    }
+
+    if (m_commandLength > common) {
+        fizmo_edit_erase(static_cast<size_t>(m_commandLength - common));
+    }
+    if (len > common) {
+        fizmo_edit_insert(str + common, static_cast<size_t>(len - common));
+        memcpy(m_commandBuffer + common, str + common, len - common);
+    }
+    m_commandLength = len;
+    m_commandBuffer[m_commandLength] = '\0';
+}
+
 // Register the singleton
 QUL_SINGLETON(FizmoBackend)
@@ -49,7 +49,10 @@ struct FizmoEvent {
  *   property int outVer: FizmoBackend.outputVersion
  *   Text { text: FizmoBackend.getOutputText() }
  *
- *   TextInput { onAccepted: FizmoBackend.submitLine(text) }
+ *   TextInput {
+ *       onTextChanged: FizmoBackend.syncCommandText(text)
+ *       onAccepted: FizmoBackend.submitLine(text)
+ *   }
  *   visible: FizmoBackend.waitingForInput
  */
 class FizmoBackend : public Qul::Singleton<FizmoBackend>
@@ -83,6 +86,10 @@ public:
     // Version counter for command text changes (triggers QML rebind)
     Qul::Property<int> commandVersion;
 
+    // Bumped when the story preloads the command line; a TextInput copies
+    // getCommandText() into its text on change
+    Qul::Property<int> preloadVersion;
+
     // True when fizmo is waiting for line input
     Qul::Property<bool> waitingForInput;
 
@@ -92,6 +99,25 @@ public:
     // True when game has ended
     Qul::Property<bool> gameExited;
 
+    // Number of stories available (embedded catalog or ZORK_STORY_PATH list)
+    Qul::Property<int> storyCount;
+
+    // True while the interpreter waits for a story to be picked
+    Qul::Property<bool> choosingStory;
+
+    // True when the boot splash should draw getPrimingText() to warm the
+    // font cache (FIZMO_GLYPH_PRIMING; desktop: ZORK_GLYPH_PRIMING=0/1)
+    Qul::Property<bool> glyphPriming;
+
+    // True when game output is shown by the OutputLines grid instead of one
+    // wrapped Text (FIZMO_TEXT_GRID; desktop: ZORK_TEXT_GRID=0/1)
+    Qul::Property<bool> textGrid;
+
+    // True when the interpreter already wraps game output at
+    // DISPLAY_TEXT_COLUMNS, so the output Text can skip its own wrapping
+    // (false for the desktop stub, whose demo text is not wrapped)
+    Qul::Property<bool> outputWrapped;
+
     /*
      * Signals
      */
@@ -112,6 +138,12 @@ public:
     // Get status line score/time
     const char* getStatusScore() const;
 
+    // Get the picker name of a story (index < storyCount)
+    const char* getStoryName(int index) const;
+
+    // Get the glyphs to prime at the game text size (GlyphPrimingTable.h)
+    const char* getPrimingText() const;
+
     /*
      * Methods callable from QML - input submission
      */
@@ -123,6 +155,9 @@ public:
     // Submit a single character (when waitingForChar is true)
     void submitChar(int ch);
 
+    // Start the chosen story (when choosingStory is true)
+    void selectStory(int index);
+
     // Helper for backspace - Qt for MCUs has limited string methods
     Qul::Private::String removeLastChar(const Qul::Private::String &text);
 
@@ -135,6 +170,9 @@ public:
     void submitCommand();
     const char* getCommandText() const;
 
+    // Mirror a TextInput's text into the bridge (sends only what changed)
+    void syncCommandText(const Qul::Private::String &text);
+
     /*
      * Methods called from C++ (fizmo task via event queue)
      */
@@ -165,9 +203,14 @@ private:
     char m_statusRoom[64];
     char m_statusScore[32];
 
+    // Story picker names, copied once at startup
+    static const int MAX_STORIES = 8;
+    char m_storyNames[MAX_STORIES][24];
+
     // Command input buffer (managed in C++ to avoid QML concatenation issues)
     char m_commandBuffer[256];
     int m_commandLength;
+    uint32_t m_editSerial;      // Last preloaded line taken from the bridge
 
     // Timer for polling fizmo output queue
     Qul::Timer m_pollTimer;
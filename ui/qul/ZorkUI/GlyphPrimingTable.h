@@ -0,0 +1,22 @@
+/*
+ * GlyphPrimingTable.h
+ *
+ * Generated by tools/glyph_priming.py from no recording (empty table) - do not edit.
+ * Glyphs in the order a recorded playthrough first rendered them, per
+ * pixel size, cut to the font cache budget. FizmoBackend::getPrimingText()
+ * hands the entry for the game text size to the boot splash.
+ */
+
+#ifndef GLYPHPRIMINGTABLE_H
+#define GLYPHPRIMINGTABLE_H
+
+struct GlyphPrimingEntry {
+    int pixelSize;
+    const char *text;   // UTF-8
+};
+
+static const GlyphPrimingEntry GLYPH_PRIMING_TABLE[] = {
+    { 0, nullptr }
+};
+
+#endif // GLYPHPRIMINGTABLE_H
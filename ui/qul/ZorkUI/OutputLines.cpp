@@ -0,0 +1,258 @@
+/*
+ * OutputLines.cpp
+ *
+ * Line ring behind the text grid view.
+ */
+
+#include "OutputLines.h"
+
+#include <cstring>
+
+OutputLines::OutputLines()
+    : head(0)
+    , lineCount(1)
+    , m_tail(0)
+    , m_columns(0)
+    , m_spaceByte(-1)
+    , m_spaceColumn(0)
+    , m_style(0)
+    , m_tailStyle(-1)
+{
+    for (int i = 0; i < MAX_LINES; i++) {
+        m_text[i][0] = '\0';
+        m_bytes[i] = 0;
+        m_version[i] = 0;
+        m_dirty[i] = false;
+        m_runCount[i] = 0;
+    }
+}
+
+OutputLine OutputLines::data(int index) const
+{
+    OutputLine line;
+    line.version = (index >= 0 && index < MAX_LINES) ? m_version[index] : 0;
+    return line;
+}
+
+const char* OutputLines::getLine(int slot) const
+{
+    if (slot < 0 || slot >= MAX_LINES) {
+        return "";
+    }
+    return m_text[slot];
+}
+
+bool OutputLines::validRun(int slot, int run) const
+{
+    return slot >= 0 && slot < MAX_LINES && run >= 0 && run < m_runCount[slot];
+}
+
+int OutputLines::getRunCount(int slot) const
+{
+    if (slot < 0 || slot >= MAX_LINES) {
+        return 0;
+    }
+    return m_runCount[slot];
+}
+
+int OutputLines::getRunX(int slot, int run) const
+{
+    if (!validRun(slot, run)) {
+        return 0;
+    }
+    // Fixed pitch: a column is one advance at the game text size
+    return m_runColumn[slot][run] * DISPLAY_FONT_ADVANCE * DISPLAY_TEXT_PIXEL_SIZE /
+           DISPLAY_FONT_UNITS_PER_EM;
+}
+
+int OutputLines::getRunStyle(int slot, int run) const
+{
+    if (!validRun(slot, run)) {
+        return 0;
+    }
+    return m_runStyle[slot][run];
+}
+
+Qul::Private::String OutputLines::getRunText(int slot, int run) const
+{
+    if (!validRun(slot, run)) {
+        return Qul::Private::String();
+    }
+    int start = m_runByte[slot][run];
+    int end = (run + 1 < m_runCount[slot]) ? m_runByte[slot][run + 1] : m_bytes[slot];
+    return Qul::Private::String(m_text[slot] + start, end - start);
+}
+
+void OutputLines::markDirty(int slot)
+{
+    m_dirty[slot] = true;
+}
+
+void OutputLines::newLine()
+{
+    markDirty(m_tail);
+    m_tail = (m_tail + 1) % MAX_LINES;
+
+    // The ring is full: the new line reuses the oldest slot
+    if (lineCount.value() == MAX_LINES) {
+        head.setValue((head.value() + 1) % MAX_LINES);
+    } else {
+        lineCount.setValue(lineCount.value() + 1);
+    }
+
+    m_text[m_tail][0] = '\0';
+    m_bytes[m_tail] = 0;
+    m_runCount[m_tail] = 0;
+    m_tailStyle = -1;
+    m_columns = 0;
+    m_spaceByte = -1;
+    markDirty(m_tail);
+}
+
+void OutputLines::moveRuns(int from, int space, int spaceColumn, bool word)
+{
+    // The old line keeps the runs that start before the break
+    int kept = 0;
+    while (kept < m_runCount[from] && m_runByte[from][kept] < space) {
+        kept++;
+    }
+
+    // The moved word opens with the style in effect at its first byte and
+    // takes along the runs that start inside it
+    int runs = 0;
+    for (int r = 0; word && r < m_runCount[from]; r++) {
+        int byte = m_runByte[from][r] - space - 1;
+        if (byte <= 0) {
+            runs = 1;
+            m_runByte[m_tail][0] = 0;
+            m_runColumn[m_tail][0] = 0;
+            m_runStyle[m_tail][0] = m_runStyle[from][r];
+        } else {
+            m_runByte[m_tail][runs] = static_cast<uint8_t>(byte);
+            m_runColumn[m_tail][runs] = static_cast<uint8_t>(m_runColumn[from][r] - spaceColumn - 1);
+            m_runStyle[m_tail][runs] = m_runStyle[from][r];
+            runs++;
+        }
+    }
+    m_runCount[m_tail] = static_cast<uint8_t>(runs);
+    m_runCount[from] = static_cast<uint8_t>(kept);
+    m_tailStyle = runs > 0 ? m_runStyle[m_tail][runs - 1] : -1;
+}
+
+void OutputLines::appendChar(const char *bytes, int length)
+{
+    if (m_columns >= DISPLAY_TEXT_COLUMNS) {
+        if (bytes[0] == ' ') {
+            // A space at the margin becomes the line break
+            newLine();
+            return;
+        }
+        if (m_spaceByte >= 0) {
+            // Move the partial word after the last space to a new line
+            int from = m_tail;
+            int space = m_spaceByte;
+            int spaceColumn = m_spaceColumn;
+            int wordBytes = m_bytes[from] - space - 1;
+            int wordColumns = m_columns - spaceColumn - 1;
+            m_bytes[from] = space;
+            m_text[from][space] = '\0';
+            newLine();
+            memcpy(m_text[m_tail], m_text[from] + space + 1, wordBytes);
+            m_bytes[m_tail] = wordBytes;
+            m_text[m_tail][wordBytes] = '\0';
+            m_columns = wordColumns;
+            moveRuns(from, space, spaceColumn, wordBytes > 0);
+        } else {
+            newLine();
+        }
+    }
+
+    // Long runs of multi-byte characters break early rather than overflow
+    if (m_bytes[m_tail] + length >= LINE_BYTES) {
+        newLine();
+    }
+
+    if (bytes[0] == ' ') {
+        m_spaceByte = m_bytes[m_tail];
+        m_spaceColumn = m_columns;
+    }
+
+    // A style change (or a line's first character) starts a run; past
+    // MAX_RUNS the last run carries on. Plain text only compares two members.
+    int runs = m_runCount[m_tail];
+    if (m_style != m_tailStyle && runs < MAX_RUNS) {
+        m_runByte[m_tail][runs] = static_cast<uint8_t>(m_bytes[m_tail]);
+        m_runColumn[m_tail][runs] = static_cast<uint8_t>(m_columns);
+        m_runStyle[m_tail][runs] = static_cast<uint8_t>(m_style);
+        m_runCount[m_tail] = static_cast<uint8_t>(runs + 1);
+        m_tailStyle = m_style;
+    }
+
+    memcpy(m_text[m_tail] + m_bytes[m_tail], bytes, length);
+    m_bytes[m_tail] += length;
+    m_text[m_tail][m_bytes[m_tail]] = '\0';
+    m_columns++;
+    markDirty(m_tail);
+}
+
+void OutputLines::append(const char *text)
+{
+    if (text == nullptr) {
+        return;
+    }
+
+    const char *p = text;
+    while (*p != '\0') {
+        unsigned char lead = static_cast<unsigned char>(*p);
+        if (lead == '\n') {
+            newLine();
+            p++;
+            continue;
+        }
+        int length = (lead >= 0xF0) ? 4 : (lead >= 0xE0) ? 3 : (lead >= 0xC0) ? 2 : 1;
+        int available = 1;
+        while (available < length && (p[available] & 0xC0) == 0x80) {
+            available++;
+        }
+        if (lead >= 0x20 && available == length) {
+            appendChar(p, length);
+        }
+        p += available;
+    }
+
+    // Report each touched slot once per append
+    for (int i = 0; i < MAX_LINES; i++) {
+        if (m_dirty[i]) {
+            m_dirty[i] = false;
+            m_version[i]++;
+            dataChanged(i);
+        }
+    }
+}
+
+void OutputLines::setStyle(int style)
+{
+    m_style = style & 0xFF;
+}
+
+void OutputLines::clear()
+{
+    for (int i = 0; i < MAX_LINES; i++) {
+        m_text[i][0] = '\0';
+        m_bytes[i] = 0;
+        m_runCount[i] = 0;
+        m_version[i]++;
+        m_dirty[i] = false;
+    }
+    m_tail = 0;
+    m_columns = 0;
+    m_spaceByte = -1;
+    m_style = 0;
+    m_tailStyle = -1;
+    head.setValue(0);
+    lineCount.setValue(1);
+    modelReset();
+}
+
+// Register the singleton
+QUL_SINGLETON(OutputLines)
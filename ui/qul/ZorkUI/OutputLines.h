@@ -0,0 +1,155 @@
+/*
+ * OutputLines.h
+ *
+ * Game output as a ring of fixed-width lines for the text grid view.
+ *
+ * A Text over the whole output buffer re-shapes every paragraph on each
+ * outputVersion bump. Here output is split into DISPLAY_TEXT_COLUMNS-wide
+ * lines once, in C++, and QML shows one unwrapped Text per ring slot. The
+ * interpreter already wraps at that width, so append() mostly splits at
+ * newlines; its own wrapping only catches the desktop stub's text.
+ * Appending touches only the slots it writes, reported with
+ * dataChanged(slot), so only those delegates rebind and re-shape;
+ * scrolling moves the ring head, which only repositions delegates.
+ *
+ * Text styles (setStyle(), from the output ring's style markers) are kept
+ * as up to MAX_RUNS runs per line: where the run starts and its style. A
+ * line in one style is one run, so plain text adds a compare per character.
+ *
+ * The ring only has storage where the grid can be shown: FIZMO_TEXT_GRID
+ * builds, and desktop builds, where ZORK_TEXT_GRID switches it at run time.
+ * Elsewhere the singleton stays linked (the QML refers to it), but it keeps
+ * one empty slot and reports no rows, so the Repeater creates no delegates.
+ *
+ * QML usage:
+ *   Repeater {
+ *       model: OutputLines
+ *       delegate: Item {
+ *           id: gridLine
+ *           property int slot: index
+ *           property int version: model.version
+ *           property int row: (index - OutputLines.head + OutputLines.capacity) % OutputLines.capacity
+ *           y: row * OutputLines.lineHeight
+ *           visible: row < OutputLines.lineCount
+ *           Repeater {
+ *               model: gridLine.version >= 0 ? OutputLines.getRunCount(gridLine.slot) : 0
+ *               delegate: Text {
+ *                   x: OutputLines.getRunX(gridLine.slot, index)
+ *                   font.bold: (OutputLines.getRunStyle(gridLine.slot, index) & 2) != 0
+ *                   text: gridLine.version >= 0 ? OutputLines.getRunText(gridLine.slot, index) : ""
+ *               }
+ *           }
+ *       }
+ *   }
+ */
+
+#ifndef OUTPUTLINES_H
+#define OUTPUTLINES_H
+
+#include <qul/singleton.h>
+#include <qul/property.h>
+#include <qul/model.h>
+#include <qul/private/unicodestring.h>
+
+#include "DisplayConfig.h"
+
+#if FIZMO_TEXT_GRID || defined(DESKTOP_STUB) || defined(USE_FIZMO_BRIDGE)
+#define OUTPUT_LINES_ENABLED 1
+#else
+#define OUTPUT_LINES_ENABLED 0
+#endif
+
+struct OutputLine {
+    int version;    // Bumped whenever the slot's text changes
+};
+
+inline bool operator==(const OutputLine &lhs, const OutputLine &rhs)
+{
+    return lhs.version == rhs.version;
+}
+
+class OutputLines : public Qul::Singleton<OutputLines>, public Qul::ListModel<OutputLine>
+{
+public:
+    // Ring size: scrollback kept by the grid view
+#if !OUTPUT_LINES_ENABLED
+    static const int MAX_LINES = 1;
+#elif defined(DISPLAY_RT1050)
+    static const int MAX_LINES = 32;
+#else
+    static const int MAX_LINES = 64;
+#endif
+    // Bytes per line: DISPLAY_TEXT_COLUMNS of mostly ASCII UTF-8
+    static const int LINE_BYTES = 128;
+    // Style runs per line; further changes on a line keep the last style
+    static const int MAX_RUNS = 4;
+
+    OutputLines();
+
+    /*
+     * Properties exposed to QML
+     */
+    Qul::Property<int> capacity{MAX_LINES};
+    Qul::Property<int> lineHeight{DISPLAY_LINE_HEIGHT};
+
+    // Slot of the oldest line and number of lines in use (including the
+    // line being written); row of slot s is (s - head) mod capacity
+    Qul::Property<int> head;
+    Qul::Property<int> lineCount;
+
+    /*
+     * ListModel: one entry per ring slot
+     */
+    int count() const override { return OUTPUT_LINES_ENABLED ? MAX_LINES : 0; }
+    OutputLine data(int index) const override;
+
+    // Text of a ring slot (UTF-8, no newline)
+    const char* getLine(int slot) const;
+
+    // Style runs of a ring slot: count, x offset in pixels, FIZMO_STYLE_*
+    // bits and text (UTF-8)
+    int getRunCount(int slot) const;
+    int getRunX(int slot, int run) const;
+    int getRunStyle(int slot, int run) const;
+    Qul::Private::String getRunText(int slot, int run) const;
+
+    /*
+     * Methods called from C++ (FizmoBackend)
+     */
+
+    // Append UTF-8 output, wrapping at DISPLAY_TEXT_COLUMNS on spaces
+    void append(const char *text);
+
+    // Style for text appended from now on (FIZMO_STYLE_* bits)
+    void setStyle(int style);
+
+    // Drop all lines
+    void clear();
+
+private:
+    void appendChar(const char *bytes, int length);
+    void newLine();
+    void markDirty(int slot);
+    void moveRuns(int from, int space, int spaceColumn, bool word);
+    bool validRun(int slot, int run) const;
+
+    char m_text[MAX_LINES][LINE_BYTES];
+    int m_bytes[MAX_LINES];
+    int m_version[MAX_LINES];
+    bool m_dirty[MAX_LINES];
+
+    // Runs per slot: first byte, first column and style of each
+    uint8_t m_runByte[MAX_LINES][MAX_RUNS];
+    uint8_t m_runColumn[MAX_LINES][MAX_RUNS];
+    uint8_t m_runStyle[MAX_LINES][MAX_RUNS];
+    uint8_t m_runCount[MAX_LINES];
+
+    int m_tail;         // Slot being written
+    int m_columns;      // Characters in the tail line
+    int m_spaceByte;    // Byte offset of the last space in the tail line, or -1
+    int m_spaceColumn;  // Its column
+    int m_style;        // Style of text appended next
+    int m_tailStyle;    // Style of the tail line's last run, or -1 if it has none
+};
+
+#endif // OUTPUTLINES_H
@@ -0,0 +1,18 @@
+/*
+ * StoryGlyphs.qml
+ *
+ * Generated by tools/story_glyphs.py from zork1.z3 - do not edit.
+ * Hidden Text items listing every character the story, interpreter and
+ * UI can show (85 code points), so the font engine has exactly those
+ * glyphs at each pixel size used for game text.
+ */
+import QtQuick
+
+Item {
+    visible: false
+
+    Text {
+        font.pixelSize: 16
+        text: " !\"#$%'()*,-./0123456789:;<>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[]_abcdefghijklmnopqrstuvwxyz"
+    }
+}
@@ -0,0 +1,86 @@
+/*
+ * UpperWindow.cpp
+ *
+ * Row model behind the upper window view.
+ */
+
+#include "UpperWindow.h"
+
+UpperWindow::UpperWindow()
+    : rows(0)
+{
+    for (int row = 0; row < MAX_ROWS; row++) {
+        for (int column = 0; column < MAX_COLUMNS; column++) {
+            m_cells[row][column] = ' ';
+        }
+        m_text[row][0] = '\0';
+        m_version[row] = 0;
+        m_dirty[row] = false;
+    }
+}
+
+UpperWindowRow UpperWindow::data(int index) const
+{
+    UpperWindowRow row;
+    row.version = (index >= 0 && index < MAX_ROWS) ? m_version[index] : 0;
+    return row;
+}
+
+const char* UpperWindow::getRow(int row) const
+{
+    if (row < 0 || row >= MAX_ROWS) {
+        return "";
+    }
+    return m_text[row];
+}
+
+void UpperWindow::apply(const upper_window_cell_t *changes, int count)
+{
+    for (int i = 0; i < count; i++) {
+        const upper_window_cell_t &cell = changes[i];
+        if (cell.row < MAX_ROWS && cell.column < MAX_COLUMNS) {
+            m_cells[cell.row][cell.column] = cell.ch;
+            m_dirty[cell.row] = true;
+        }
+    }
+}
+
+void UpperWindow::encodeRow(int row)
+{
+    // Trailing blanks are not drawn; leading and inner ones keep the columns
+    int end = MAX_COLUMNS;
+    while (end > 0 && m_cells[row][end - 1] == ' ') {
+        end--;
+    }
+
+    char *p = m_text[row];
+    for (int column = 0; column < end; column++) {
+        uint16_t ch = m_cells[row][column];
+        if (ch < 0x80) {
+            *p++ = static_cast<char>(ch);
+        } else if (ch < 0x800) {
+            *p++ = static_cast<char>(0xC0 | (ch >> 6));
+            *p++ = static_cast<char>(0x80 | (ch & 0x3F));
+        } else {
+            *p++ = static_cast<char>(0xE0 | (ch >> 12));
+            *p++ = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+            *p++ = static_cast<char>(0x80 | (ch & 0x3F));
+        }
+    }
+    *p = '\0';
+}
+
+void UpperWindow::commit()
+{
+    for (int row = 0; row < MAX_ROWS; row++) {
+        if (m_dirty[row]) {
+            m_dirty[row] = false;
+            encodeRow(row);
+            m_version[row]++;
+            dataChanged(row);
+        }
+    }
+}
+
+// Register the singleton
+QUL_SINGLETON(UpperWindow)
@@ -0,0 +1,87 @@
+/*
+ * UpperWindow.h
+ *
+ * The Z-machine upper window (V4+ split screen) as one Text per grid row.
+ *
+ * The bridge keeps the character grid and hands over only the cells that
+ * changed (upper_window.h); FizmoBackend feeds them to apply() on each poll.
+ * A row is re-encoded and reported with dataChanged(row) only if one of its
+ * cells changed, so a menu moving its highlight or a status line bumping
+ * the move counter rebinds one or two delegates. The font is fixed-pitch,
+ * so cell columns line up without per-cell items.
+ *
+ * QML usage:
+ *   Repeater {
+ *       model: UpperWindow
+ *       delegate: Text {
+ *           y: index * UpperWindow.lineHeight
+ *           visible: index < UpperWindow.rows
+ *           text: model.version >= 0 ? UpperWindow.getRow(index) : ""
+ *       }
+ *   }
+ */
+
+#ifndef UPPERWINDOW_H
+#define UPPERWINDOW_H
+
+#include <qul/singleton.h>
+#include <qul/property.h>
+#include <qul/model.h>
+
+#include "DisplayConfig.h"
+#include "upper_window.h"
+
+struct UpperWindowRow {
+    int version;    // Bumped whenever the row's text changes
+};
+
+inline bool operator==(const UpperWindowRow &lhs, const UpperWindowRow &rhs)
+{
+    return lhs.version == rhs.version;
+}
+
+class UpperWindow : public Qul::Singleton<UpperWindow>, public Qul::ListModel<UpperWindowRow>
+{
+public:
+    static const int MAX_ROWS = UPPER_WINDOW_MAX_ROWS;
+    static const int MAX_COLUMNS = UPPER_WINDOW_MAX_COLUMNS;
+
+    UpperWindow();
+
+    /*
+     * Properties exposed to QML
+     */
+    Qul::Property<int> lineHeight{DISPLAY_LINE_HEIGHT};
+
+    // Rows currently split off for the upper window (0 when not split)
+    Qul::Property<int> rows;
+
+    /*
+     * ListModel: one entry per grid row
+     */
+    int count() const override { return MAX_ROWS; }
+    UpperWindowRow data(int index) const override;
+
+    // Text of a grid row (UTF-8, trailing blanks trimmed)
+    const char* getRow(int row) const;
+
+    /*
+     * Methods called from C++ (FizmoBackend)
+     */
+
+    // Store changed cells; rows are re-encoded by commit()
+    void apply(const upper_window_cell_t *changes, int count);
+
+    // Re-encode the rows apply() touched and report them to QML
+    void commit();
+
+private:
+    void encodeRow(int row);
+
+    uint16_t m_cells[MAX_ROWS][MAX_COLUMNS];
+    char m_text[MAX_ROWS][MAX_COLUMNS * 3 + 1];
+    int m_version[MAX_ROWS];
+    bool m_dirty[MAX_ROWS];
+};
+
+#endif // UPPERWINDOW_H
@@ -13,14 +13,10 @@ Rectangle {
     height: FizmoBackend.screenHeight
     color: "#1a1a2e"  // Dark blue-black background
 
-    // Hidden text to force static font engine to generate all ASCII glyphs
-    // Zork uses basic Latin alphabet, numbers, and punctuation
+    // Hidden text to force static font engine to generate the glyphs in use
     // Font sizes: 16 (UI + keyboard), 20 (special keys), 28 (GAME OVER)
-    Text {
-        visible: false
-        font.pixelSize: 16
-        text: "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789 .,!?'\"-:;()[]@#$%&*+=/<>_"
-    }
+    // The 16 px set is generated from the story text (tools/story_glyphs.py)
+    StoryGlyphs {}
     Text {
         visible: false
         font.pixelSize: 20
@@ -72,25 +68,92 @@ Rectangle {
         }
     }
 
+    // Upper window (V4+ split screen): one Text per grid row, rebound only
+    // when one of the row's cells changes
+    Rectangle {
+        id: upperWindow
+        anchors.top: statusBar.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        height: UpperWindow.rows > 0 ? UpperWindow.rows * UpperWindow.lineHeight + FizmoBackend.margin : 0
+        color: "#16213e"
+        clip: true
+
+        Repeater {
+            model: UpperWindow
+
+            delegate: Text {
+                x: FizmoBackend.margin
+                y: index * UpperWindow.lineHeight
+                visible: index < UpperWindow.rows
+                color: "#e8e8e8"
+                font.pixelSize: 16
+                text: model.version >= 0 ? UpperWindow.getRow(index) : ""
+            }
+        }
+    }
+
     // Main text output area
     Flickable {
         id: outputFlickable
-        anchors.top: statusBar.bottom
+        anchors.top: upperWindow.bottom
         anchors.left: parent.left
         anchors.right: parent.right
         anchors.bottom: inputArea.top
         anchors.margins: FizmoBackend.margin
         clip: true
         contentWidth: width
-        contentHeight: outputText.height
+        contentHeight: FizmoBackend.textGrid ? OutputLines.lineCount * OutputLines.lineHeight : outputText.height
 
         Text {
             id: outputText
             width: outputFlickable.width - 70  // Reserve right side for GUI icons
             color: "#00ff88"  // Classic green terminal color
             font.pixelSize: 16
-            wrapMode: Text.Wrap
-            text: root.outputVer >= 0 ? FizmoBackend.getOutputText() : ""
+            wrapMode: FizmoBackend.outputWrapped ? Text.NoWrap : Text.Wrap  // Interpreter wraps at DISPLAY_TEXT_COLUMNS
+            visible: !FizmoBackend.textGrid
+            text: !FizmoBackend.textGrid && root.outputVer >= 0 ? FizmoBackend.getOutputText() : ""
+        }
+
+        // Text grid: one unwrapped Text per OutputLines slot; only the slots
+        // the latest output touched rebind and re-shape
+        Item {
+            visible: FizmoBackend.textGrid
+
+            Repeater {
+                model: OutputLines
+
+                // One Text per style run; reverse video paints its own background
+                delegate: Item {
+                    id: gridLine
+                    property int slot: index
+                    property int version: model.version
+                    property int row: (index - OutputLines.head + OutputLines.capacity) % OutputLines.capacity
+                    y: row * OutputLines.lineHeight
+                    visible: row < OutputLines.lineCount
+
+                    Repeater {
+                        model: gridLine.version >= 0 ? OutputLines.getRunCount(gridLine.slot) : 0
+
+                        delegate: Rectangle {
+                            property int style: gridLine.version >= 0 ? OutputLines.getRunStyle(gridLine.slot, index) : 0
+                            x: OutputLines.getRunX(gridLine.slot, index)
+                            width: runText.width
+                            height: OutputLines.lineHeight
+                            color: (style & 1) != 0 ? "#00ff88" : "transparent"
+
+                            Text {
+                                id: runText
+                                color: (parent.style & 1) != 0 ? "#1a1a2e" : "#00ff88"
+                                font.pixelSize: 16
+                                font.bold: (parent.style & 2) != 0
+                                font.italic: (parent.style & 4) != 0
+                                text: gridLine.version >= 0 ? OutputLines.getRunText(gridLine.slot, index) : ""
+                            }
+                        }
+                    }
+                }
+            }
         }
     }
 
@@ -268,6 +331,73 @@ Rectangle {
         // Note: Full line input from external keyboard would need additional handling
     }
 
+    // Glyph priming only: a boot splash until the first output (or the story
+    // picker) appears, drawing the recorded glyph set in the splash colour
+    // so the font cache is warm before the first game text.
+    Rectangle {
+        id: bootSplash
+        anchors.fill: parent
+        color: "#1a1a2e"
+        visible: FizmoBackend.glyphPriming && root.outputVer == 0 && !FizmoBackend.choosingStory
+
+        Text {
+            anchors.centerIn: parent
+            color: "#e8e8e8"
+            font.pixelSize: 16
+            text: "Loading..."
+        }
+
+        Text {
+            width: parent.width
+            color: bootSplash.color
+            font.pixelSize: 16
+            wrapMode: Text.WrapAnywhere
+            text: FizmoBackend.getPrimingText()
+        }
+    }
+
+    // Story picker (embedded catalog or several ZORK_STORY_PATH entries)
+    Rectangle {
+        id: storyPicker
+        anchors.fill: parent
+        color: "#1a1a2e"
+        visible: FizmoBackend.choosingStory
+
+        Column {
+            anchors.centerIn: parent
+            spacing: FizmoBackend.margin * 2
+
+            Text {
+                anchors.horizontalCenter: parent.horizontalCenter
+                color: "#e8e8e8"
+                font.pixelSize: 16
+                text: "Choose a story"
+            }
+
+            Repeater {
+                model: FizmoBackend.storyCount
+
+                Rectangle {
+                    width: root.width / 2
+                    height: FizmoBackend.inputHeight
+                    color: "#0f3460"
+
+                    Text {
+                        anchors.centerIn: parent
+                        color: "#00ff88"
+                        font.pixelSize: 16
+                        text: FizmoBackend.getStoryName(index)
+                    }
+
+                    MouseArea {
+                        anchors.fill: parent
+                        onClicked: FizmoBackend.selectStory(index)
+                    }
+                }
+            }
+        }
+    }
+
     // Game over overlay
     Rectangle {
         id: gameOverOverlay
@@ -22,6 +22,10 @@
 extern "C" {
 #include "fizmo_filesys_hybrid.h"
 #include "sd_init.h"
+#include "posix_stubs.h"
+#ifdef FIZMO_TCM_PLACEMENT
+#include "itcm_placement.h"
+#endif
 }
 
 #include <qul/application.h>
@@ -36,7 +40,10 @@ extern "C" {
 #ifndef QUL_STACK_SIZE
 #define QUL_STACK_SIZE     (6144)       // Qt task stack (6KB) - in words on ARM
 #endif
+// Override with -DFIZMO_TASK_STACK_WORDS=<n>; fizmo_log_stack_usage() suggests a size
+#ifndef FIZMO_STACK_SIZE
 #define FIZMO_STACK_SIZE   (8192)       // Fizmo task stack (8KB) - in words on ARM
+#endif
 
 #define FIZMO_TASK_PRIORITY (configMAX_PRIORITIES - 1)  // 4 - highest valid
 #define QUL_TASK_PRIORITY   (configMAX_PRIORITIES - 2)  // 3 - one below Fizmo
@@ -44,41 +51,75 @@ extern "C" {
 static void Qul_Thread(void *argument);
 static void Fizmo_Thread(void *argument);
 
+#ifdef FIZMO_STATIC_ALLOCATION
+#if configSUPPORT_STATIC_ALLOCATION != 1
+#error "FIZMO_STATIC_ALLOCATION requires configSUPPORT_STATIC_ALLOCATION 1 in the platform's FreeRTOSConfig.h"
+#endif
+
+// Task stacks and control blocks live in .bss, sized at link time
+static StackType_t s_qulStack[QUL_STACK_SIZE];
+static StaticTask_t s_qulTcb;
+static StackType_t s_fizmoStack[FIZMO_STACK_SIZE];
+static StaticTask_t s_fizmoTcb;
+#endif
+
 int main()
 {
     // Initialize hardware and platform interfaces
     Qul::initHardware();
     Qul::initPlatform();
 
+#ifdef FIZMO_TCM_PLACEMENT
+    // Copy profile-selected interpreter functions to ITCM before anything runs them
+    size_t itcm_bytes = zork_itcm_init();
+    Qul::PlatformInterface::log("ZorkUI: %u bytes of interpreter code in ITCM\r\n", (unsigned)itcm_bytes);
+#endif
+
     // Initialize fizmo bridge (creates queues/semaphores)
     if (fizmo_bridge_init() != 0) {
         Qul::PlatformInterface::log("ERROR: Fizmo bridge init failed!\r\n");
         configASSERT(false);
     }
 
-    // Initialize hybrid filesystem with embedded story
+    // Initialize hybrid filesystem with embedded story (or story catalog)
     // Story is in flash, saves go to SD card under /saves directory
     // NOTE: SD card init/mount happens in Fizmo_Thread (requires scheduler running)
-    if (fizmo_filesys_hybrid_init(story_data_start, STORY_DATA_SIZE, "/saves") != 0) {
+    if (fizmo_filesys_hybrid_init(story_data_start, STORY_DATA_SIZE, SD_SAVES_DIR) != 0) {
         Qul::PlatformInterface::log("ERROR: Fizmo filesystem init failed!\r\n");
         configASSERT(false);
     }
 
     Qul::PlatformInterface::log("ZorkUI: Starting FreeRTOS tasks...\r\n");
 
+    TaskHandle_t qulTask = NULL;
+    TaskHandle_t fizmoTask = NULL;
+
+#ifdef FIZMO_STATIC_ALLOCATION
+    // Static tasks: no heap involved, creation cannot fail
+    qulTask = xTaskCreateStatic(Qul_Thread, "Qul_Thread", QUL_STACK_SIZE,
+                                NULL, QUL_TASK_PRIORITY, s_qulStack, &s_qulTcb);
+    fizmoTask = xTaskCreateStatic(Fizmo_Thread, "Fizmo_Thread", FIZMO_STACK_SIZE,
+                                  NULL, FIZMO_TASK_PRIORITY, s_fizmoStack, &s_fizmoTcb);
+#else
     // Create Qt UI task (higher priority for responsive UI)
     if (xTaskCreate(Qul_Thread, "Qul_Thread", QUL_STACK_SIZE,
-                    NULL, QUL_TASK_PRIORITY, NULL) != pdPASS) {
+                    NULL, QUL_TASK_PRIORITY, &qulTask) != pdPASS) {
         Qul::PlatformInterface::log("ERROR: Qt task creation failed!\r\n");
         configASSERT(false);
     }
 
     // Create fizmo interpreter task (lower priority, can be preempted by UI)
     if (xTaskCreate(Fizmo_Thread, "Fizmo_Thread", FIZMO_STACK_SIZE,
-                    NULL, FIZMO_TASK_PRIORITY, NULL) != pdPASS) {
+                    NULL, FIZMO_TASK_PRIORITY, &fizmoTask) != pdPASS) {
         Qul::PlatformInterface::log("ERROR: Fizmo task creation failed!\r\n");
         configASSERT(false);
     }
+#endif
+
+    // Registered before the scheduler starts; the bridge reads the kernel's
+    // high-water marks whenever usage is queried
+    fizmo_stack_monitor_add(qulTask, "Qul_Thread", QUL_STACK_SIZE * sizeof(StackType_t));
+    fizmo_stack_monitor_add(fizmoTask, "Fizmo_Thread", FIZMO_STACK_SIZE * sizeof(StackType_t));
 
     Qul::PlatformInterface::log("ZorkUI: Starting FreeRTOS scheduler...\r\n");
 
@@ -116,24 +157,31 @@ static void Fizmo_Thread(void *argument)
     (void)argument;
 
     // Initialize SD card for save/restore (must happen after scheduler starts)
+    // sd_init.c owns the single FatFS mount and creates the saves directory
     int sd_ret = sd_filesystem_init();
     if (sd_ret == 0) {
-        fizmo_filesys_mount_sd();
         fizmo_load_saved_filename();  // Restore last used filename from SD
     }
     // Continue anyway if SD init fails - game works without save/restore
 
-    Qul::PlatformInterface::log("Fizmo_Thread: Starting interpreter...\r\n");
+    // With a story catalog, wait for the UI picker; a single story starts at once
+    int result = -1;
+    if (fizmo_bridge_choose_story() >= 0) {
+        Qul::PlatformInterface::log("Fizmo_Thread: Starting interpreter...\r\n");
 
-    // Start the Z-machine interpreter
-    // This blocks until the game ends or an error occurs
-    int result = fizmo_bridge_run(story_data_start, STORY_DATA_SIZE);
+        // Start the Z-machine interpreter
+        // This blocks until the game ends or an error occurs
+        result = fizmo_bridge_run(story_data_start, STORY_DATA_SIZE);
+    }
 
     if (result == 0) {
         Qul::PlatformInterface::log("Fizmo_Thread: Game ended normally\r\n");
     } else {
         Qul::PlatformInterface::log("Fizmo_Thread: Interpreter error!\r\n");
     }
+    posix_heap_log_stats();
+    fizmo_log_heap_snapshot();
+    fizmo_log_stack_usage();
 
     // Task ends here - could implement restart logic if needed
     vTaskDelete(NULL);
@@ -157,10 +205,53 @@ void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
     configASSERT(false);
 }
 
+#ifdef FIZMO_STATIC_ALLOCATION
+// With configSUPPORT_STATIC_ALLOCATION the kernel asks the application for
+// the idle (and timer service) task memory instead of allocating it
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+    static StaticTask_t idleTcb;
+    static StackType_t idleStack[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &idleTcb;
+    *ppxIdleTaskStackBuffer = idleStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+#if configUSE_TIMERS
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+    static StaticTask_t timerTcb;
+    static StackType_t timerStack[configTIMER_TASK_STACK_DEPTH];
+
+    *ppxTimerTaskTCBBuffer = &timerTcb;
+    *ppxTimerTaskStackBuffer = timerStack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+#endif
+
 void vApplicationMallocFailedHook(void)
 {
     Qul::PlatformInterface::log("FATAL: Malloc failed - out of heap memory!\r\n");
 
+#ifdef FIZMO_HEAP_TELEMETRY
+    // Who ate the heap, and which request tipped it over (the wrapper noted
+    // it before calling pvPortMalloc). heap_telemetry_log formats integers
+    // with snprintf into a stack buffer and never allocates.
+    heap_telemetry_snapshot_t snapshot;
+    if (heap_telemetry_capture(&snapshot)) {
+        heap_telemetry_log(&snapshot, [](const char *line) {
+            Qul::PlatformInterface::log(line);
+            Qul::PlatformInterface::log("\r\n");
+        });
+    }
+#endif
+
     // Halt execution
     configASSERT(false);
 }